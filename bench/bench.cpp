@@ -0,0 +1,647 @@
+/**
+ * @file bench.cpp
+ * @author DrkWithT
+ * @brief Implements the front-end benchmark runner: throughput, allocations, and each case's peak memory over generated corpora.
+ * @date 2024-05-03
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ast/context.hpp"
+#include "ast/symbols.hpp"
+#include "frontend/lexer.hpp"
+#include "frontend/chunklexer.hpp"
+#include "frontend/parser.hpp"
+#include "frontend/tokenstream.hpp"
+#include "backend/compiler.hpp"
+#include "runtime/vm.hpp"
+#include "corpus.hpp"
+#include "workloads.hpp"
+
+/* Allocation counting: every global new in the process bumps this. */
+
+static std::atomic<size_t> alloc_count {0};
+
+void* operator new(size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* block = std::malloc((size > 0) ? size : 1); block != nullptr)
+        return block;
+
+    throw std::bad_alloc {};
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, [[maybe_unused]] size_t size) noexcept
+{
+    std::free(block);
+}
+
+namespace tisp::bench
+{
+    struct BenchCase
+    {
+        std::string_view name;
+        size_t (*run)(std::string_view source); // returns the processed token count
+    };
+
+    struct BenchResult
+    {
+        std::string name;
+        size_t bytes;
+        size_t tokens;
+        double tokens_per_sec;
+        double mb_per_sec;
+        double allocs_per_token;
+        size_t peak_rss_kb; // of the child process that ran only this case
+    };
+
+    /// @brief What the results were measured with. Numbers from a -Og build or another compiler say nothing about an -O2 one.
+    struct BuildInfo
+    {
+        bool debug_mode;
+        std::string compiler;
+        unsigned hardware_threads;
+    };
+
+    static BuildInfo currentBuild()
+    {
+        return {
+            .debug_mode = TISP_BENCH_DEBUG_MODE != 0,
+            .compiler = TISP_BENCH_COMPILER,
+            .hardware_threads = std::thread::hardware_concurrency()
+        };
+    }
+
+    struct BenchConfig
+    {
+        std::vector<size_t> sizes {1 << 10, 64 << 10, 1 << 20, 16 << 20};
+        std::vector<std::string> case_names {};
+        std::string json_path {};
+        std::string baseline_path {};
+        double tolerance = 0.10;
+        double min_seconds = 0.25;
+        bool run_vm = false;
+    };
+
+    /* Cases */
+
+    static size_t runLex(std::string_view source)
+    {
+        frontend::Lexer lexer {};
+
+        return lexer.tokenizeSource(source).size();
+    }
+
+    static size_t runLexSkipTrivia(std::string_view source)
+    {
+        frontend::Lexer lexer {};
+
+        return lexer.tokenizeSource(source, frontend::TriviaMode::skip).size();
+    }
+
+    static size_t runLexIntern(std::string_view source)
+    {
+        ast::SymbolTable symbols {};
+        frontend::Lexer lexer {&symbols};
+
+        return lexer.tokenizeSource(source, frontend::TriviaMode::skip).size();
+    }
+
+    static size_t runLexParallel(std::string_view source)
+    {
+        return frontend::tokenizeSourceParallel(source).size();
+    }
+
+    static size_t runStream(std::string_view source)
+    {
+        frontend::TokenStream stream {source};
+        size_t count = 1;
+
+        while (stream.next().type != frontend::TokenType::eof)
+            count++;
+
+        return count;
+    }
+
+    /// @brief The whole front end: streamed lexing with interning, then parsing into a fresh AstContext.
+    static size_t runParse(std::string_view source)
+    {
+        ast::AstContext context {};
+        ast::SymbolTable symbols {};
+        frontend::Parser parser {source, context, symbols};
+
+        static_cast<void>(parser.parseModule());
+
+        return parser.getTokenCount();
+    }
+
+    static constexpr BenchCase cases[] {
+        {"lex", runLex},
+        {"lex_skip", runLexSkipTrivia},
+        {"lex_intern", runLexIntern},
+        {"lex_parallel", runLexParallel},
+        {"stream", runStream},
+        {"parse", runParse}
+    };
+
+    /* Measurement */
+
+    static size_t peakRssKb()
+    {
+        rusage usage {};
+
+        getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+        return static_cast<size_t>(usage.ru_maxrss);
+#endif
+    }
+
+    static BenchResult measure(const BenchCase& bench_case, std::string_view source, double min_seconds)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        size_t allocs_before = alloc_count.load();
+        size_t tokens = bench_case.run(source);
+        size_t allocs = alloc_count.load() - allocs_before;
+
+        size_t runs = 0;
+        auto start = Clock::now();
+        double elapsed = 0.0;
+
+        do
+        {
+            [[maybe_unused]] volatile size_t sink = bench_case.run(source);
+            runs++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < min_seconds);
+
+        double per_run = elapsed / static_cast<double>(runs);
+
+        return {
+            .name = std::string {bench_case.name},
+            .bytes = source.length(),
+            .tokens = tokens,
+            .tokens_per_sec = static_cast<double>(tokens) / per_run,
+            .mb_per_sec = static_cast<double>(source.length()) / per_run / 1e6,
+            .allocs_per_token = static_cast<double>(allocs) / static_cast<double>(tokens),
+            .peak_rss_kb = peakRssKb()
+        };
+    }
+
+    /// @brief What a measuring child sends back through its pipe: a BenchResult without the strings.
+    struct ChildReport
+    {
+        size_t tokens;
+        double tokens_per_sec;
+        double mb_per_sec;
+        double allocs_per_token;
+        size_t peak_rss_kb;
+    };
+
+    /**
+     * @brief Runs measure in a forked child and reads its results back. Returns false if the child could not start or did not report.
+     * @note ru_maxrss only ever grows, so measuring every case in one process would report the biggest case so far. A forked child's peak starts from the RSS it forks with, which holds the corpus but nothing earlier cases allocated.
+     */
+    static bool measureInChild(const BenchCase& bench_case, std::string_view source, double min_seconds, BenchResult& result)
+    {
+        int fds[2];
+
+        if (pipe(fds) != 0)
+            return false;
+
+        pid_t child = fork();
+
+        if (child < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+
+        if (child == 0)
+        {
+            close(fds[0]);
+
+            BenchResult measured = measure(bench_case, source, min_seconds);
+            ChildReport report {
+                .tokens = measured.tokens,
+                .tokens_per_sec = measured.tokens_per_sec,
+                .mb_per_sec = measured.mb_per_sec,
+                .allocs_per_token = measured.allocs_per_token,
+                .peak_rss_kb = measured.peak_rss_kb
+            };
+            bool sent = write(fds[1], &report, sizeof(report)) == static_cast<ssize_t>(sizeof(report));
+
+            // _exit skips the atexit handlers and stdio buffers the child shares with its parent.
+            _exit(sent ? 0 : 1);
+        }
+
+        close(fds[1]);
+
+        ChildReport report {};
+        ssize_t received = read(fds[0], &report, sizeof(report));
+        int status = 0;
+
+        close(fds[0]);
+        waitpid(child, &status, 0);
+
+        if (received != static_cast<ssize_t>(sizeof(report)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            return false;
+
+        result = {
+            .name = std::string {bench_case.name},
+            .bytes = source.length(),
+            .tokens = report.tokens,
+            .tokens_per_sec = report.tokens_per_sec,
+            .mb_per_sec = report.mb_per_sec,
+            .allocs_per_token = report.allocs_per_token,
+            .peak_rss_kb = report.peak_rss_kb
+        };
+
+        return true;
+    }
+
+    /// @brief Compiles a workload once, then times whole runs of its main. Returns false if it does not compile or run, or main returns anything but workload.result.
+    static bool measureWorkload(const Workload& workload, runtime::DispatchMode mode, double min_seconds, double& ns_per_iteration)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        ast::SymbolTable symbols {};
+        ast::AstContext context {};
+        frontend::Parser parser {workload.source, context, symbols};
+        ast::StmtList module = parser.parseModule();
+        backend::Compiler compiler {symbols};
+        runtime::Program program = compiler.compile(module);
+
+        if (!parser.getErrors().empty() || !compiler.getErrors().empty())
+            return false;
+
+        std::ostream sink {nullptr};
+        runtime::Vm vm {sink};
+        auto start = Clock::now();
+        double elapsed = 0.0;
+        size_t runs = 0;
+
+        do
+        {
+            if (vm.run(program, mode) != runtime::ExecStatus::ok)
+                return false;
+
+            if (runtime::Value result = vm.getResult(); !result.isInteger() || result.asInteger() != workload.result)
+                return false;
+
+            runs++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < min_seconds);
+
+        ns_per_iteration = elapsed * 1e9 / static_cast<double>(runs * workload.iterations);
+
+        return true;
+    }
+
+    /* Reporting */
+
+    static std::string toJsonLine(const BenchResult& result)
+    {
+        std::ostringstream sout {};
+
+        sout << std::setprecision(6)
+             << "{\"case\": \"" << result.name << "\", \"bytes\": " << result.bytes << ", \"tokens\": " << result.tokens
+             << ", \"tokens_per_sec\": " << result.tokens_per_sec << ", \"mb_per_sec\": " << result.mb_per_sec
+             << ", \"allocs_per_token\": " << result.allocs_per_token << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}";
+
+        return sout.str();
+    }
+
+    static std::string toJsonLine(const BuildInfo& build)
+    {
+        std::ostringstream sout {};
+
+        sout << "{\"use_debug_mode\": " << (build.debug_mode ? "true" : "false") << ", \"compiler\": \"" << build.compiler
+             << "\", \"hardware_threads\": " << build.hardware_threads << "}";
+
+        return sout.str();
+    }
+
+    static bool writeJson(const std::string& path, const std::vector<BenchResult>& results)
+    {
+        std::ofstream writer {path};
+
+        if (!writer.is_open())
+            return false;
+
+        writer << "{\n  \"build\": " << toJsonLine(currentBuild()) << ",\n  \"results\": [\n";
+
+        for (size_t result_pos = 0; result_pos < results.size(); result_pos++)
+            writer << "    " << toJsonLine(results[result_pos]) << ((result_pos + 1 < results.size()) ? ",\n" : "\n");
+
+        writer << "  ]\n}\n";
+
+        return writer.good();
+    }
+
+    /// @brief Reads a field from one result line as written by toJsonLine.
+    static std::string jsonField(const std::string& line, std::string_view key)
+    {
+        std::string pattern = "\"" + std::string {key} + "\": ";
+        size_t at = line.find(pattern);
+
+        if (at == std::string::npos)
+            return {};
+
+        at += pattern.length();
+
+        if (line[at] == '\"')
+            return line.substr(at + 1, line.find('\"', at + 1) - at - 1);
+
+        return line.substr(at, line.find_first_of(",}", at) - at);
+    }
+
+    /// @brief Reads the results of a baseline file and, when it has one, its build line into build. Returns no results if the file has none.
+    static std::vector<BenchResult> readBaseline(const std::string& path, bool& has_build, BuildInfo& build)
+    {
+        std::ifstream reader {path};
+        std::vector<BenchResult> results {};
+        std::string line;
+
+        has_build = false;
+
+        while (std::getline(reader, line))
+        {
+            if (line.find("\"use_debug_mode\"") != std::string::npos)
+            {
+                has_build = true;
+                build = {
+                    .debug_mode = jsonField(line, "use_debug_mode") == "true",
+                    .compiler = jsonField(line, "compiler"),
+                    .hardware_threads = static_cast<unsigned>(std::stoul(jsonField(line, "hardware_threads")))
+                };
+                continue;
+            }
+
+            if (line.find("\"case\"") == std::string::npos)
+                continue;
+
+            results.push_back({
+                .name = jsonField(line, "case"),
+                .bytes = std::stoull(jsonField(line, "bytes")),
+                .tokens = std::stoull(jsonField(line, "tokens")),
+                .tokens_per_sec = std::stod(jsonField(line, "tokens_per_sec")),
+                .mb_per_sec = std::stod(jsonField(line, "mb_per_sec")),
+                .allocs_per_token = std::stod(jsonField(line, "allocs_per_token")),
+                .peak_rss_kb = std::stoull(jsonField(line, "peak_rss_kb"))
+            });
+        }
+
+        return results;
+    }
+
+    /// @brief Whether results of build can be held against a baseline recorded with old. Differing machines only get a warning, since the baseline owner may know they match.
+    static bool checkSameBuild(const BuildInfo& build, const BuildInfo& old)
+    {
+        if (build.debug_mode != old.debug_mode || build.compiler != old.compiler)
+        {
+            std::cerr << "bench: baseline was recorded with USE_DEBUG_MODE=" << (old.debug_mode ? "ON" : "OFF") << " and " << old.compiler
+                      << ", but this build has USE_DEBUG_MODE=" << (build.debug_mode ? "ON" : "OFF") << " and " << build.compiler << '\n';
+            return false;
+        }
+
+        if (build.hardware_threads != old.hardware_threads)
+        {
+            std::cerr << "bench: warning: baseline was recorded with " << old.hardware_threads << " hardware threads, this machine has "
+                      << build.hardware_threads << '\n';
+        }
+
+        return true;
+    }
+
+    /// @brief Counts results that got slower or allocate more than the baseline allows.
+    static int compareBaseline(const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline, double tolerance)
+    {
+        int regressions = 0;
+
+        for (const auto& result : results)
+        {
+            for (const auto& old : baseline)
+            {
+                if (old.name != result.name || old.bytes != result.bytes)
+                    continue;
+
+                bool slower = result.mb_per_sec < old.mb_per_sec * (1.0 - tolerance);
+                bool hungrier = result.allocs_per_token > old.allocs_per_token * (1.0 + tolerance) + 1e-9;
+
+                if (slower || hungrier)
+                {
+                    std::cout << "REGRESSION " << result.name << " @ " << result.bytes << " bytes: "
+                              << old.mb_per_sec << " -> " << result.mb_per_sec << " MB/s, "
+                              << old.allocs_per_token << " -> " << result.allocs_per_token << " allocs/token\n";
+                    regressions++;
+                }
+            }
+        }
+
+        return regressions;
+    }
+
+    static bool wantsCase(const BenchConfig& config, std::string_view name)
+    {
+        if (config.case_names.empty())
+            return true;
+
+        for (const auto& wanted : config.case_names)
+        {
+            if (wanted == name)
+                return true;
+        }
+
+        return false;
+    }
+
+    static std::vector<std::string> splitList(const std::string& text)
+    {
+        std::vector<std::string> items {};
+        std::istringstream sin {text};
+        std::string item;
+
+        while (std::getline(sin, item, ','))
+        {
+            if (!item.empty())
+                items.push_back(item);
+        }
+
+        return items;
+    }
+
+    static bool parseArgs(int argc, char* argv[], BenchConfig& config)
+    {
+        for (int arg_pos = 1; arg_pos < argc; arg_pos++)
+        {
+            std::string arg {argv[arg_pos]};
+            bool has_value = arg_pos + 1 < argc;
+
+            if (arg == "--sizes" && has_value)
+            {
+                config.sizes.clear();
+
+                for (const auto& size_text : splitList(argv[++arg_pos]))
+                    config.sizes.push_back(parseByteSize(size_text));
+            }
+            else if (arg == "--cases" && has_value)
+                config.case_names = splitList(argv[++arg_pos]);
+            else if (arg == "--json" && has_value)
+                config.json_path = argv[++arg_pos];
+            else if (arg == "--baseline" && has_value)
+                config.baseline_path = argv[++arg_pos];
+            else if (arg == "--tolerance" && has_value)
+                config.tolerance = std::stod(argv[++arg_pos]);
+            else if (arg == "--min-time" && has_value)
+                config.min_seconds = std::stod(argv[++arg_pos]);
+            else if (arg == "--vm")
+                config.run_vm = true;
+            else
+                return false;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace tisp::bench;
+
+    BenchConfig config {};
+
+    if (!parseArgs(argc, argv, config))
+    {
+        std::cerr << "usage: ./bench [--sizes 1K,64K,1M,16M,1G] [--cases lex,lex_skip,lex_intern,lex_parallel,stream,parse] [--json <out>] [--baseline <file>] [--tolerance 0.10] [--min-time 0.25]\n"
+                  << "       ./bench --vm [--cases seq_loop,typed_seq_loop,seq_sum,parallel_map,factorial,fib,generic,arith,deep_recursion,match_dispatch] [--min-time 0.25]\n";
+        return 1;
+    }
+
+    if (config.run_vm)
+    {
+        // Builds with computed goto have both dispatch loops, so one binary can compare them.
+        if (!tisp::runtime::has_threaded_dispatch)
+        {
+            std::cerr << "bench: this build has only the switch dispatch loop, configure with -DUSE_COMPUTED_GOTO=ON to compare\n";
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(14) << "case" << std::right << std::setw(14) << "iterations" << std::setw(16) << "switch ns/it"
+                  << std::setw(16) << "threaded ns/it" << std::setw(10) << "speedup" << '\n';
+
+        for (const auto& workload : vmWorkloads())
+        {
+            if (!wantsCase(config, workload.name))
+                continue;
+
+            double switch_ns = 0.0;
+            double threaded_ns = 0.0;
+
+            if (!measureWorkload(workload, tisp::runtime::DispatchMode::switch_loop, config.min_seconds, switch_ns)
+                || !measureWorkload(workload, tisp::runtime::DispatchMode::threaded, config.min_seconds, threaded_ns))
+            {
+                std::cerr << "bench: workload " << workload.name << " failed to compile, run, or return its expected result\n";
+                return 1;
+            }
+
+            std::cout << std::left << std::setw(14) << workload.name << std::right << std::setw(14) << workload.iterations
+                      << std::fixed << std::setprecision(2) << std::setw(16) << switch_ns << std::setw(16) << threaded_ns
+                      << std::setw(9) << switch_ns / threaded_ns << "x\n";
+        }
+
+        return 0;
+    }
+
+    std::vector<BenchResult> results {};
+
+    std::cout << std::left << std::setw(14) << "case" << std::right << std::setw(12) << "bytes" << std::setw(12) << "tokens"
+              << std::setw(14) << "Mtok/s" << std::setw(12) << "MB/s" << std::setw(14) << "allocs/tok" << std::setw(14) << "case peak KB" << '\n';
+
+    for (size_t size : config.sizes)
+    {
+        std::string corpus = generateCorpus(size, static_cast<uint32_t>(size));
+
+        // Trim back to the requested size so results line up with the baseline.
+        corpus.resize(size);
+
+        for (const auto& bench_case : cases)
+        {
+            if (!wantsCase(config, bench_case.name))
+                continue;
+
+            BenchResult result {};
+
+            if (!measureInChild(bench_case, corpus, config.min_seconds, result))
+            {
+                std::cerr << "bench: case " << bench_case.name << " failed in its child process\n";
+                return 1;
+            }
+
+            std::cout << std::left << std::setw(14) << result.name << std::right << std::setw(12) << result.bytes << std::setw(12) << result.tokens
+                      << std::fixed << std::setprecision(2) << std::setw(14) << result.tokens_per_sec / 1e6 << std::setw(12) << result.mb_per_sec
+                      << std::setprecision(4) << std::setw(14) << result.allocs_per_token << std::setw(14) << result.peak_rss_kb << '\n';
+
+            results.push_back(result);
+        }
+    }
+
+    if (!config.json_path.empty() && !writeJson(config.json_path, results))
+    {
+        std::cerr << "bench: could not write " << config.json_path << '\n';
+        return 1;
+    }
+
+    if (!config.baseline_path.empty())
+    {
+        bool has_build = false;
+        BuildInfo baseline_build {};
+        std::vector<BenchResult> baseline = readBaseline(config.baseline_path, has_build, baseline_build);
+
+        if (baseline.empty())
+        {
+            std::cerr << "bench: no results in baseline " << config.baseline_path << '\n';
+            return 1;
+        }
+
+        if (!has_build)
+        {
+            std::cerr << "bench: baseline " << config.baseline_path << " does not say which build recorded it, re-record it with --json\n";
+            return 1;
+        }
+
+        if (!checkSameBuild(currentBuild(), baseline_build))
+            return 1;
+
+        if (compareBaseline(results, baseline, config.tolerance) > 0)
+            return 1;
+
+        std::cout << "No regressions against " << config.baseline_path << '\n';
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file corpus.cpp
+ * @author DrkWithT
+ * @brief Implements the synthetic benchmark corpus generator.
+ * @date 2024-05-03
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cctype>
+#include <random>
+#include <string_view>
+#include "corpus.hpp"
+
+namespace tisp::bench
+{
+    /*
+     * Block templates lifted from testprogs. "~" marks where a unique name suffix goes and "%" where a random integer goes. Suffixes only use letters because digits would end an identifier.
+     */
+
+    static constexpr std::string_view header_block = "# generated benchmark module #\n\nuse io.print\n\n";
+
+    static constexpr std::string_view blocks[] {
+        // test00
+        "# Tisp hello world ~ #\n"
+        "\n"
+        "defun hello~() -> Integer {\n"
+        "    $(print \"Hello World ~\")\n"
+        "    return %\n"
+        "}\n\n",
+
+        // test01
+        "const nums~ : Seq [%, %, %, %]\n"
+        "\n"
+        "defun accumulateSeq~ (arg : Seq) -> Integer {\n"
+        "    var sum : Integer 0\n"
+        "    var pos : Integer 0\n"
+        "    const len : Integer @(nums~ length)\n"
+        "\n"
+        "    while pos < len {\n"
+        "        sum = sum + @(arg pos)\n"
+        "        pos = pos + 1\n"
+        "    }\n"
+        "\n"
+        "    return sum\n"
+        "}\n\n",
+
+        // test02
+        "defun doFactorial~ (n : Integer) -> Integer {\n"
+        "    match n {\n"
+        "        case n <= 1 {\n"
+        "            return 1\n"
+        "        }\n"
+        "        default {\n"
+        "            return n * $(doFactorial~ (n - 1))\n"
+        "        }\n"
+        "    }\n"
+        "}\n\n",
+
+        // test03
+        "generic (N)\n"
+        "defun addAny~ (x:N y:N) -> N {\n"
+        "    return x + y\n"
+        "}\n"
+        "\n"
+        "defun useAny~ () -> Integer {\n"
+        "    $(print $(addAny~(Integer) % %.5))\n"
+        "    return 0\n"
+        "}\n\n"
+    };
+
+    static void appendSuffix(std::string& out, size_t serial)
+    {
+        out.push_back('X');
+
+        do
+        {
+            out.push_back(static_cast<char>('a' + serial % 26));
+            serial /= 26;
+        } while (serial > 0);
+    }
+
+    std::string generateCorpus(size_t target_length, uint32_t seed)
+    {
+        std::mt19937 rng {seed};
+        std::uniform_int_distribution<int> numbers {0, 99999};
+        std::string out {};
+        size_t serial = 0;
+
+        out.reserve(target_length + 512);
+        out.append(header_block);
+
+        while (out.length() < target_length)
+        {
+            for (const char c : blocks[serial % std::size(blocks)])
+            {
+                if (c == '~')
+                    appendSuffix(out, serial);
+                else if (c == '%')
+                    out.append(std::to_string(numbers(rng)));
+                else
+                    out.push_back(c);
+            }
+
+            serial++;
+        }
+
+        return out;
+    }
+
+    size_t parseByteSize(const std::string& text)
+    {
+        size_t digits_end = 0;
+
+        while (digits_end < text.length() && std::isdigit(static_cast<unsigned char>(text[digits_end])))
+            digits_end++;
+
+        if (digits_end == 0)
+            return 0;
+
+        size_t value = std::stoull(text.substr(0, digits_end));
+        char unit = (digits_end < text.length()) ? static_cast<char>(std::toupper(static_cast<unsigned char>(text[digits_end]))) : 'B';
+
+        switch (unit)
+        {
+            case 'K':
+                return value << 10;
+            case 'M':
+                return value << 20;
+            case 'G':
+                return value << 30;
+            default:
+                return value;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace tisp::bench
+{
+    /**
+     * @brief Builds a synthetic Tisp module of at least target_length bytes by repeating the constructs of the testprogs scripts (comments, imports, sequences, loops, matches, recursion, generics) under fresh names.
+     *
+     * @param seed Varies the literals so repeated blocks do not lex identically.
+     */
+    [[nodiscard]] std::string generateCorpus(size_t target_length, uint32_t seed);
+
+    /// @brief Parses sizes like "512", "64K", "16M" or "1G".
+    [[nodiscard]] size_t parseByteSize(const std::string& text);
+}
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file workloads.cpp
+ * @author DrkWithT
+ * @brief Implements the VM benchmark programs.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "workloads.hpp"
+
+namespace tisp::bench
+{
+    // test01: sums a 16 item Seq 10000 times.
+    static constexpr std::string_view seq_loop_source =
+        "const nums : Seq [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16]\n"
+        "\n"
+        "defun accumulateSeq (arg : Seq) -> Integer {\n"
+        "    var sum : Integer 0\n"
+        "    var pos : Integer 0\n"
+        "    const len : Integer @(arg length)\n"
+        "\n"
+        "    while pos < len {\n"
+        "        sum = sum + @(arg pos)\n"
+        "        pos = pos + 1\n"
+        "    }\n"
+        "\n"
+        "    return sum\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var total : Integer 0\n"
+        "\n"
+        "    while round < 10000 {\n"
+        "        total = total + $(accumulateSeq nums)\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return total\n"
+        "}\n";
+
+    // test01's loop over a const Seq the compiler can type, so it reads the unboxed items with index_i64.
+    static constexpr std::string_view typed_seq_loop_source =
+        "const nums : Seq [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16]\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var total : Integer 0\n"
+        "\n"
+        "    while round < 10000 {\n"
+        "        var pos : Integer 0\n"
+        "\n"
+        "        while pos < 16 {\n"
+        "            total = total + @(nums pos)\n"
+        "            pos = pos + 1\n"
+        "        }\n"
+        "\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return total\n"
+        "}\n";
+
+    // test01's reduction done by the seq.sum builtin, which adds the unboxed items with SIMD kernels.
+    static constexpr std::string_view seq_sum_source =
+        "use seq.sum\n"
+        "\n"
+        "const nums : Seq [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16]\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var total : Integer 0\n"
+        "\n"
+        "    while round < 10000 {\n"
+        "        total = total + $(sum nums)\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return total\n"
+        "}\n";
+
+    // A pure defun mapped over a 65536 item Seq by parallel.parallelMap, split across the worker VMs.
+    static constexpr std::string_view parallel_map_source =
+        "use seq.range\n"
+        "use seq.sum\n"
+        "use parallel.parallelMap\n"
+        "\n"
+        "defun square (n : Integer) -> Integer {\n"
+        "    return n * n\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    const squares : Seq $(parallelMap square $(range 65536))\n"
+        "\n"
+        "    return $(sum squares)\n"
+        "}\n";
+
+    // test02: 20 deep factorial recursion 10000 times. 20! wraps at 48 bits.
+    static constexpr std::string_view factorial_source =
+        "defun doFactorial (n : Integer) -> Integer {\n"
+        "    match n {\n"
+        "        case n <= 1 {\n"
+        "            return 1\n"
+        "        }\n"
+        "        default {\n"
+        "            return n * $(doFactorial (n - 1))\n"
+        "        }\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var result : Integer 0\n"
+        "\n"
+        "    while round < 10000 {\n"
+        "        result = $(doFactorial 20)\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return result\n"
+        "}\n";
+
+    // Call heavy: fib(25) makes 242785 calls.
+    static constexpr std::string_view fib_source =
+        "defun fib (n : Integer) -> Integer {\n"
+        "    match n {\n"
+        "        case n < 2 {\n"
+        "            return n\n"
+        "        }\n"
+        "        default {\n"
+        "            return $(fib n - 1) + $(fib n - 2)\n"
+        "        }\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    const result : Integer $(fib 25)\n"
+        "    return result\n"
+        "}\n";
+
+    // test03: a generic call in a loop.
+    static constexpr std::string_view generic_source =
+        "generic (N)\n"
+        "defun addAny (x:N y:N) -> N {\n"
+        "    return x + y\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var total : Integer 0\n"
+        "\n"
+        "    while round < 100000 {\n"
+        "        total = $(addAny(Integer) total round)\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return total\n"
+        "}\n";
+
+    // Typed arithmetic: Integer and Double operators on locals, with no calls or Seq reads.
+    static constexpr std::string_view arith_source =
+        "defun main () -> Integer {\n"
+        "    var i : Integer 0\n"
+        "    var acc : Integer 0\n"
+        "    var x : Double 0.0\n"
+        "\n"
+        "    while i < 100000 {\n"
+        "        acc = acc * 3 + i - acc / 7\n"
+        "        x = x * 0.5 + 1.25\n"
+        "        i = i + 1\n"
+        "    }\n"
+        "\n"
+        "    return acc\n"
+        "}\n";
+
+    // Mutual tail recursion 1000000 calls deep, past the VM's 262144 register stack, so it only finishes if tail calls run in constant stack space.
+    static constexpr std::string_view deep_recursion_source =
+        "defun sumEven (n : Integer acc : Integer) -> Integer {\n"
+        "    match n {\n"
+        "        case n == 0 {\n"
+        "            return acc\n"
+        "        }\n"
+        "        default {\n"
+        "            return $(sumOdd (n - 1) (acc + n))\n"
+        "        }\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "defun sumOdd (n : Integer acc : Integer) -> Integer {\n"
+        "    return $(sumEven (n - 1) (acc + n))\n"
+        "}\n"
+        "\n"
+        "defun main () -> Integer {\n"
+        "    const result : Integer $(sumEven 1000000 0)\n"
+        "    return result\n"
+        "}\n";
+
+    // A 24 state machine stepped by a match in the loop, so its dispatch dominates. Each step adds 7 mod 24, which visits every state.
+    static constexpr std::string_view match_dispatch_source =
+        "defun main () -> Integer {\n"
+        "    var round : Integer 0\n"
+        "    var state : Integer 0\n"
+        "    var total : Integer 0\n"
+        "\n"
+        "    while round < 100000 {\n"
+        "        match state {\n"
+        "            case state == 0 {\n"
+        "                state = 7\n"
+        "            }\n"
+        "            case state == 1 {\n"
+        "                state = 8\n"
+        "            }\n"
+        "            case state == 2 {\n"
+        "                state = 9\n"
+        "            }\n"
+        "            case state == 3 {\n"
+        "                state = 10\n"
+        "            }\n"
+        "            case state == 4 {\n"
+        "                state = 11\n"
+        "            }\n"
+        "            case state == 5 {\n"
+        "                state = 12\n"
+        "            }\n"
+        "            case state == 6 {\n"
+        "                state = 13\n"
+        "            }\n"
+        "            case state == 7 {\n"
+        "                state = 14\n"
+        "            }\n"
+        "            case state == 8 {\n"
+        "                state = 15\n"
+        "            }\n"
+        "            case state == 9 {\n"
+        "                state = 16\n"
+        "            }\n"
+        "            case state == 10 {\n"
+        "                state = 17\n"
+        "            }\n"
+        "            case state == 11 {\n"
+        "                state = 18\n"
+        "            }\n"
+        "            case state == 12 {\n"
+        "                state = 19\n"
+        "            }\n"
+        "            case state == 13 {\n"
+        "                state = 20\n"
+        "            }\n"
+        "            case state == 14 {\n"
+        "                state = 21\n"
+        "            }\n"
+        "            case state == 15 {\n"
+        "                state = 22\n"
+        "            }\n"
+        "            case state == 16 {\n"
+        "                state = 23\n"
+        "            }\n"
+        "            case state == 17 {\n"
+        "                state = 0\n"
+        "            }\n"
+        "            case state == 18 {\n"
+        "                state = 1\n"
+        "            }\n"
+        "            case state == 19 {\n"
+        "                state = 2\n"
+        "            }\n"
+        "            case state == 20 {\n"
+        "                state = 3\n"
+        "            }\n"
+        "            case state == 21 {\n"
+        "                state = 4\n"
+        "            }\n"
+        "            case state == 22 {\n"
+        "                state = 5\n"
+        "            }\n"
+        "            case state == 23 {\n"
+        "                state = 6\n"
+        "            }\n"
+        "            default {\n"
+        "                state = 0\n"
+        "            }\n"
+        "        }\n"
+        "        total = total + state\n"
+        "        round = round + 1\n"
+        "    }\n"
+        "\n"
+        "    return total\n"
+        "}\n";
+
+    static constexpr Workload workloads[] {
+        {.name = "seq_loop", .source = seq_loop_source, .iterations = 16 * 10000, .result = 1360000},
+        {.name = "typed_seq_loop", .source = typed_seq_loop_source, .iterations = 16 * 10000, .result = 1360000},
+        {.name = "seq_sum", .source = seq_sum_source, .iterations = 16 * 10000, .result = 1360000},
+        {.name = "parallel_map", .source = parallel_map_source, .iterations = 65536, .result = 93822844764160},
+        {.name = "factorial", .source = factorial_source, .iterations = 20 * 10000, .result = 113784466440192},
+        {.name = "fib", .source = fib_source, .iterations = 242785, .result = 75025},
+        {.name = "generic", .source = generic_source, .iterations = 100000, .result = 4999950000},
+        {.name = "arith", .source = arith_source, .iterations = 100000, .result = 22946485584058},
+        {.name = "deep_recursion", .source = deep_recursion_source, .iterations = 1000000, .result = 500000500000},
+        {.name = "match_dispatch", .source = match_dispatch_source, .iterations = 100000, .result = 1150000}
+    };
+
+    std::span<const Workload> vmWorkloads() noexcept
+    {
+        return workloads;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef WORKLOADS_HPP
+#define WORKLOADS_HPP
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace tisp::bench
+{
+    /**
+     * @brief A Tisp program for timing the VM. Its main runs the kernel of a testprogs script many times over.
+     */
+    struct Workload
+    {
+        std::string_view name;
+        std::string_view source;
+        size_t iterations; // kernel loop iterations or calls per run of main
+        int64_t result; // what main returns, checked after every run
+    };
+
+    [[nodiscard]] std::span<const Workload> vmWorkloads() noexcept;
+}
+
+#endif
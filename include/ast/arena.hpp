@@ -0,0 +1,60 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace tisp::ast
+{
+    /**
+     * @brief Bump allocator for AST nodes. Objects are carved out of large blocks and never freed one by one: releasing the arena runs the few registered destructors and then drops every block at once.
+     */
+    class AstArena
+    {
+    private:
+        struct Cleanup
+        {
+            void (*destroy)(void* object) noexcept;
+            void* object;
+        };
+
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::vector<Cleanup> cleanups;
+        std::byte* cursor;
+        std::byte* block_end;
+        size_t next_block_size;
+        size_t used_bytes;
+
+        void grow(size_t min_size);
+
+    public:
+        static constexpr size_t first_block_size = 16384;
+        static constexpr size_t max_block_size = 1048576;
+
+        AstArena() noexcept;
+        ~AstArena();
+
+        AstArena(const AstArena& other) = delete;
+        AstArena& operator=(const AstArena& other) = delete;
+
+        AstArena(AstArena&& other) noexcept;
+        AstArena& operator=(AstArena&& other) noexcept;
+
+        [[nodiscard]] void* allocate(size_t size, size_t alignment);
+
+        /// @brief Schedules object's destructor for release(), only needed when it owns outside memory.
+        template <typename T>
+        void registerCleanup(T* object)
+        {
+            cleanups.push_back({[](void* target) noexcept { static_cast<T*>(target)->~T(); }, object});
+        }
+
+        /// @brief Destroys everything allocated so far in one step.
+        void release() noexcept;
+
+        [[nodiscard]] size_t bytesUsed() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef CONTEXT_HPP
+#define CONTEXT_HPP
+
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ast/arena.hpp"
+
+namespace tisp::ast
+{
+    /// @brief Deepest nesting of blocks and expressions in a module. The parser rejects deeper sources, and the passes that recurse over a tree stop at the same depth, so none of them can overflow the stack.
+    inline constexpr size_t max_nesting_depth = 256;
+
+    /**
+     * @brief Per-module owner of AST nodes. The parser creates every IExpression and IStatement through make(), children are plain pointers into the same arena, and the whole tree goes away with the context.
+     */
+    class AstContext
+    {
+    private:
+        AstArena arena;
+        size_t node_count;
+
+    public:
+        AstContext() noexcept;
+
+        template <typename Node, typename... Args>
+        [[nodiscard]] Node* make(Args&&... args)
+        {
+            void* place = arena.allocate(sizeof(Node), alignof(Node));
+            Node* node = new (place) Node(std::forward<Args>(args)...);
+
+            if constexpr (!std::is_trivially_destructible_v<Node>)
+                arena.registerCleanup(node);
+
+            node_count++;
+
+            return node;
+        }
+
+        /// @brief Copies a temporary child list into the arena, e.g for Block statements.
+        template <typename Item>
+        [[nodiscard]] std::span<const Item> makeList(const std::vector<Item>& items)
+        {
+            static_assert(std::is_trivially_copyable_v<Item> && std::is_trivially_destructible_v<Item>);
+
+            if (items.empty())
+                return {};
+
+            auto* place = static_cast<Item*>(arena.allocate(sizeof(Item) * items.size(), alignof(Item)));
+
+            std::uninitialized_copy(items.begin(), items.end(), place);
+
+            return {place, items.size()};
+        }
+
+        [[nodiscard]] size_t nodeCount() const noexcept;
+        [[nodiscard]] size_t bytesUsed() const noexcept;
+
+        /// @brief Frees the whole tree at once.
+        void clear() noexcept;
+    };
+}
+
+#endif
@@ -1,18 +1,44 @@
 #ifndef EXPRBASE_HPP
 #define EXPRBASE_HPP
 
-#include <any>
+#include <cstdint>
+#include <span>
 #include "ast/exprvisitor.hpp"
 
 namespace tisp::ast
 {
+    enum class ExprKind : uint8_t
+    {
+        literal,
+        unary,
+        binary,
+        name
+    };
+
     class IExpression
     {
+    private:
+        ExprKind kind;
+
+    protected:
+        explicit IExpression(ExprKind kind_arg) noexcept
+        : kind {kind_arg} {}
+
+        // Nodes live in an AstContext arena and are never deleted through this base.
+        ~IExpression() = default;
+
     public:
-        virtual ~IExpression() = default;
+        [[nodiscard]] constexpr ExprKind getKind() const noexcept
+        {
+            return kind;
+        }
 
-        std::any virtual acceptVisitor(IExprVisitor<std::any>& visitor) const = 0;
+        /// @brief Calls the visitor method for this node's kind through a switch, so Rt can be any type without boxing. Defined in exprs.hpp.
+        template <typename Rt>
+        Rt acceptVisitor(IExprVisitor<Rt>& visitor) const;
     };
+
+    using ExprList = std::span<const IExpression* const>;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,15 +1,19 @@
 #ifndef EXPRS_HPP
 #define EXPRS_HPP
 
-#include <memory>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <any>
 #include <variant>
 #include <vector>
 #include "ast/exprbase.hpp"
+#include "ast/symbols.hpp"
 
 namespace tisp::ast
 {
+    class Substitution;
+
     enum class OpType
     {
         invoke,
@@ -39,6 +43,16 @@ namespace tisp::ast
         nil
     };
 
+    /// @brief The source spelling of a type, e.g "Integer", for diagnostics.
+    [[nodiscard]] std::string_view dataTypeName(DataType type) noexcept;
+
+    /// @brief Maps a builtin type name to its DataType. Generic parameters and ADT names give DataType::unknown.
+    [[nodiscard]] DataType dataTypeFromName(std::string_view type_name) noexcept;
+
+    /// @brief Integers are 48-bit at runtime, so Integer literals and folded Integers stay within these bounds.
+    inline constexpr int64_t max_integer = (int64_t {1} << 47) - 1;
+    inline constexpr int64_t min_integer = -(int64_t {1} << 47);
+
     struct Nil {};
     struct Sequence
     {
@@ -59,7 +73,7 @@ namespace tisp::ast
     constexpr DataType to_lang_type_v<bool> = DataType::boolean;
 
     template <>
-    constexpr DataType to_lang_type_v<int> = DataType::integer;
+    constexpr DataType to_lang_type_v<int64_t> = DataType::integer;
 
     template <>
     constexpr DataType to_lang_type_v<double> = DataType::ndouble;
@@ -73,13 +87,13 @@ namespace tisp::ast
     class Literal : public IExpression
     {
     private:
-        std::variant<Nil, bool, int, double, std::string, std::any> value;
+        std::variant<Nil, bool, int64_t, double, std::string, std::any> value;
         DataType data_type;
 
     public:
         Literal();
         Literal(bool b);
-        Literal(int i);
+        Literal(int64_t i);
         Literal(double dbl);
         Literal(std::string str);
         Literal(Sequence seq);
@@ -90,57 +104,107 @@ namespace tisp::ast
         }
 
         template <typename Nt>
-        constexpr Nt toNativeType() const noexcept
+        Nt toNativeType() const
         {
-            constexpr auto vtype = to_lang_type_v<Nt>;
-
-            if constexpr (vtype == DataType::unknown || vtype != getDataType())
+            if constexpr (to_lang_type_v<Nt> == DataType::unknown)
                 return Nt {};
-
-            constexpr auto variant_idx = static_cast<int>(vtype);
-
-            return std::get<variant_idx>(value);
+            else if constexpr (to_lang_type_v<Nt> == DataType::sequence)
+            {
+                const auto* boxed = std::get_if<std::any>(&value);
+
+                return (boxed != nullptr) ? std::any_cast<Nt>(*boxed) : Nt {};
+            }
+            else
+            {
+                const auto* native = std::get_if<Nt>(&value);
+
+                return (native != nullptr) ? *native : Nt {};
+            }
         }
-
-        [[nodiscard]] std::any acceptVisitor(IExprVisitor<std::any>& visitor) const override;
     };
 
+    /**
+     * @brief Prefix operation. For invoke, inner is the callee and args are the call arguments. For access, inner is the sequence and args holds the index.
+     */
     class Unary : public IExpression
     {
     private:
-        std::unique_ptr<IExpression> inner;
+        const IExpression* inner;
+        ExprList args;
         OpType op;
 
     public:
         Unary() = delete;
-        Unary(std::unique_ptr<IExpression> arg, OpType op_arg);
+        Unary(const IExpression* arg, OpType op_arg, ExprList args_arg = {});
+
+        [[nodiscard]] const IExpression* getInner() const noexcept;
+        [[nodiscard]] ExprList getArgs() const noexcept;
 
         [[nodiscard]] constexpr OpType getOpType() const noexcept
         {
             return op;
         }
-
-        [[nodiscard]] std::any acceptVisitor(IExprVisitor<std::any>& visitor) const override;
     };
 
     class Binary : public IExpression
     {
     private:
-        std::unique_ptr<IExpression> left;
-        std::unique_ptr<IExpression> right;
+        const IExpression* left;
+        const IExpression* right;
         OpType op;
 
     public:
         Binary() = delete;
-        Binary(std::unique_ptr<IExpression> lhs, std::unique_ptr<IExpression> rhs, OpType op_arg);
+        Binary(const IExpression* lhs, const IExpression* rhs, OpType op_arg);
+
+        [[nodiscard]] const IExpression* getLeft() const noexcept;
+        [[nodiscard]] const IExpression* getRight() const noexcept;
 
         [[nodiscard]] constexpr OpType getOpType() const noexcept
         {
             return op;
         }
+    };
+
+    /**
+     * @brief Appends node and the Binary nodes down its left spine to links, outermost first, and returns the leftmost operand. A chain like a + b + c is parsed as a left-deep tree, so passes walk its links from the back of links instead of recursing once per operator.
+     * @note Logical operators and the others form separate chains, so a link's left side always produces a value of the kind its operator expects.
+     */
+    [[nodiscard]] const IExpression* collectChain(const Binary& node, std::vector<const Binary*>& links);
+
+    /**
+     * @brief Reference to a variable, parameter, or function. A callee like addAny(Integer) also carries its generic substitution.
+     */
+    class Name : public IExpression
+    {
+    private:
+        SymbolId name;
+        const Substitution* substitution;
 
-        [[nodiscard]] std::any acceptVisitor(IExprVisitor<std::any>& visitor) const noexcept;
+    public:
+        Name() = delete;
+        Name(SymbolId name_arg, const Substitution* substitution_arg = nullptr);
+
+        [[nodiscard]] SymbolId getName() const noexcept;
+        [[nodiscard]] const Substitution* getSubstitution() const noexcept;
     };
+
+    template <typename Rt>
+    Rt IExpression::acceptVisitor(IExprVisitor<Rt>& visitor) const
+    {
+        switch (kind)
+        {
+            case ExprKind::literal:
+                return visitor.visitLiteral(static_cast<const Literal&>(*this));
+            case ExprKind::unary:
+                return visitor.visitUnary(static_cast<const Unary&>(*this));
+            case ExprKind::binary:
+                return visitor.visitBinary(static_cast<const Binary&>(*this));
+            case ExprKind::name:
+            default:
+                return visitor.visitName(static_cast<const Name&>(*this));
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
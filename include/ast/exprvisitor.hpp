@@ -6,6 +6,7 @@ namespace tisp::ast
     class Literal;
     class Unary;
     class Binary;
+    class Name;
 
     template <typename Rt>
     class IExprVisitor
@@ -16,6 +17,7 @@ namespace tisp::ast
         virtual Rt visitLiteral(const Literal &node) = 0;
         virtual Rt visitUnary(const Unary &node) = 0;
         virtual Rt visitBinary(const Binary &node) = 0;
+        virtual Rt visitName(const Name &node) = 0;
     };
 }
 
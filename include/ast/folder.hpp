@@ -0,0 +1,66 @@
+#ifndef FOLDER_HPP
+#define FOLDER_HPP
+
+#include <cstddef>
+#include <vector>
+#include "ast/context.hpp"
+#include "ast/stmts.hpp"
+
+namespace tisp::ast
+{
+    struct FoldStats
+    {
+        size_t folded_exprs;
+        size_t pruned_cases;
+        size_t removed_loops;
+        size_t removed_nodes; // net nodes gone from the tree, counting every folded operand and pruned subtree
+    };
+
+    /**
+     * @brief AST optimization pass run between parsing and code generation. Folds operators over literals, drops Match cases with constant conditions, and drops While loops whose condition is constant false.
+     * @note Nodes are immutable, so changed nodes are rebuilt in the context and unchanged subtrees are shared. Folding matches the VM's results exactly, and Integer results wrap at 48 bits as they do at runtime, and anything it cannot match (division by zero, mismatched operand types) is left for the type checker or runtime to report.
+     */
+    class ConstantFolder : public IExprVisitor<const IExpression*>, public IStmtVisitor<const IStatement*>
+    {
+    private:
+        AstContext& context;
+        FoldStats stats;
+        std::vector<const Binary*> chain; // links of the operator chains being folded, each chain above the mark of the one containing it
+        size_t depth; // nesting of the expression or body being folded, bounded by max_nesting_depth
+
+        [[nodiscard]] const IExpression* fold(const IExpression* expr);
+        [[nodiscard]] const IStatement* foldBody(const IStatement* body);
+        [[nodiscard]] const Literal* foldBinary(OpType op, const Literal& lhs, const Literal& rhs);
+        [[nodiscard]] const Literal* foldNegate(const Literal& inner);
+
+    public:
+        explicit ConstantFolder(AstContext& context_arg) noexcept;
+
+        /// @brief Folds a whole module. Returned nodes live in the same context as the input.
+        [[nodiscard]] StmtList foldModule(StmtList top_level);
+
+        [[nodiscard]] const FoldStats& getStats() const noexcept;
+
+        const IExpression* visitLiteral(const Literal& node) override;
+        const IExpression* visitUnary(const Unary& node) override;
+        const IExpression* visitBinary(const Binary& node) override;
+        const IExpression* visitName(const Name& node) override;
+
+        /// @note Statement visitors return nullptr for a statement that was removed.
+        const IStatement* visitVariable(const Variable& node) override;
+        const IStatement* visitMutation(const Mutation& node) override;
+        const IStatement* visitFunction(const Function& node) override;
+        const IStatement* visitParameter(const Parameter& node) override;
+        const IStatement* visitBlock(const Block& node) override;
+        const IStatement* visitMatch(const Match& node) override;
+        const IStatement* visitCase(const Case& node) override;
+        const IStatement* visitReturn(const Return& node) override;
+        const IStatement* visitWhile(const While& node) override;
+        const IStatement* visitGeneric(const Generic& node) override;
+        const IStatement* visitSubstitution(const Substitution& node) override;
+        const IStatement* visitImport(const Import& node) override;
+        const IStatement* visitExprStmt(const ExprStmt& node) override;
+    };
+}
+
+#endif
@@ -1,18 +1,53 @@
 #ifndef STMTBASE_HPP
 #define STMTBASE_HPP
 
-#include <any>
+#include <cstdint>
+#include <span>
 #include "ast/stmtvisitor.hpp"
 
 namespace tisp::ast
 {
+    enum class StmtKind : uint8_t
+    {
+        variable,
+        mutation,
+        function,
+        parameter,
+        block,
+        match,
+        match_case,
+        return_value,
+        while_loop,
+        generic,
+        substitution,
+        import,
+        expr_stmt
+    };
+
     class IStatement
     {
+    private:
+        StmtKind kind;
+
+    protected:
+        explicit IStatement(StmtKind kind_arg) noexcept
+        : kind {kind_arg} {}
+
+        // Nodes live in an AstContext arena and are never deleted through this base.
+        ~IStatement() = default;
+
     public:
-        virtual ~IStatement() = default;
+        [[nodiscard]] constexpr StmtKind getKind() const noexcept
+        {
+            return kind;
+        }
 
-        std::any virtual acceptVisitor(IStmtVisitor<std::any>& visitor) const = 0;
+        /// @brief Calls the visitor method for this node's kind through a switch, so Rt can be any type without boxing. Defined in stmts.hpp.
+        template <typename Rt>
+        Rt acceptVisitor(IStmtVisitor<Rt>& visitor) const;
     };
+
+    using StmtList = std::span<const IStatement* const>;
 }
 
-#endif
\ No newline at end of file
+#endif
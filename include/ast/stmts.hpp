@@ -1,206 +1,238 @@
 #ifndef STMTS_HPP
 #define STMTS_HPP
 
-#include <memory>
-#include <string>
-#include <vector>
 #include "ast/exprs.hpp"
 #include "ast/stmtbase.hpp"
+#include "ast/symbols.hpp"
 
 namespace tisp::ast
 {
     class Variable : public IStatement
     {
     private:
-        std::string name;
-        std::unique_ptr<IExpression> rv;
+        SymbolId name;
+        const IExpression* rv;
         DataType type;
+        SymbolId type_name;
         bool is_mutable;
 
     public:
         Variable() = delete;
-        Variable(std::string name_arg, std::unique_ptr<IExpression> rv_arg, DataType type_arg, bool is_var);
+        Variable(SymbolId name_arg, const IExpression* rv_arg, DataType type_arg, bool is_var, SymbolId type_name_arg = no_symbol);
 
-        const std::string& getName() const noexcept;
+        [[nodiscard]] SymbolId getName() const noexcept;
+        const IExpression* getValue() const noexcept;
         [[nodiscard]] DataType getDataType() const noexcept;
+        /// @brief The written type name, which resolves a DataType::unknown such as a generic parameter.
+        [[nodiscard]] SymbolId getTypeName() const noexcept;
         [[nodiscard]] bool isMutable() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
     };
 
     class Mutation : public IStatement
     {
     private:
-        std::string name;
-        std::unique_ptr<IExpression> rv;
+        SymbolId name;
+        const IExpression* rv;
 
     public:
         Mutation() = delete;
-        Mutation(std::string name_arg, std::unique_ptr<IExpression> rv_arg);
-
-        const std::string& getName() const noexcept;
-        const std::unique_ptr<IExpression>& getExpression() const noexcept;
+        Mutation(SymbolId name_arg, const IExpression* rv_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        [[nodiscard]] SymbolId getName() const noexcept;
+        const IExpression* getExpression() const noexcept;
     };
 
     class Function : public IStatement
     {
     private:
-        std::string name;
-        std::vector<std::unique_ptr<IStatement>> params;
-        std::unique_ptr<IStatement> body;
+        SymbolId name;
+        StmtList params;
+        const IStatement* body;
         DataType type;
+        SymbolId type_name;
 
     public:
         Function() = delete;
-        Function(std::string name_arg, std::vector<std::unique_ptr<IStatement>> params_arg, std::unique_ptr<IStatement> body_arg, DataType type_arg);
+        Function(SymbolId name_arg, StmtList params_arg, const IStatement* body_arg, DataType type_arg, SymbolId type_name_arg = no_symbol);
 
-        const std::string& getName() const noexcept;
-        const std::vector<std::unique_ptr<IStatement>>& getParams() const noexcept;
-        const std::unique_ptr<IStatement>& getBody() const noexcept;
+        [[nodiscard]] SymbolId getName() const noexcept;
+        StmtList getParams() const noexcept;
+        const IStatement* getBody() const noexcept;
         [[nodiscard]] DataType getDataType() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        [[nodiscard]] SymbolId getTypeName() const noexcept;
     };
 
     class Parameter : public IStatement
     {
     private:
-        std::string name;
+        SymbolId name;
         DataType type;
+        SymbolId type_name;
 
     public:
         Parameter() = delete;
-        Parameter(std::string name_arg, DataType type_arg);
+        Parameter(SymbolId name_arg, DataType type_arg, SymbolId type_name_arg = no_symbol);
 
-        const std::string& getName() const noexcept;
+        [[nodiscard]] SymbolId getName() const noexcept;
         [[nodiscard]] DataType getDataType() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        [[nodiscard]] SymbolId getTypeName() const noexcept;
     };
 
     class Block : public IStatement
     {
     private:
-        std::vector<std::unique_ptr<IStatement>> stmts;
+        StmtList stmts;
 
     public:
         Block() = delete;
-        Block(std::vector<std::unique_ptr<IStatement>> stmts_arg);
-
-        const std::vector<std::unique_ptr<IStatement>>& getStatements() const noexcept;
+        Block(StmtList stmts_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        StmtList getStatements() const noexcept;
     };
 
     class Match : public IStatement
     {
     private:
-        std::string input_name;
-        std::vector<std::unique_ptr<IStatement>> cases;
-        std::unique_ptr<IStatement> fallback;
+        SymbolId input_name;
+        StmtList cases;
+        const IStatement* fallback;
 
     public:
         Match() = delete;
-        Match(std::string input_arg, std::vector<std::unique_ptr<IStatement>> cases_arg, std::unique_ptr<IStatement> fallback_arg);
+        Match(SymbolId input_arg, StmtList cases_arg, const IStatement* fallback_arg);
 
-        const std::string& getName() const noexcept;
-        const std::vector<std::unique_ptr<IStatement>>& getCases() const noexcept;
-        const std::unique_ptr<IStatement>& getFallback() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        [[nodiscard]] SymbolId getName() const noexcept;
+        StmtList getCases() const noexcept;
+        const IStatement* getFallback() const noexcept;
     };
 
     class Case : public IStatement
     {
     private:
-        std::unique_ptr<IExpression> condition;
-        std::unique_ptr<IStatement> body;
+        const IExpression* condition;
+        const IStatement* body;
 
     public:
         Case() = delete;
-        Case(std::unique_ptr<IExpression> condition_arg, std::unique_ptr<IStatement> body_arg);
-
-        const std::unique_ptr<IExpression>& getCondition() const noexcept;
-        const std::unique_ptr<IStatement>& getBody() const noexcept; 
+        Case(const IExpression* condition_arg, const IStatement* body_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        const IExpression* getCondition() const noexcept;
+        const IStatement* getBody() const noexcept; 
     };
 
     class Return : public IStatement
     {
     private:
-        std::unique_ptr<IExpression> result;
+        const IExpression* result;
 
     public:
         Return() = delete;
-        Return(std::unique_ptr<IExpression> result_arg);
-
-        const std::unique_ptr<IExpression>& getResult() const noexcept;
+        Return(const IExpression* result_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        const IExpression* getResult() const noexcept;
     };
 
     class While : public IStatement
     {
     private:
-        std::unique_ptr<IExpression> conditions;
-        std::unique_ptr<IStatement> body;
+        const IExpression* conditions;
+        const IStatement* body;
 
     public:
         While() = delete;
-        While(std::unique_ptr<IExpression> conditions_arg, std::unique_ptr<IStatement> body_arg);
+        While(const IExpression* conditions_arg, const IStatement* body_arg);
 
-        const std::unique_ptr<IExpression>& getConditions() const noexcept;
-        const std::unique_ptr<IStatement>& getBody() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        const IExpression* getConditions() const noexcept;
+        const IStatement* getBody() const noexcept;
     };
 
     class Generic : public IStatement
     {
     private:
-        std::vector<std::string> params;
-        std::unique_ptr<IStatement> item;
+        SymbolList params;
+        const IStatement* item;
 
     public:
         Generic() = delete;
-        Generic(std::vector<std::string> params_arg, std::unique_ptr<IStatement> item_arg);
-
-        const std::vector<std::string>& getParams() const noexcept;
-        const std::unique_ptr<IStatement>& getItem() const noexcept;
+        Generic(SymbolList params_arg, const IStatement* item_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        SymbolList getParams() const noexcept;
+        const IStatement* getItem() const noexcept;
     };
 
     class Substitution : public IStatement
     {
     private:
-        std::string name;
-        std::vector<std::string> type_names;
+        SymbolId name;
+        SymbolList type_names;
 
     public:
         Substitution() = delete;
-        Substitution(std::string name_arg, std::vector<std::string> tname_args);
+        Substitution(SymbolId name_arg, SymbolList tname_args);
 
-        const std::string& getName() const noexcept;
-        const std::vector<std::string>& getTypeNames() const noexcept;
-
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        [[nodiscard]] SymbolId getName() const noexcept;
+        SymbolList getTypeNames() const noexcept;
     };
 
     class Import : public IStatement
     {
     private:
-        std::vector<std::string> item_path;
+        SymbolList item_path;
     
     public:
         Import() = delete;
-        Import(std::vector<std::string> item_path_arg);
+        Import(SymbolList item_path_arg);
+
+        SymbolList getItemPath() const noexcept;
+    };
+
+    /// @brief An expression run for its effect, e.g a $(print x) call.
+    class ExprStmt : public IStatement
+    {
+    private:
+        const IExpression* expr;
+
+    public:
+        ExprStmt() = delete;
+        ExprStmt(const IExpression* expr_arg);
 
-        [[nodiscard]] std::any acceptVisitor(IStmtVisitor<std::any>& visitor) const override;
+        const IExpression* getExpression() const noexcept;
     };
+
+    template <typename Rt>
+    Rt IStatement::acceptVisitor(IStmtVisitor<Rt>& visitor) const
+    {
+        switch (kind)
+        {
+            case StmtKind::variable:
+                return visitor.visitVariable(static_cast<const Variable&>(*this));
+            case StmtKind::mutation:
+                return visitor.visitMutation(static_cast<const Mutation&>(*this));
+            case StmtKind::function:
+                return visitor.visitFunction(static_cast<const Function&>(*this));
+            case StmtKind::parameter:
+                return visitor.visitParameter(static_cast<const Parameter&>(*this));
+            case StmtKind::block:
+                return visitor.visitBlock(static_cast<const Block&>(*this));
+            case StmtKind::match:
+                return visitor.visitMatch(static_cast<const Match&>(*this));
+            case StmtKind::match_case:
+                return visitor.visitCase(static_cast<const Case&>(*this));
+            case StmtKind::return_value:
+                return visitor.visitReturn(static_cast<const Return&>(*this));
+            case StmtKind::while_loop:
+                return visitor.visitWhile(static_cast<const While&>(*this));
+            case StmtKind::generic:
+                return visitor.visitGeneric(static_cast<const Generic&>(*this));
+            case StmtKind::substitution:
+                return visitor.visitSubstitution(static_cast<const Substitution&>(*this));
+            case StmtKind::import:
+                return visitor.visitImport(static_cast<const Import&>(*this));
+            case StmtKind::expr_stmt:
+            default:
+                return visitor.visitExprStmt(static_cast<const ExprStmt&>(*this));
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -15,6 +15,7 @@ namespace tisp::ast
     class Generic;
     class Substitution;
     class Import;
+    class ExprStmt;
 
     template <typename Rt>
     class IStmtVisitor
@@ -29,12 +30,12 @@ namespace tisp::ast
         virtual Rt visitBlock(const Block& node) = 0;
         virtual Rt visitMatch(const Match &node) = 0;
         virtual Rt visitCase(const Case &node) = 0;
-        virtual Rt visitDefault(const Default &node) = 0;
         virtual Rt visitReturn(const Return &node) = 0;
         virtual Rt visitWhile(const While &node) = 0;
         virtual Rt visitGeneric(const Generic &node) = 0;
         virtual Rt visitSubstitution(const Substitution &node) = 0;
         virtual Rt visitImport(const Import &node) = 0;
+        virtual Rt visitExprStmt(const ExprStmt &node) = 0;
     };
 }
 
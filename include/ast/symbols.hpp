@@ -0,0 +1,55 @@
+#ifndef SYMBOLS_HPP
+#define SYMBOLS_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tisp::ast
+{
+    using SymbolId = uint32_t;
+    using SymbolList = std::span<const SymbolId>;
+
+    constexpr SymbolId no_symbol = std::numeric_limits<SymbolId>::max();
+
+    /**
+     * @brief Interns identifiers and type names. Each distinct spelling is copied once into pooled storage and gets a dense 32-bit id, so name comparisons during scope resolution are integer compares.
+     */
+    class SymbolTable
+    {
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks;
+        std::unordered_map<std::string_view, SymbolId> ids;
+        std::vector<std::string_view> names;
+        char* block_cursor;
+        size_t block_left;
+
+        [[nodiscard]] std::string_view store(std::string_view text);
+
+    public:
+        static constexpr size_t block_size = 4096;
+
+        SymbolTable();
+
+        SymbolTable(const SymbolTable& other) = delete;
+        SymbolTable& operator=(const SymbolTable& other) = delete;
+
+        SymbolTable(SymbolTable&& other) noexcept = default;
+        SymbolTable& operator=(SymbolTable&& other) noexcept = default;
+
+        /// @brief Returns the id of text, adding it on first sight.
+        [[nodiscard]] SymbolId intern(std::string_view text);
+
+        /// @brief Returns the id of text or no_symbol without adding it.
+        [[nodiscard]] SymbolId find(std::string_view text) const;
+
+        [[nodiscard]] std::string_view nameOf(SymbolId id) const noexcept;
+        [[nodiscard]] size_t size() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include <compare>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast/stmts.hpp"
+#include "ast/symbols.hpp"
+#include "backend/typechecker.hpp"
+#include "runtime/bytecode.hpp"
+
+namespace tisp::backend
+{
+    struct GlobalSlot
+    {
+        uint16_t index;
+        ast::DataType type;
+        bool is_mutable;
+    };
+
+    /// @brief A function to compile: a plain defun, or a generic defun with its instantiation's bindings.
+    struct FunctionEntry
+    {
+        const ast::Function* node;
+        TypeBindings bindings;
+    };
+
+    /// @brief Identifies one instantiation of a generic function by the generic's name and its concrete type arguments.
+    struct InstanceKey
+    {
+        ast::SymbolId generic;
+        std::vector<ast::DataType> types;
+
+        auto operator<=>(const InstanceKey&) const = default;
+    };
+
+    /**
+     * @brief Compiles a parsed module into register bytecode. Top-level variables become globals set by an initializer function, and every defun becomes one FunctionProto.
+     */
+    class Compiler
+    {
+    private:
+        const ast::SymbolTable& symbols;
+        std::vector<CompileError> errors;
+        std::unordered_map<ast::SymbolId, uint16_t> function_ids;
+        std::unordered_map<ast::SymbolId, GlobalSlot> global_slots;
+        std::vector<FunctionEntry> function_entries;
+        std::unordered_map<ast::SymbolId, const ast::Generic*> generics;
+        std::map<InstanceKey, uint16_t> instances;
+        TypeChecker checker;
+        TypeTable expr_types;
+
+        friend class FunctionCompiler;
+
+        void declare(ast::StmtList top_level, runtime::Program& program);
+        [[nodiscard]] uint16_t declareFunction(const ast::Function& node, std::string name, TypeBindings bindings, runtime::Program& program);
+
+        /// @brief Returns the function id compiled for a substitution like addAny(Integer), declaring it on first use. Every later call with the same types shares it. Type arguments naming a parameter of the calling instance resolve through outer.
+        [[nodiscard]] uint16_t instantiate(const ast::Substitution& substitution, const TypeBindings& outer, runtime::Program& program);
+
+        [[nodiscard]] ast::DataType paramType(uint16_t function_id, size_t param_pos) const noexcept;
+
+        /// @brief Sets FunctionProto::is_pure from the compiled code of every function and its callees.
+        void markPureFunctions(runtime::Program& program) const;
+
+    public:
+        explicit Compiler(const ast::SymbolTable& symbols_arg);
+
+        /// @brief Type checks and compiles a whole module, plus one specialized function per distinct generic instantiation. The result is only runnable when getErrors() is empty.
+        [[nodiscard]] runtime::Program compile(ast::StmtList top_level);
+
+        [[nodiscard]] const std::vector<CompileError>& getErrors() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef TYPECHECKER_HPP
+#define TYPECHECKER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast/stmts.hpp"
+#include "ast/symbols.hpp"
+
+namespace tisp::backend
+{
+    struct CompileError
+    {
+        std::string message;
+    };
+
+    /// @brief Static type of each checked expression. Missing entries count as DataType::unknown.
+    using TypeTable = std::unordered_map<const ast::IExpression*, ast::DataType>;
+
+    /// @brief Concrete types bound to a generic's type parameters for one instantiation.
+    using TypeBindings = std::unordered_map<ast::SymbolId, ast::DataType>;
+
+    /// @brief Resolves a written type: builtin types as is, and generic parameters through bindings.
+    [[nodiscard]] ast::DataType resolveType(ast::DataType type, ast::SymbolId type_name, const TypeBindings& bindings) noexcept;
+
+    /// @brief Binds each type parameter of generic to the matching name of substitution. A name that is a parameter of the enclosing instance, like T in $(addAny(T) x x), resolves through outer. The caller checks that the counts match.
+    [[nodiscard]] TypeBindings bindSubstitution(const ast::Generic& generic, const ast::Substitution& substitution, const ast::SymbolTable& symbols, const TypeBindings& outer);
+
+    /**
+     * @brief Infers a DataType for every expression of a module and reports mismatches between known types.
+     * @note Generic parameters, unrecognized type names, items of Seqs not traced to a literal, builtin results, and anything nested past ast::max_nesting_depth stay DataType::unknown. The compiler checks such values at runtime only where they flow into a typed variable, parameter, or return, so typed operators never see a wrong value.
+     */
+    class TypeChecker : public ast::IExprVisitor<ast::DataType>, public ast::IStmtVisitor<void>
+    {
+    private:
+        struct Local
+        {
+            ast::SymbolId name;
+            ast::DataType type;
+            ast::DataType element; // item type of a const Seq, else unknown
+        };
+
+        const ast::SymbolTable& symbols;
+        TypeTable types;
+        std::vector<CompileError> errors;
+        std::unordered_map<ast::SymbolId, ast::DataType> global_types;
+        std::unordered_map<ast::SymbolId, ast::DataType> global_elements;
+        std::unordered_map<ast::SymbolId, const ast::Function*> functions;
+        std::unordered_map<ast::SymbolId, const ast::Generic*> generics;
+        std::vector<Local> locals;
+        TypeBindings bindings;
+        std::string function_name;
+        ast::DataType return_type;
+        size_t depth; // nesting of the expression or body being checked, bounded by ast::max_nesting_depth
+        std::vector<const ast::Binary*> chain; // links of the operator chains being checked, each chain above the mark of the one containing it
+
+        void error(std::string message);
+        void expect(ast::DataType expected, ast::DataType actual, const std::string& what);
+
+        [[nodiscard]] ast::DataType infer(const ast::IExpression* expr);
+        [[nodiscard]] ast::DataType typeOfName(ast::SymbolId name) const noexcept;
+        [[nodiscard]] bool isVariable(ast::SymbolId name) const noexcept;
+
+        /// @brief The item type of a Seq literal, or of a const Seq variable initialized from one. Seqs are immutable, so that type holds for the variable's whole life.
+        [[nodiscard]] ast::DataType elementTypeOf(const ast::IExpression* expr) const;
+
+        void declare(ast::StmtList top_level);
+        void checkFunction(const ast::Function& node, std::string name);
+        void checkBody(const ast::IStatement* body);
+        void checkCondition(const ast::IExpression* condition, const char* where);
+
+        [[nodiscard]] ast::DataType inferCall(const ast::Unary& node);
+        [[nodiscard]] ast::DataType inferAccess(const ast::Unary& node);
+
+        /// @brief Checks one operator of a chain against its operand types and returns its result type.
+        [[nodiscard]] ast::DataType checkOperands(ast::OpType op, ast::DataType lhs, ast::DataType rhs);
+
+    public:
+        explicit TypeChecker(const ast::SymbolTable& symbols_arg);
+
+        /// @brief Checks a whole module and returns the inferred expression types. Generic functions are checked with their parameters unknown.
+        [[nodiscard]] TypeTable check(ast::StmtList top_level);
+
+        /// @brief Checks one instantiation of a generic function after check(), and returns the expression types of that instance alone.
+        [[nodiscard]] TypeTable checkInstance(const ast::Function& node, TypeBindings instance_bindings, std::string instance_name);
+
+        [[nodiscard]] const std::vector<CompileError>& getErrors() const noexcept;
+
+        ast::DataType visitLiteral(const ast::Literal& node) override;
+        ast::DataType visitUnary(const ast::Unary& node) override;
+        ast::DataType visitBinary(const ast::Binary& node) override;
+        ast::DataType visitName(const ast::Name& node) override;
+
+        void visitVariable(const ast::Variable& node) override;
+        void visitMutation(const ast::Mutation& node) override;
+        void visitFunction(const ast::Function& node) override;
+        void visitParameter(const ast::Parameter& node) override;
+        void visitBlock(const ast::Block& node) override;
+        void visitMatch(const ast::Match& node) override;
+        void visitCase(const ast::Case& node) override;
+        void visitReturn(const ast::Return& node) override;
+        void visitWhile(const ast::While& node) override;
+        void visitGeneric(const ast::Generic& node) override;
+        void visitSubstitution(const ast::Substitution& node) override;
+        void visitImport(const ast::Import& node) override;
+        void visitExprStmt(const ast::ExprStmt& node) override;
+    };
+}
+
+#endif
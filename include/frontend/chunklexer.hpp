@@ -0,0 +1,29 @@
+#ifndef CHUNKLEXER_HPP
+#define CHUNKLEXER_HPP
+
+#include <string_view>
+#include <vector>
+#include "frontend/token.hpp"
+#include "frontend/tokenbuffer.hpp"
+
+namespace tisp::frontend
+{
+    /// @brief Sources shorter than this are not worth splitting across threads.
+    constexpr size_t min_parallel_source_length = 1 << 20;
+
+    /**
+     * @brief Picks up to chunk_count - 1 split offsets near even fractions of the source. Every split lies just after a newline that is outside any comment or string, so no token besides a whitespace run can cross it.
+     *
+     * @return Ascending bounds starting with 0 and ending with the source length.
+     */
+    [[nodiscard]] std::vector<size_t> findChunkBounds(std::string_view source_view, size_t chunk_count);
+
+    /**
+     * @brief Parallel variant of Lexer::tokenizeSource. Each chunk is lexed on its own thread with its own Lexer and the results are stitched back with corrected offsets, giving exactly the serial output.
+     *
+     * @param worker_count Thread count, where 0 means one per hardware thread.
+     */
+    [[nodiscard]] TokenBuffer tokenizeSourceParallel(std::string_view source_view, size_t worker_count = 0, TriviaMode mode = TriviaMode::keep, TokenBuffer* trivia = nullptr);
+}
+
+#endif
@@ -2,10 +2,9 @@
 #define LEXER_HPP
 
 #include <string>
-#include <set>
-#include <map>
-#include <vector>
+#include "ast/symbols.hpp"
 #include "frontend/token.hpp"
+#include "frontend/tokenbuffer.hpp"
 
 namespace tisp::frontend
 {
@@ -19,7 +18,7 @@ namespace tisp::frontend
         return c == '$' || c == '@' || c == '='
             || c == '+' || c == '-' || c == '*' || c == '/'
             || c == '>' || c == '<' || c == '&' || c == '|'
-            || c == ':';
+            || c == '!' || c == ':';
     }
 
     constexpr bool matchNumeric(char c) noexcept
@@ -32,29 +31,19 @@ namespace tisp::frontend
         return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
     }
 
-    struct LexicalEntry
-    {
-        std::string lexeme;
-        TokenType type;
-    };
-
     class Lexer
     {
     private:
-        std::map<std::string, TokenType> symbols; // operators and punctuation
-        std::set<std::string> kwords;
-        std::set<std::string> tnames;
         std::string_view source;
+        ast::SymbolTable* symbols;
         size_t limit;
         size_t pos;
-        size_t line;
 
-        void reset(std::string_view source_view) noexcept;
         [[nodiscard]] bool isAtEnd() const noexcept;
         [[nodiscard]] char peekSymbol() const;
 
         [[nodiscard]] Token lexWhitespace() noexcept;
-        [[nodiscard]] Token lexOtherWord() noexcept;
+        [[nodiscard]] Token lexOtherWord();
         [[nodiscard]] Token lexNumber() noexcept;
         [[nodiscard]] Token lexPunctuation() noexcept;
         [[nodiscard]] Token lexSingle(TokenType type) noexcept;
@@ -63,9 +52,24 @@ namespace tisp::frontend
     public:
         Lexer();
 
+        /// @brief Makes a lexer that interns every identifier and type name it sees into symbols and stores the id in Token::symbol.
+        explicit Lexer(ast::SymbolTable* symbols_arg);
+
+        /// @brief Starts lexing a new source from start_pos, which must be a token boundary.
+        void reset(std::string_view source_view, size_t start_pos = 0) noexcept;
+
         [[nodiscard]] Token lexNext();
 
-        [[nodiscard]] std::vector<Token> tokenizeSource(std::string_view source_view);
+        /// @brief Lexes the next non-trivia token. Skipped trivia is appended to trivia when it is not null.
+        [[nodiscard]] Token lexNextSignificant(TokenBuffer* trivia);
+
+        /**
+         * @brief Lexes a whole source up to and including eof. Sources of TokenBuffer::max_source_length bytes or more give just an unknown token at offset 0 followed by eof.
+         *
+         * @param mode With TriviaMode::skip, whitespace and comments are left out of the result.
+         * @param trivia Optional side table that receives the skipped trivia, e.g for formatters.
+         */
+        [[nodiscard]] TokenBuffer tokenizeSource(std::string_view source_view, TriviaMode mode = TriviaMode::keep, TokenBuffer* trivia = nullptr);
     };
 }
 
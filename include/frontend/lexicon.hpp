@@ -0,0 +1,96 @@
+#ifndef LEXICON_HPP
+#define LEXICON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <span>
+#include <string_view>
+#include "frontend/token.hpp"
+
+namespace tisp::frontend
+{
+    struct LexicalEntry
+    {
+        std::string_view lexeme;
+        TokenType type;
+    };
+
+    /// @brief The reserved words and operators the Lexer classifies, in table order.
+    [[nodiscard]] std::span<const LexicalEntry> lexicalEntries() noexcept;
+
+    /**
+     * @brief Compile-time perfect hash table of reserved lexemes. Construction searches for a hash seed that gives every entry its own slot, so classifying a lexeme costs one hash and one comparison without any allocation.
+     *
+     * @tparam N Entry count.
+     */
+    template <std::size_t N>
+    class Lexicon
+    {
+    private:
+        static constexpr std::size_t slot_count = [] {
+            std::size_t count = 1;
+
+            while (count < N * 4)
+                count <<= 1;
+
+            return count;
+        }();
+
+        static constexpr uint32_t max_seed_tries = 1U << 16;
+
+        std::array<LexicalEntry, slot_count> slots;
+        uint32_t seed;
+
+        [[nodiscard]] static constexpr std::size_t hashLexeme(std::string_view lexeme, uint32_t seed_arg) noexcept
+        {
+            uint32_t hash = 2166136261U ^ (seed_arg * 0x9e3779b9U);
+
+            for (const char c : lexeme)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 16777619U;
+            }
+
+            return (hash ^ (hash >> 16)) & (slot_count - 1);
+        }
+
+        [[nodiscard]] constexpr bool tryFill(const LexicalEntry (&entries)[N], uint32_t seed_arg) noexcept
+        {
+            slots = {};
+
+            for (const auto& entry : entries)
+            {
+                auto& slot = slots[hashLexeme(entry.lexeme, seed_arg)];
+
+                if (!slot.lexeme.empty())
+                    return false;
+
+                slot = entry;
+            }
+
+            return true;
+        }
+
+    public:
+        constexpr Lexicon(const LexicalEntry (&entries)[N])
+        : slots {}, seed {0}
+        {
+            while (seed < max_seed_tries && !tryFill(entries, seed))
+                seed++;
+        }
+
+        /// @brief Returns the reserved type of lexeme, or fallback if the lexeme is not reserved.
+        [[nodiscard]] constexpr TokenType classify(std::string_view lexeme, TokenType fallback) const noexcept
+        {
+            const auto& slot = slots[hashLexeme(lexeme, seed)];
+
+            if (!slot.lexeme.empty() && slot.lexeme == lexeme)
+                return slot.type;
+
+            return fallback;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef LINEINDEX_HPP
+#define LINEINDEX_HPP
+
+#include <string_view>
+#include <vector>
+
+namespace tisp::frontend
+{
+    struct SourceLocation
+    {
+        size_t line;   // 1-based
+        size_t column; // 1-based, in bytes
+    };
+
+    /**
+     * @brief Maps source offsets to lines and columns for diagnostics. Line starts are only scanned on the first lookup, so lexing never pays for line bookkeeping.
+     */
+    class LineIndex
+    {
+    private:
+        std::string_view source;
+        std::vector<size_t> line_starts;
+        bool built;
+
+        void build();
+
+    public:
+        explicit LineIndex(std::string_view source_view) noexcept;
+
+        [[nodiscard]] SourceLocation locate(size_t offset);
+        [[nodiscard]] size_t lineCount();
+    };
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef PARSER_HPP
+#define PARSER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast/context.hpp"
+#include "ast/exprs.hpp"
+#include "ast/stmts.hpp"
+#include "ast/symbols.hpp"
+#include "frontend/token.hpp"
+#include "frontend/tokenstream.hpp"
+
+namespace tisp::frontend
+{
+    struct ParseError
+    {
+        size_t offset;
+        std::string message;
+    };
+
+    /**
+     * @brief Recursive descent parser for the rules in grammar.md. Nodes are made in the given AstContext and names are interned into the given SymbolTable, so both must outlive the returned statements.
+     *
+     * On a syntax error the parser records it, skips to the next top-level declaration, and keeps going, so one run reports every broken declaration.
+     */
+    class Parser
+    {
+    private:
+        TokenStream tokens;
+        std::string_view source;
+        ast::AstContext& context;
+        ast::SymbolTable& symbols;
+        std::vector<ParseError> errors;
+        size_t depth;
+
+        [[nodiscard]] const Token& peek(size_t offset = 0);
+        [[nodiscard]] std::string_view lexemeOf(const Token& token) const noexcept;
+        [[nodiscard]] bool atKeyword(std::string_view word);
+        [[nodiscard]] bool match(TokenType type);
+        Token expect(TokenType type, const char* what);
+        void expectKeyword(std::string_view word);
+        [[noreturn]] void fail(const Token& token, std::string message);
+
+        /// @brief Counts one more level of nesting, failing at the next token past ast::max_nesting_depth. Callers decrement depth on the way out.
+        void enterNesting(const char* what);
+
+        void synchronize();
+
+        [[nodiscard]] ast::SymbolId parseIdentifier();
+        [[nodiscard]] ast::SymbolId parseTypeName();
+        [[nodiscard]] ast::DataType dataTypeOf(ast::SymbolId type_name) const;
+
+        /* Statements */
+
+        [[nodiscard]] const ast::IStatement* parseOuter();
+        [[nodiscard]] const ast::IStatement* parseInner();
+        [[nodiscard]] const ast::IStatement* parseBlock();
+        [[nodiscard]] const ast::IStatement* parseVariable();
+        [[nodiscard]] const ast::IStatement* parseMutation();
+        [[nodiscard]] const ast::IStatement* parseFunction();
+        [[nodiscard]] const ast::IStatement* parseMatch();
+        [[nodiscard]] const ast::IStatement* parseReturn();
+        [[nodiscard]] const ast::IStatement* parseWhile();
+        [[nodiscard]] const ast::IStatement* parseGeneric();
+        [[nodiscard]] const ast::IStatement* parseImport();
+
+        /* Expressions */
+
+        [[nodiscard]] const ast::IExpression* parseExpr();
+        [[nodiscard]] const ast::IExpression* parseConditional();
+        [[nodiscard]] const ast::IExpression* parseCompare();
+        [[nodiscard]] const ast::IExpression* parseTerm();
+        [[nodiscard]] const ast::IExpression* parseFactor();
+        [[nodiscard]] const ast::IExpression* parseUnary();
+        [[nodiscard]] const ast::IExpression* parseCallee();
+        [[nodiscard]] const ast::IExpression* parsePrimary();
+        [[nodiscard]] const ast::IExpression* parseSequence();
+
+    public:
+        Parser(std::string_view source_view, ast::AstContext& context_arg, ast::SymbolTable& symbols_arg);
+
+        /// @brief Parses the whole source into its top-level declarations.
+        [[nodiscard]] ast::StmtList parseModule();
+
+        [[nodiscard]] const std::vector<ParseError>& getErrors() const noexcept;
+
+        /// @brief Significant tokens consumed so far, e.g for throughput figures.
+        [[nodiscard]] size_t getTokenCount() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RELEXER_HPP
+#define RELEXER_HPP
+
+#include <string_view>
+#include "frontend/token.hpp"
+#include "frontend/tokenbuffer.hpp"
+
+namespace tisp::frontend
+{
+    /// @brief One text change in old source coordinates.
+    struct SourceEdit
+    {
+        size_t offset;
+        size_t removed_length;
+        std::string_view inserted_text;
+    };
+
+    /// @brief Which tokens an incremental re-lex replaced, in new buffer indices.
+    struct RelexResult
+    {
+        size_t first;
+        size_t removed_count;
+        size_t inserted_count;
+    };
+
+    /**
+     * @brief Updates tokens of the old source after edit produced new_source. Lexing restarts at the token touching the edit and stops once a new token lands on the shifted start of an old token past the edit, since the lexer carries no state between tokens. Later tokens only get their offsets shifted.
+     *
+     * @param mode Must match the mode tokens were produced with.
+     */
+    RelexResult relexSource(TokenBuffer& tokens, std::string_view new_source, const SourceEdit& edit, TriviaMode mode = TriviaMode::keep);
+}
+
+#endif
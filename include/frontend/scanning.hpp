@@ -0,0 +1,42 @@
+#ifndef SCANNING_HPP
+#define SCANNING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tisp::frontend
+{
+    /*
+     * Bulk character scanning for the lexer. Each scan works on [pos, limit) of data and returns the first position that ends the run, or limit when the run reaches the end. SSE2 / AVX2 kernels are picked at runtime on x86-64 and everything else uses the scalar match* predicates.
+     */
+
+    enum class ScanKernel : uint8_t
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    /// @brief The fastest kernel this CPU supports, which every scan uses unless useScanKernel picked another.
+    [[nodiscard]] ScanKernel bestScanKernel() noexcept;
+
+    /// @brief Switches every scan to kernel, e.g so tests can check each kernel against the scalar one. Gives false and changes nothing when the CPU lacks it.
+    bool useScanKernel(ScanKernel kernel) noexcept;
+
+    /// @brief Skips spaces, tabs, and line breaks.
+    [[nodiscard]] size_t scanWhitespace(const char* data, size_t pos, size_t limit) noexcept;
+
+    /// @brief Skips letters and underscores.
+    [[nodiscard]] size_t scanAlphabetic(const char* data, size_t pos, size_t limit) noexcept;
+
+    /// @brief Skips digits and dots.
+    [[nodiscard]] size_t scanNumeric(const char* data, size_t pos, size_t limit) noexcept;
+
+    /// @brief Finds the next occurrence of target, e.g the closing delimiter of a comment or string.
+    [[nodiscard]] size_t scanUntil(const char* data, size_t pos, size_t limit, char target) noexcept;
+
+    /// @brief Finds the next occurrence of either target, e.g the next comment or string opener.
+    [[nodiscard]] size_t scanUntilEither(const char* data, size_t pos, size_t limit, char first, char second) noexcept;
+}
+
+#endif
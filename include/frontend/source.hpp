@@ -0,0 +1,40 @@
+#ifndef SOURCE_HPP
+#define SOURCE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace tisp::frontend
+{
+    /**
+     * @brief Owns the bytes of one source file. Regular files are memory mapped read-only while pipes and stdin are streamed into an owned string, so either way the lexer gets a view of the exact file contents without extra copies.
+     */
+    class SourceBuffer
+    {
+    private:
+        std::string storage;
+        const char* mapped;
+        size_t mapped_length;
+        bool loaded;
+
+        [[nodiscard]] static SourceBuffer fromDescriptor(int fd);
+
+    public:
+        SourceBuffer() noexcept;
+        ~SourceBuffer();
+
+        SourceBuffer(const SourceBuffer& other) = delete;
+        SourceBuffer& operator=(const SourceBuffer& other) = delete;
+
+        SourceBuffer(SourceBuffer&& other) noexcept;
+        SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+        /// @brief Loads a file by path, where "-" means stdin.
+        [[nodiscard]] static SourceBuffer fromPath(const std::string& file_path);
+
+        [[nodiscard]] bool isLoaded() const noexcept;
+        [[nodiscard]] std::string_view view() const noexcept;
+    };
+}
+
+#endif
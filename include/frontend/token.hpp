@@ -3,6 +3,7 @@
 
 #include <string>
 #include <string_view>
+#include "ast/symbols.hpp"
 
 namespace tisp::frontend
 {
@@ -27,6 +28,8 @@ namespace tisp::frontend
         op_gte,
         op_lt,
         op_lte,
+        op_eq,
+        op_neq,
         op_and,
         op_or,
         colon,
@@ -53,12 +56,24 @@ namespace tisp::frontend
         return static_cast<int>(lhs) >= static_cast<int>(rhs);
     }
 
+    /// @brief Whether whitespace and comment tokens stay in the main token stream.
+    enum class TriviaMode
+    {
+        keep,
+        skip
+    };
+
+    constexpr bool isTrivia(TokenType type) noexcept
+    {
+        return type == TokenType::whitespace || type == TokenType::comment;
+    }
+
     struct Token
     {
         size_t begin;
         size_t length;
-        size_t line;
         TokenType type;
+        ast::SymbolId symbol = ast::no_symbol; // interned spelling of an identifier or type name, set by a Lexer with a SymbolTable
     };
 
     [[nodiscard]] std::string_view viewLexeme(const Token& token, std::string_view source);
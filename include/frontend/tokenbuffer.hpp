@@ -0,0 +1,125 @@
+#ifndef TOKENBUFFER_HPP
+#define TOKENBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "frontend/token.hpp"
+
+namespace tisp::frontend
+{
+    class TokenView;
+
+    /**
+     * @brief Struct-of-arrays token storage. Kinds are kept as bytes in their own array so a parser scanning token types touches as little memory as possible, while offsets use 32-bit integers.
+     * @note Splicing leaves a gap of free slots at the edit, like a text editor's gap buffer, and the tokens after it keep their begins unshifted plus one pending shift. The next splice near the same place then only moves the tokens between the two edits.
+     */
+    class TokenBuffer
+    {
+    private:
+        std::vector<uint8_t> kinds;
+        std::vector<uint32_t> begins;
+        std::vector<uint32_t> lengths;
+        size_t gap_begin; // tokens from this index on are stored after the gap and have pending_shift added to their begins
+        size_t gap_length;
+        uint32_t pending_shift;
+
+        [[nodiscard]] size_t slotOf(size_t index) const noexcept;
+        [[nodiscard]] uint32_t shiftAt(size_t index) const noexcept;
+        [[nodiscard]] uint32_t beginAt(size_t index) const noexcept;
+        void moveGap(size_t index);
+
+    public:
+        static constexpr size_t max_source_length = std::numeric_limits<uint32_t>::max();
+
+        TokenBuffer();
+
+        /// @brief Reserves room for the usual token density of a source of the given length.
+        void reserveFor(size_t source_length, TriviaMode mode = TriviaMode::keep);
+        void reserve(size_t token_count);
+        void push(const Token& token);
+
+        /// @brief Appends tokens [first, last) of other with their begin offsets moved forward by shift.
+        void appendShifted(const TokenBuffer& other, size_t first, size_t last, size_t shift);
+
+        /// @brief Lengthens the last token, e.g when joining a whitespace run split between chunks.
+        void growLast(size_t extra) noexcept;
+
+        /// @brief Replaces tokens [first, last) with all of replacement and moves every later begin offset by shift. Costs the replacement's size plus the token distance from the previous splice.
+        void splice(size_t first, size_t last, const TokenBuffer& replacement, std::ptrdiff_t shift);
+
+        /// @brief Closes the gap left by splicing and applies the pending shift, so kindData() covers every token again.
+        void compact();
+        void clear() noexcept;
+
+        [[nodiscard]] size_t size() const noexcept;
+        [[nodiscard]] bool isEmpty() const noexcept;
+        [[nodiscard]] TokenType typeAt(size_t index) const noexcept;
+        [[nodiscard]] Token at(size_t index) const noexcept;
+
+        /// @brief Finds the last token beginning at or before offset, or 0 if there is none.
+        [[nodiscard]] size_t indexAtOrBefore(size_t offset) const noexcept;
+        /// @brief Kinds of every token in order, as long as no splice happened since the last compact().
+        [[nodiscard]] const uint8_t* kindData() const noexcept;
+
+        [[nodiscard]] TokenView view() const noexcept;
+    };
+
+    /**
+     * @brief Non-owning window over a TokenBuffer for the parser.
+     */
+    class TokenView
+    {
+    private:
+        const TokenBuffer* buffer;
+        size_t first;
+        size_t count;
+
+    public:
+        class Iterator
+        {
+        private:
+            const TokenBuffer* buffer;
+            size_t index;
+
+        public:
+            Iterator(const TokenBuffer* buffer_arg, size_t index_arg) noexcept
+            : buffer {buffer_arg}, index {index_arg} {}
+
+            [[nodiscard]] Token operator*() const noexcept
+            {
+                return buffer->at(index);
+            }
+
+            Iterator& operator++() noexcept
+            {
+                index++;
+                return *this;
+            }
+
+            [[nodiscard]] bool operator==(const Iterator& other) const noexcept
+            {
+                return index == other.index;
+            }
+
+            [[nodiscard]] bool operator!=(const Iterator& other) const noexcept
+            {
+                return index != other.index;
+            }
+        };
+
+        TokenView() noexcept;
+        TokenView(const TokenBuffer* buffer_arg, size_t first_arg, size_t count_arg) noexcept;
+
+        [[nodiscard]] size_t size() const noexcept;
+        [[nodiscard]] TokenType typeAt(size_t index) const noexcept;
+        [[nodiscard]] Token operator[](size_t index) const noexcept;
+        [[nodiscard]] TokenView subview(size_t offset, size_t count_arg) const noexcept;
+
+        [[nodiscard]] Iterator begin() const noexcept;
+        [[nodiscard]] Iterator end() const noexcept;
+    };
+}
+
+#endif
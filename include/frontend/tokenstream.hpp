@@ -0,0 +1,49 @@
+#ifndef TOKENSTREAM_HPP
+#define TOKENSTREAM_HPP
+
+#include <string_view>
+#include <vector>
+#include "frontend/token.hpp"
+#include "frontend/lexer.hpp"
+
+namespace tisp::frontend
+{
+    /**
+     * @brief Pull-based token source for the parser. Tokens are lexed only when peeked, and at most lookahead of them are held in a fixed ring, so token memory does not grow with the source.
+     */
+    class TokenStream
+    {
+    private:
+        std::vector<Token> window;
+        Lexer lexer;
+        size_t head;
+        size_t buffered;
+        size_t mask;
+        size_t consumed;
+        TriviaMode trivia_mode;
+        bool lexed_eof;
+
+        void fill(size_t wanted);
+
+    public:
+        static constexpr size_t default_lookahead = 4;
+
+        /// @param symbols Optional table the lexer interns identifiers and type names into, so their tokens carry a Token::symbol.
+        explicit TokenStream(std::string_view source_view, size_t lookahead_arg = default_lookahead, TriviaMode mode = TriviaMode::keep, ast::SymbolTable* symbols = nullptr);
+
+        [[nodiscard]] size_t lookahead() const noexcept;
+
+        /// @brief Returns the token offset places ahead of the current one. Offsets past lookahead() - 1 are clamped.
+        [[nodiscard]] const Token& peek(size_t offset = 0);
+
+        /// @brief Returns the current token and moves past it. At the end, eof is returned every time.
+        [[nodiscard]] Token next();
+
+        [[nodiscard]] bool isAtEnd();
+
+        /// @brief How many tokens next() has moved past, not counting eof.
+        [[nodiscard]] size_t consumedCount() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef BUILTINS_HPP
+#define BUILTINS_HPP
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "runtime/value.hpp"
+
+namespace tisp::runtime
+{
+    class Vm;
+
+    /// @brief Native function body. Returns false after reporting an error to the VM.
+    using BuiltinFn = bool (*)(Vm& vm, Value* args, uint8_t arg_count, Value& result);
+
+    struct BuiltinEntry
+    {
+        std::string_view module;
+        std::string_view name;
+        uint8_t arity;
+        BuiltinFn call;
+        bool is_pure; // false for builtins with effects a worker VM must not have, such as output
+    };
+
+    constexpr uint8_t no_builtin = 0xff;
+
+    /// @brief Seqs shorter than this are not worth splitting across threads, so the parallel builtins run them serially.
+    constexpr size_t min_parallel_seq_length = 4096;
+
+    [[nodiscard]] std::span<const BuiltinEntry> builtinTable() noexcept;
+
+    /// @brief Returns the table index of a builtin by its bare name, or no_builtin.
+    [[nodiscard]] uint8_t findBuiltin(std::string_view name) noexcept;
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "runtime/value.hpp"
+
+namespace tisp::runtime
+{
+    /**
+     * @brief VM opcodes. R[x] is register x of the current frame, K[x] is constant x of the current function, and G[x] is global x.
+     */
+    enum class Opcode : uint8_t
+    {
+        move,          // A B: R[A] = R[B]
+        load_const,    // A Bx: R[A] = K[Bx]
+        load_int,      // A sBx: R[A] = sBx
+        load_nil,      // A: R[A] = Nil
+        load_bool,     // A B: R[A] = (B != 0)
+        get_global,    // A Bx: R[A] = G[Bx]
+        set_global,    // A Bx: G[Bx] = R[A]
+        add,           // A B C: R[A] = R[B] + R[C]
+        sub,
+        mul,
+        div,
+        neg,           // A B: R[A] = -R[B]
+        eq,            // A B C: R[A] = R[B] == R[C]
+        ne,
+        lt,
+        le,
+        gt,
+        ge,
+        add_i64,       // A B C: R[A] = R[B] + R[C], typed by the compiler, so operands are not checked
+        sub_i64,
+        mul_i64,
+        div_i64,       // only checks for a zero divisor
+        neg_i64,       // A B: R[A] = -R[B]
+        add_f64,
+        sub_f64,
+        mul_f64,
+        div_f64,
+        neg_f64,
+        eq_i64,        // A B C: R[A] = R[B] == R[C], and the compiler swaps operands for > and >=
+        ne_i64,
+        lt_i64,
+        le_i64,
+        eq_f64,
+        ne_f64,
+        lt_f64,
+        le_f64,
+        concat_str,    // A B C: R[A] = R[B] + R[C] on Strings
+        check_type,    // A B: fails unless R[A] has ValueTag B, where untyped values enter typed slots
+        jump,          // sAx: ip += sAx
+        jump_if_false, // A sBx: if !R[A] then ip += sBx
+        jump_if_true,  // A sBx: if R[A] then ip += sBx
+        switch_int,    // A Bx: ip += offset for Integer R[A] in int switch table Bx
+        switch_str,    // A Bx: ip += offset for String R[A] in string switch table Bx
+        call,          // A Bx: R[A] = function Bx called with its arguments in R[A], R[A + 1], ...
+        tail_call,     // A Bx: return function Bx called with its arguments in R[A], R[A + 1], ..., reusing the current frame
+        call_builtin,  // A B C: R[A] = builtin B called with C arguments in R[A], R[A + 1], ...
+        length,        // A B: R[A] = length of R[B]
+        index,         // A B C: R[A] = R[B] at R[C]
+        index_i64,     // A B C: R[A] = R[B] at R[C] for a Seq the compiler knows holds Integers, read unboxed
+        index_f64,
+        index_bool,
+        ret,           // A: return R[A]
+        ret_nil,       // return Nil
+        last = ret_nil
+    };
+
+    /**
+     * @brief One 32-bit instruction: an 8-bit opcode in the low byte, then either three 8-bit operands A B C, an 8-bit A with a 16-bit Bx or sBx, or a 24-bit sAx.
+     */
+    using Instruction = uint32_t;
+
+    constexpr int32_t max_sbx = std::numeric_limits<int16_t>::max();
+    constexpr int32_t min_sbx = std::numeric_limits<int16_t>::min();
+    constexpr int32_t max_sax = (1 << 23) - 1;
+    constexpr int32_t min_sax = -(1 << 23);
+
+    [[nodiscard]] constexpr Instruction encodeABC(Opcode op, uint8_t a, uint8_t b, uint8_t c) noexcept
+    {
+        return static_cast<Instruction>(op) | (static_cast<Instruction>(a) << 8) | (static_cast<Instruction>(b) << 16) | (static_cast<Instruction>(c) << 24);
+    }
+
+    [[nodiscard]] constexpr Instruction encodeABx(Opcode op, uint8_t a, uint16_t bx) noexcept
+    {
+        return static_cast<Instruction>(op) | (static_cast<Instruction>(a) << 8) | (static_cast<Instruction>(bx) << 16);
+    }
+
+    [[nodiscard]] constexpr Instruction encodeAsBx(Opcode op, uint8_t a, int32_t sbx) noexcept
+    {
+        return encodeABx(op, a, static_cast<uint16_t>(static_cast<int16_t>(sbx)));
+    }
+
+    [[nodiscard]] constexpr Instruction encodesAx(Opcode op, int32_t sax) noexcept
+    {
+        return static_cast<Instruction>(op) | (static_cast<Instruction>(sax) << 8);
+    }
+
+    [[nodiscard]] constexpr Opcode opOf(Instruction code) noexcept
+    {
+        return static_cast<Opcode>(code & 0xff);
+    }
+
+    [[nodiscard]] constexpr uint8_t argA(Instruction code) noexcept
+    {
+        return static_cast<uint8_t>(code >> 8);
+    }
+
+    [[nodiscard]] constexpr uint8_t argB(Instruction code) noexcept
+    {
+        return static_cast<uint8_t>(code >> 16);
+    }
+
+    [[nodiscard]] constexpr uint8_t argC(Instruction code) noexcept
+    {
+        return static_cast<uint8_t>(code >> 24);
+    }
+
+    [[nodiscard]] constexpr uint16_t argBx(Instruction code) noexcept
+    {
+        return static_cast<uint16_t>(code >> 16);
+    }
+
+    [[nodiscard]] constexpr int32_t argSBx(Instruction code) noexcept
+    {
+        return static_cast<int16_t>(argBx(code));
+    }
+
+    [[nodiscard]] constexpr int32_t argSAx(Instruction code) noexcept
+    {
+        return static_cast<int32_t>(code) >> 8;
+    }
+
+    static_assert(argSAx(encodesAx(Opcode::jump, min_sax)) == min_sax && argSAx(encodesAx(Opcode::jump, max_sax)) == max_sax);
+    static_assert(argSBx(encodeAsBx(Opcode::jump_if_false, 7, -3)) == -3 && argA(encodeAsBx(Opcode::jump_if_false, 7, -3)) == 7);
+
+    /// @brief Jump table of a switch_int. Offsets are relative to the instruction after the switch, like jump offsets.
+    struct IntSwitch
+    {
+        int64_t low;                  // key of targets[0]
+        std::vector<int32_t> targets; // one offset per key from low
+        int32_t below;                // offset for keys under low
+        int32_t above;                // offset for keys past the last target
+    };
+
+    /// @brief Hashed jump table of a switch_str.
+    struct StringSwitch
+    {
+        std::unordered_map<std::string, int32_t> targets;
+        int32_t fallback;
+    };
+
+    struct FunctionProto
+    {
+        std::string name;
+        std::vector<Instruction> code;
+        std::vector<Value> constants;
+        std::vector<IntSwitch> int_switches;
+        std::vector<StringSwitch> string_switches;
+        /// @brief The tag each argument must have, or nullopt for a generic parameter. Compiled calls check arguments at the call site, so only builtins calling back into Tisp read this.
+        std::vector<std::optional<ValueTag>> param_tags;
+        uint16_t arity;
+        uint16_t register_count;
+        /// @brief Never assigns a global or reaches a builtin with side effects, so it may run on a worker VM.
+        bool is_pure;
+    };
+
+    constexpr uint16_t no_function = std::numeric_limits<uint16_t>::max();
+
+    /**
+     * @brief A compiled module. The heap owns string and sequence constants, so a program must outlive every VM run of it.
+     */
+    struct Program
+    {
+        std::vector<FunctionProto> functions;
+        Heap heap {HeapKind::pinned};
+        /// @brief A zero of each global's declared type, so typed code never reads Nil from a global the initializer has not set yet.
+        std::vector<Value> global_defaults;
+        uint16_t init_function = no_function;
+        uint16_t main_function = no_function;
+    };
+
+    [[nodiscard]] std::string_view opcodeName(Opcode op) noexcept;
+
+    /// @brief Writes a readable listing of every function, e.g for checking compiler output.
+    void disassemble(std::ostream& out, const Program& program);
+}
+
+#endif
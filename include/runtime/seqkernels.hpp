@@ -0,0 +1,69 @@
+#ifndef SEQKERNELS_HPP
+#define SEQKERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tisp::runtime
+{
+    /*
+     * Bulk kernels over the unboxed items of Integer and Double Seqs. SSE2 / AVX2 versions are picked at runtime on x86-64 and everything else uses the scalar loops. Integer results wrap at 48 bits like the VM's operators. Double sums and dot products add in four interleaved lanes on every path, so their rounding does not depend on the CPU.
+     */
+
+    enum class SeqKernel : uint8_t
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    /// @brief The fastest kernel this CPU supports, which every Seq kernel uses unless useSeqKernel picked another.
+    [[nodiscard]] SeqKernel bestSeqKernel() noexcept;
+
+    /// @brief Switches every Seq kernel to kernel, e.g so tests can check each kernel against the scalar one. Gives false and changes nothing when the CPU lacks it.
+    bool useSeqKernel(SeqKernel kernel) noexcept;
+
+    enum class SeqArith : uint8_t
+    {
+        add,
+        sub,
+        mul
+    };
+
+    enum class SeqCompare : uint8_t
+    {
+        less,
+        greater,
+        equal
+    };
+
+    [[nodiscard]] int64_t sumIntegers(std::span<const int64_t> items) noexcept;
+    [[nodiscard]] double sumDoubles(std::span<const double> items) noexcept;
+
+    /// @brief Smallest or largest item. items must not be empty.
+    [[nodiscard]] int64_t minIntegers(std::span<const int64_t> items) noexcept;
+    [[nodiscard]] int64_t maxIntegers(std::span<const int64_t> items) noexcept;
+
+    /// @brief Smallest or largest item, skipping NaNs. The result is NaN only when every item is. items must not be empty.
+    [[nodiscard]] double minDoubles(std::span<const double> items) noexcept;
+    [[nodiscard]] double maxDoubles(std::span<const double> items) noexcept;
+
+    /// @brief Sum of the pairwise products. Both spans have the same size.
+    [[nodiscard]] int64_t dotIntegers(std::span<const int64_t> lhs, std::span<const int64_t> rhs) noexcept;
+    [[nodiscard]] double dotDoubles(std::span<const double> lhs, std::span<const double> rhs) noexcept;
+
+    /// @brief Writes lhs op rhs per item into out, which has lhs' size. rhs has lhs' size too, or holds one item applied to every lhs item.
+    void mapIntegers(SeqArith op, std::span<const int64_t> lhs, std::span<const int64_t> rhs, std::span<int64_t> out) noexcept;
+    void mapDoubles(SeqArith op, std::span<const double> lhs, std::span<const double> rhs, std::span<double> out) noexcept;
+
+    /// @brief Writes 1 into out where lhs op rhs holds and 0 elsewhere. rhs follows the same rule as in mapIntegers.
+    void compareIntegers(SeqCompare op, std::span<const int64_t> lhs, std::span<const int64_t> rhs, std::span<uint8_t> out) noexcept;
+    void compareDoubles(SeqCompare op, std::span<const double> lhs, std::span<const double> rhs, std::span<uint8_t> out) noexcept;
+
+    /// @brief Copies the items whose keep byte is 1 to the front of out, in order, and returns how many it copied. keep holds only 0 and 1, and keep and out have items' size.
+    [[nodiscard]] size_t filterIntegers(std::span<const int64_t> items, std::span<const uint8_t> keep, std::span<int64_t> out) noexcept;
+    [[nodiscard]] size_t filterDoubles(std::span<const double> items, std::span<const uint8_t> keep, std::span<double> out) noexcept;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tisp::runtime
+{
+    /**
+     * @brief Fixed set of worker threads with one task deque each. Each worker takes the newest task of its own deque and, once that is empty, steals the oldest task of another, so uneven tasks still keep every worker busy.
+     */
+    class ThreadPool
+    {
+    public:
+        /// @brief A unit of work, told which worker runs it so it can use that worker's own state.
+        using Task = std::function<void(size_t worker)>;
+
+    private:
+        struct TaskQueue
+        {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+        std::vector<std::thread> threads;
+        std::mutex state_lock;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        size_t pending;
+        uint64_t batch;
+        bool stopping;
+
+        [[nodiscard]] bool takeTask(size_t worker, Task& task);
+        void workerLoop(size_t worker);
+
+    public:
+        /// @param worker_count Thread count, where 0 means one per hardware thread.
+        explicit ThreadPool(size_t worker_count = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        [[nodiscard]] size_t workerCount() const noexcept;
+
+        /// @brief Deals the tasks round robin to the workers and returns once all of them ran. Tasks must not throw, and only one thread may call this at a time.
+        void runAll(std::vector<Task> tasks);
+    };
+}
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace tisp::runtime
+{
+    enum class ValueTag : uint8_t
+    {
+        nil,
+        boolean,
+        integer,
+        ndouble,
+        string,
+        sequence,
+        function
+    };
+
+    enum class ObjectKind : uint8_t
+    {
+        string,
+        sequence
+    };
+
+    struct Object
+    {
+        ObjectKind kind;
+        bool marked;    // reached by the running collection
+        bool is_pinned; // owned by a pinned heap, so collections of other heaps leave it alone
+
+        explicit Object(ObjectKind kind_arg) noexcept
+        : kind {kind_arg}, marked {false}, is_pinned {false} {}
+
+        virtual ~Object() = default;
+    };
+
+    struct StringObject;
+    struct SeqObject;
+
+    static_assert(sizeof(void*) == 8, "NaN-boxed values need 64-bit pointers");
+
+    /**
+     * @brief NaN-boxed runtime value: one 64-bit word held in VM registers, globals, and sequences.
+     * @note Any word outside the boxed space is a Double, and NaN results are canonicalized so they never fall into it. A boxed word is a negative quiet NaN whose bits 48-50 hold the tag and whose low 48 bits hold the payload: a Boolean, a wrapping 48-bit Integer, a pointer to a String or Seq in the Heap, or the id of a defun passed to a builtin.
+     */
+    class Value
+    {
+    private:
+        static constexpr uint64_t box_mask = 0xfff8'0000'0000'0000;
+        static constexpr uint64_t payload_mask = 0x0000'ffff'ffff'ffff;
+        static constexpr uint64_t canonical_nan = 0x7ff8'0000'0000'0000;
+        static constexpr int tag_shift = 48;
+
+        // Tag 0 is left unused so a boxed word is never all prefix.
+        static constexpr uint64_t nil_tag = 1;
+        static constexpr uint64_t boolean_tag = 2;
+        static constexpr uint64_t integer_tag = 3;
+        static constexpr uint64_t string_tag = 4;
+        static constexpr uint64_t sequence_tag = 5;
+        static constexpr uint64_t function_tag = 6;
+
+        uint64_t bits;
+
+        [[nodiscard]] static constexpr uint64_t boxed(uint64_t tag, uint64_t payload) noexcept
+        {
+            return box_mask | (tag << tag_shift) | (payload & payload_mask);
+        }
+
+        [[nodiscard]] constexpr bool hasTag(uint64_t tag) const noexcept
+        {
+            return (bits >> tag_shift) == ((box_mask >> tag_shift) | tag);
+        }
+
+        [[nodiscard]] constexpr bool isBoxed() const noexcept
+        {
+            return (bits & box_mask) == box_mask;
+        }
+
+    public:
+        /// @brief Integers keep 48 bits inline, and arithmetic on them wraps at that width.
+        static constexpr int64_t max_integer = (int64_t {1} << 47) - 1;
+        static constexpr int64_t min_integer = -(int64_t {1} << 47);
+
+        constexpr Value() noexcept
+        : bits {boxed(nil_tag, 0)} {}
+
+        [[nodiscard]] static constexpr Value fromBool(bool b) noexcept
+        {
+            Value result {};
+
+            result.bits = boxed(boolean_tag, b ? 1 : 0);
+
+            return result;
+        }
+
+        [[nodiscard]] static constexpr Value fromInteger(int64_t i) noexcept
+        {
+            Value result {};
+
+            result.bits = boxed(integer_tag, static_cast<uint64_t>(i));
+
+            return result;
+        }
+
+        [[nodiscard]] static constexpr Value fromDouble(double dbl) noexcept
+        {
+            Value result {};
+
+            result.bits = (dbl != dbl) ? canonical_nan : std::bit_cast<uint64_t>(dbl);
+
+            return result;
+        }
+
+        [[nodiscard]] static constexpr Value fromFunction(uint16_t function_id) noexcept
+        {
+            Value result {};
+
+            result.bits = boxed(function_tag, function_id);
+
+            return result;
+        }
+
+        [[nodiscard]] static Value fromObject(Object* object) noexcept
+        {
+            Value result {};
+
+            result.bits = boxed((object->kind == ObjectKind::string) ? string_tag : sequence_tag, reinterpret_cast<uintptr_t>(object));
+
+            return result;
+        }
+
+        [[nodiscard]] constexpr ValueTag getTag() const noexcept
+        {
+            if (!isBoxed())
+                return ValueTag::ndouble;
+
+            switch ((bits >> tag_shift) & 0x7)
+            {
+                case boolean_tag:
+                    return ValueTag::boolean;
+                case integer_tag:
+                    return ValueTag::integer;
+                case string_tag:
+                    return ValueTag::string;
+                case sequence_tag:
+                    return ValueTag::sequence;
+                case function_tag:
+                    return ValueTag::function;
+                default:
+                    return ValueTag::nil;
+            }
+        }
+
+        /// @brief The raw word. Equal words are equal values, except for Double zeros and NaN.
+        [[nodiscard]] constexpr uint64_t getBits() const noexcept { return bits; }
+
+        [[nodiscard]] constexpr bool isNil() const noexcept { return hasTag(nil_tag); }
+        [[nodiscard]] constexpr bool isBool() const noexcept { return hasTag(boolean_tag); }
+        [[nodiscard]] constexpr bool isInteger() const noexcept { return hasTag(integer_tag); }
+        [[nodiscard]] constexpr bool isDouble() const noexcept { return !isBoxed(); }
+        [[nodiscard]] constexpr bool isObject() const noexcept { return isString() || isSeq(); }
+        [[nodiscard]] constexpr bool isString() const noexcept { return hasTag(string_tag); }
+        [[nodiscard]] constexpr bool isSeq() const noexcept { return hasTag(sequence_tag); }
+        [[nodiscard]] constexpr bool isFunction() const noexcept { return hasTag(function_tag); }
+
+        [[nodiscard]] constexpr bool asBool() const noexcept { return (bits & 1) != 0; }
+        [[nodiscard]] constexpr int64_t asInteger() const noexcept { return static_cast<int64_t>(bits << 16) >> 16; }
+        [[nodiscard]] constexpr double asDouble() const noexcept { return std::bit_cast<double>(bits); }
+        [[nodiscard]] constexpr uint16_t asFunction() const noexcept { return static_cast<uint16_t>(bits); }
+        [[nodiscard]] Object* asObject() const noexcept { return reinterpret_cast<Object*>(bits & payload_mask); }
+        [[nodiscard]] StringObject* asString() const noexcept;
+        [[nodiscard]] SeqObject* asSeq() const noexcept;
+    };
+
+    static_assert(sizeof(Value) == 8);
+
+    struct StringObject : public Object
+    {
+        std::string text;
+
+        explicit StringObject(std::string text_arg)
+        : Object {ObjectKind::string}, text(std::move(text_arg)) {}
+    };
+
+    /// @brief How a Seq stores its items, in the order of SeqObject::items' alternatives.
+    enum class SeqKind : uint8_t
+    {
+        values,   // Strings, Seqs, mixed items, or no items
+        integers,
+        doubles,
+        booleans  // packed one bit per item
+    };
+
+    /**
+     * @brief Immutable sequence. Items that all are Integers, Doubles, or Booleans are stored unboxed and contiguously, so typed code and bulk builtins read them without tag checks.
+     */
+    struct SeqObject : public Object
+    {
+        std::variant<std::vector<Value>, std::vector<int64_t>, std::vector<double>, std::vector<bool>> items;
+
+        template <typename Storage>
+        explicit SeqObject(Storage item_args)
+        : Object {ObjectKind::sequence}, items {std::move(item_args)} {}
+
+        [[nodiscard]] SeqKind getKind() const noexcept
+        {
+            return static_cast<SeqKind>(items.index());
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return std::visit([](const auto& storage) { return storage.size(); }, items);
+        }
+
+        /// @brief Boxes the item at pos, which must be in range.
+        [[nodiscard]] Value at(size_t pos) const noexcept
+        {
+            switch (getKind())
+            {
+                case SeqKind::integers:
+                    return Value::fromInteger(std::get<std::vector<int64_t>>(items)[pos]);
+                case SeqKind::doubles:
+                    return Value::fromDouble(std::get<std::vector<double>>(items)[pos]);
+                case SeqKind::booleans:
+                    return Value::fromBool(std::get<std::vector<bool>>(items)[pos]);
+                case SeqKind::values:
+                default:
+                    return std::get<std::vector<Value>>(items)[pos];
+            }
+        }
+    };
+
+    inline StringObject* Value::asString() const noexcept
+    {
+        return static_cast<StringObject*>(asObject());
+    }
+
+    inline SeqObject* Value::asSeq() const noexcept
+    {
+        return static_cast<SeqObject*>(asObject());
+    }
+
+    enum class HeapKind : uint8_t
+    {
+        collected, // a VM's heap, freed from by collections
+        pinned     // a program's constants, which live as long as the heap
+    };
+
+    /**
+     * @brief Owns every string and sequence made while compiling or running. A collected heap frees the objects its owner no longer reaches once enough bytes were allocated since the last collection.
+     * @note The owner drives a collection: it marks every root with mark, then calls sweep. Objects of pinned heaps are never marked, and constant Seqs only hold constants, so marking stops at them.
+     */
+    class Heap
+    {
+    private:
+        /// @brief Collections are not worth their root scan below this many live bytes.
+        static constexpr size_t min_collection_bytes = 1 << 22;
+
+        std::vector<std::unique_ptr<Object>> objects;
+        std::vector<Object*> gray; // marked objects whose items are not marked yet
+        size_t live_bytes;         // bytes of every object held, counting the ones already garbage
+        size_t collection_bytes;   // live_bytes at which the next collection is due
+        HeapKind kind;
+
+        template <typename ObjectType>
+        [[nodiscard]] ObjectType* track(ObjectType* object);
+
+    public:
+        explicit Heap(HeapKind kind_arg = HeapKind::collected);
+
+        [[nodiscard]] StringObject* makeString(std::string text);
+        /// @brief Makes a Seq, unboxing the items when they all are Integers, all Doubles, or all Booleans.
+        [[nodiscard]] SeqObject* makeSeq(std::vector<Value> items);
+        [[nodiscard]] SeqObject* makeSeq(std::vector<int64_t> items);
+        [[nodiscard]] SeqObject* makeSeq(std::vector<double> items);
+        [[nodiscard]] SeqObject* makeSeq(std::vector<bool> items);
+        [[nodiscard]] size_t objectCount() const noexcept;
+
+        /// @brief True once a collected heap grew to twice what survived the last collection, and at least min_collection_bytes.
+        [[nodiscard]] bool isCollectionDue() const noexcept;
+
+        /// @brief Marks the object value refers to and everything its items reach, unless it is not an object or is pinned.
+        void mark(Value value);
+
+        /// @brief Frees every object not marked since the last sweep and clears the marks of the rest.
+        void sweep();
+
+        /// @brief Takes over every object of other, e.g a worker VM's results once the calling VM holds them.
+        void adopt(Heap& other);
+    };
+
+    /// @brief The language's name for a tag, e.g "Integer".
+    [[nodiscard]] std::string_view valueTagName(ValueTag tag) noexcept;
+
+    [[nodiscard]] bool valuesEqual(Value lhs, Value rhs) noexcept;
+
+    void printValue(std::ostream& out, Value value);
+}
+
+#endif
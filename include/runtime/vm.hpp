@@ -0,0 +1,120 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "runtime/bytecode.hpp"
+#include "runtime/threadpool.hpp"
+#include "runtime/value.hpp"
+
+namespace tisp::runtime
+{
+    enum class ExecStatus
+    {
+        ok,
+        runtime_error
+    };
+
+    enum class DispatchMode
+    {
+        switch_loop, // one shared switch jump, portable
+        threaded     // computed goto from handler to handler
+    };
+
+// The threaded loop is only compiled in when USE_COMPUTED_GOTO is on and the compiler supports computed goto.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(TISP_USE_COMPUTED_GOTO)
+#define TISP_HAS_COMPUTED_GOTO
+#endif
+
+#ifdef TISP_HAS_COMPUTED_GOTO
+    constexpr bool has_threaded_dispatch = true;
+    constexpr DispatchMode default_dispatch = DispatchMode::threaded;
+#else
+    constexpr bool has_threaded_dispatch = false;
+    constexpr DispatchMode default_dispatch = DispatchMode::switch_loop;
+#endif
+
+    struct CallFrame
+    {
+        const FunctionProto* function;
+        const Instruction* return_ip;
+        Value* base;
+    };
+
+    /**
+     * @brief Register-based bytecode interpreter. Every frame is a window into one register stack, and a call's arguments are already in the callee's first registers, so calls copy nothing.
+     */
+    class Vm
+    {
+    private:
+        Heap heap;
+        std::vector<Value> registers;
+        std::vector<Value> globals;
+        std::vector<CallFrame> frames;
+        std::ostream& out;
+        std::string error;
+        Value result;
+        const Program* program;
+        DispatchMode mode;
+        Value* reentry_base; // first register a builtin's call back into Tisp may use
+        Value* dirty_end; // every register from here on is nil
+        size_t reentry_depth; // calls back into Tisp running now, whose builtins may hold values in native locals
+        std::unique_ptr<ThreadPool> pool;
+        std::vector<std::unique_ptr<Vm>> workers;
+        size_t worker_count;
+        bool is_worker;
+
+        template <DispatchMode Mode>
+        [[nodiscard]] ExecStatus execute(const Program& program, uint16_t entry, Value* entry_base);
+
+        /// @brief Runs execute with the loop for mode, which is always the switch loop in a build without the threaded one.
+        [[nodiscard]] ExecStatus executeInMode(const Program& program, uint16_t entry, Value* entry_base);
+        [[nodiscard]] ExecStatus fail(const FunctionProto& where, std::string message);
+
+        /// @brief Collects the heap when it is due and no builtin is running Tisp. The roots are the registers up to the highest frame top, the globals, and result.
+        void collectIfDue(const FunctionProto& function, Value* base);
+
+    public:
+        static constexpr size_t default_register_limit = 1 << 18;
+
+        explicit Vm(std::ostream& out_arg, size_t register_limit = default_register_limit);
+
+        /// @brief Runs the module initializer, then main if there is one. Threaded dispatch falls back to the switch loop unless has_threaded_dispatch.
+        [[nodiscard]] ExecStatus run(const Program& program, DispatchMode mode = default_dispatch);
+
+        /// @brief The value returned by main.
+        [[nodiscard]] Value getResult() const noexcept;
+        [[nodiscard]] const std::string& getError() const noexcept;
+
+        [[nodiscard]] Heap& getHeap() noexcept;
+        [[nodiscard]] std::ostream& getOutput() noexcept;
+
+        /// @brief For builtins: records the message reported when they return false.
+        void reportError(std::string message);
+
+        /// @brief Sets the thread count of the parallel builtins, where 0 (the default) means one per hardware thread. Only counts before their first run.
+        void setWorkerCount(size_t count) noexcept;
+
+        /**
+         * @brief For builtins: calls a function of the running program, storing what it returns in returned. The call runs in the registers above the calling builtin's arguments, so it nests inside the running program.
+         * @note args must match the function's arity, and the caller checks them against FunctionProto::param_tags.
+         */
+        [[nodiscard]] ExecStatus call(uint16_t function_id, std::span<const Value> args, Value& returned);
+
+        /// @brief The program being run, for builtins taking functions.
+        [[nodiscard]] const Program& getProgram() const noexcept;
+
+        /// @brief For parallel builtins: the pool, made on first use with one worker VM per thread. Each worker VM gets the running program and a copy of this VM's globals, so it can call pure functions.
+        [[nodiscard]] ThreadPool& startWorkers();
+
+        [[nodiscard]] Vm& getWorker(size_t worker) noexcept;
+
+        /// @brief Worker VMs have no pool of their own, so parallel builtins nested in a worker run serially.
+        [[nodiscard]] bool isWorker() const noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file arena.cpp
+ * @author DrkWithT
+ * @brief Implements the AST bump allocator.
+ * @date 2024-05-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include "ast/arena.hpp"
+
+namespace tisp::ast
+{
+    /* AstArena private impl. */
+
+    void AstArena::grow(size_t min_size)
+    {
+        size_t block_size = std::max(next_block_size, min_size);
+
+        blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+        cursor = blocks.back().get();
+        block_end = cursor + block_size;
+
+        // Double the block size up to a cap so big modules need few blocks but tiny ones stay small.
+        next_block_size = std::min(next_block_size * 2, max_block_size);
+    }
+
+    /* AstArena public impl. */
+
+    AstArena::AstArena() noexcept
+    : blocks {}, cleanups {}, cursor {nullptr}, block_end {nullptr}, next_block_size {first_block_size}, used_bytes {0} {}
+
+    AstArena::~AstArena()
+    {
+        release();
+    }
+
+    AstArena::AstArena(AstArena&& other) noexcept
+    : blocks(std::move(other.blocks)), cleanups(std::move(other.cleanups)), cursor {std::exchange(other.cursor, nullptr)}, block_end {std::exchange(other.block_end, nullptr)}, next_block_size {std::exchange(other.next_block_size, first_block_size)}, used_bytes {std::exchange(other.used_bytes, 0)} {}
+
+    AstArena& AstArena::operator=(AstArena&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+
+            blocks = std::move(other.blocks);
+            cleanups = std::move(other.cleanups);
+            cursor = std::exchange(other.cursor, nullptr);
+            block_end = std::exchange(other.block_end, nullptr);
+            next_block_size = std::exchange(other.next_block_size, first_block_size);
+            used_bytes = std::exchange(other.used_bytes, 0);
+        }
+
+        return *this;
+    }
+
+    void* AstArena::allocate(size_t size, size_t alignment)
+    {
+        auto address = reinterpret_cast<uintptr_t>(cursor);
+        size_t padding = (alignment - address % alignment) % alignment;
+
+        if (cursor == nullptr || static_cast<size_t>(block_end - cursor) < padding + size)
+        {
+            grow(size + alignment);
+
+            address = reinterpret_cast<uintptr_t>(cursor);
+            padding = (alignment - address % alignment) % alignment;
+        }
+
+        std::byte* result = cursor + padding;
+
+        cursor = result + size;
+        used_bytes += padding + size;
+
+        return result;
+    }
+
+    void AstArena::release() noexcept
+    {
+        // Later nodes may point at earlier ones, so tear down in reverse.
+        for (auto cleanup = cleanups.rbegin(); cleanup != cleanups.rend(); cleanup++)
+            cleanup->destroy(cleanup->object);
+
+        cleanups.clear();
+        blocks.clear();
+        cursor = nullptr;
+        block_end = nullptr;
+        next_block_size = first_block_size;
+        used_bytes = 0;
+    }
+
+    size_t AstArena::bytesUsed() const noexcept
+    {
+        return used_bytes;
+    }
+}
@@ -0,0 +1,33 @@
+/**
+ * @file context.cpp
+ * @author DrkWithT
+ * @brief Implements the per-module AST owner.
+ * @date 2024-05-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "ast/context.hpp"
+
+namespace tisp::ast
+{
+    AstContext::AstContext() noexcept
+    : arena {}, node_count {0} {}
+
+    size_t AstContext::nodeCount() const noexcept
+    {
+        return node_count;
+    }
+
+    size_t AstContext::bytesUsed() const noexcept
+    {
+        return arena.bytesUsed();
+    }
+
+    void AstContext::clear() noexcept
+    {
+        arena.release();
+        node_count = 0;
+    }
+}
@@ -13,6 +13,46 @@
 
 namespace tisp::ast
 {
+    std::string_view dataTypeName(DataType type) noexcept
+    {
+        switch (type)
+        {
+            case DataType::boolean:
+                return "Boolean";
+            case DataType::integer:
+                return "Integer";
+            case DataType::ndouble:
+                return "Double";
+            case DataType::string:
+                return "String";
+            case DataType::sequence:
+                return "Seq";
+            case DataType::nil:
+                return "Nil";
+            case DataType::unknown:
+            default:
+                return "?";
+        }
+    }
+
+    DataType dataTypeFromName(std::string_view type_name) noexcept
+    {
+        if (type_name == "Boolean")
+            return DataType::boolean;
+        else if (type_name == "Integer")
+            return DataType::integer;
+        else if (type_name == "Double")
+            return DataType::ndouble;
+        else if (type_name == "String")
+            return DataType::string;
+        else if (type_name == "Seq")
+            return DataType::sequence;
+        else if (type_name == "Nil")
+            return DataType::nil;
+
+        return DataType::unknown;
+    }
+
     /* Sequence aggregate */
 
     Sequence::Sequence()
@@ -24,50 +64,88 @@ namespace tisp::ast
     /* Literal */
 
     Literal::Literal()
-    : value {Nil {}}, data_type {DataType::nil} {}
+    : IExpression {ExprKind::literal}, value {Nil {}}, data_type {DataType::nil} {}
 
     Literal::Literal(bool b)
-    : value {b}, data_type {DataType::boolean} {}
+    : IExpression {ExprKind::literal}, value {b}, data_type {DataType::boolean} {}
 
-    Literal::Literal(int i)
-    : value {i}, data_type {DataType::integer} {}
+    Literal::Literal(int64_t i)
+    : IExpression {ExprKind::literal}, value {i}, data_type {DataType::integer} {}
 
     Literal::Literal(double dbl)
-    : value {dbl}, data_type {DataType::ndouble} {}
+    : IExpression {ExprKind::literal}, value {dbl}, data_type {DataType::ndouble} {}
 
     Literal::Literal(std::string str)
-    : value {std::move(str)}, data_type {DataType::string} {}
+    : IExpression {ExprKind::literal}, value {std::move(str)}, data_type {DataType::string} {}
 
     Literal::Literal(Sequence seq)
-    : value {std::move(seq)}, data_type {DataType::sequence} {}
+    : IExpression {ExprKind::literal}, value {std::move(seq)}, data_type {DataType::sequence} {}
+
+    /* Unary */
+
+    Unary::Unary(const IExpression* arg, OpType op_arg, ExprList args_arg)
+    : IExpression {ExprKind::unary}, inner {arg}, args {args_arg}, op {op_arg} {}
 
-    constexpr DataType Literal::getDataType() const noexcept
+    const IExpression* Unary::getInner() const noexcept
     {
-        return data_type;
+        return inner;
     }
 
-    std::any Literal::acceptVisitor(IExprVisitor<std::any>& visitor) const
+    ExprList Unary::getArgs() const noexcept
     {
-        return visitor.visitLiteral(*this);
+        return args;
     }
 
-    /* Unary */
+    /* Binary */
 
-    Unary::Unary(std::unique_ptr<IExpression> arg, OpType op_arg)
-    : inner(std::move(arg)), op {op_arg} {}
+    Binary::Binary(const IExpression* lhs, const IExpression* rhs, OpType op_arg)
+    : IExpression {ExprKind::binary}, left {lhs}, right {rhs}, op {op_arg} {}
 
-    std::any Unary::acceptVisitor(IExprVisitor<std::any>& visitor) const
+    const IExpression* Binary::getLeft() const noexcept
     {
-        return visitor.visitUnary(*this);
+        return left;
     }
 
-    /* Binary */
+    const IExpression* Binary::getRight() const noexcept
+    {
+        return right;
+    }
 
-    Binary::Binary(std::unique_ptr<IExpression> lhs, std::unique_ptr<IExpression> rhs, OpType op_arg)
-    : left(std::move(lhs)), right(std::move(rhs)), op {op_arg} {}
+    [[nodiscard]] static bool isLogical(OpType op) noexcept
+    {
+        return op == OpType::logic_and || op == OpType::logic_or;
+    }
+
+    const IExpression* collectChain(const Binary& node, std::vector<const Binary*>& links)
+    {
+        bool logical = isLogical(node.getOpType());
+        const Binary* link = &node;
+
+        while (true)
+        {
+            links.push_back(link);
+
+            const IExpression* left = link->getLeft();
+
+            if (left->getKind() != ExprKind::binary || isLogical(static_cast<const Binary*>(left)->getOpType()) != logical)
+                return left;
+
+            link = static_cast<const Binary*>(left);
+        }
+    }
+
+    /* Name */
+
+    Name::Name(SymbolId name_arg, const Substitution* substitution_arg)
+    : IExpression {ExprKind::name}, name {name_arg}, substitution {substitution_arg} {}
+
+    SymbolId Name::getName() const noexcept
+    {
+        return name;
+    }
 
-    std::any Binary::acceptVisitor(IExprVisitor<std::any>& visitor) const
+    const Substitution* Name::getSubstitution() const noexcept
     {
-        return visitor.visitBinary(*this);
+        return substitution;
     }
 }
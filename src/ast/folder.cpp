@@ -0,0 +1,541 @@
+/**
+ * @file folder.cpp
+ * @author DrkWithT
+ * @brief Implements constant folding and dead branch removal over the AST.
+ * @date 2024-05-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast/folder.hpp"
+
+namespace tisp::ast
+{
+    /// @brief Counts the nodes of a subtree, so pruning can report what it removed.
+    class NodeCounter : public IExprVisitor<size_t>, public IStmtVisitor<size_t>
+    {
+    private:
+        [[nodiscard]] size_t count(const IExpression* expr)
+        {
+            return (expr != nullptr) ? expr->acceptVisitor<size_t>(*this) : 0;
+        }
+
+        [[nodiscard]] size_t countList(ExprList exprs)
+        {
+            size_t total = 0;
+
+            for (const auto* expr : exprs)
+                total += count(expr);
+
+            return total;
+        }
+
+    public:
+        [[nodiscard]] size_t count(const IStatement* stmt)
+        {
+            return (stmt != nullptr) ? stmt->acceptVisitor<size_t>(*this) : 0;
+        }
+
+        size_t visitLiteral([[maybe_unused]] const Literal& node) override { return 1; }
+        size_t visitUnary(const Unary& node) override { return 1 + count(node.getInner()) + countList(node.getArgs()); }
+        size_t visitName([[maybe_unused]] const Name& node) override { return 1; }
+
+        size_t visitVariable(const Variable& node) override { return 1 + count(node.getValue()); }
+        size_t visitMutation(const Mutation& node) override { return 1 + count(node.getExpression()); }
+        size_t visitFunction(const Function& node) override { return 1 + node.getParams().size() + count(node.getBody()); }
+        size_t visitParameter([[maybe_unused]] const Parameter& node) override { return 1; }
+        size_t visitCase(const Case& node) override { return 1 + count(node.getCondition()) + count(node.getBody()); }
+        size_t visitReturn(const Return& node) override { return 1 + count(node.getResult()); }
+        size_t visitWhile(const While& node) override { return 1 + count(node.getConditions()) + count(node.getBody()); }
+        size_t visitGeneric(const Generic& node) override { return 1 + count(node.getItem()); }
+        size_t visitSubstitution([[maybe_unused]] const Substitution& node) override { return 1; }
+        size_t visitImport([[maybe_unused]] const Import& node) override { return 1; }
+        size_t visitExprStmt(const ExprStmt& node) override { return 1 + count(node.getExpression()); }
+
+        size_t visitBinary(const Binary& node) override
+        {
+            size_t total = 0;
+            const IExpression* link = &node;
+
+            // Walks down the left spine of a chain instead of recursing once per operator.
+            while (link->getKind() == ExprKind::binary)
+            {
+                const auto& binary = static_cast<const Binary&>(*link);
+
+                total += 1 + count(binary.getRight());
+                link = binary.getLeft();
+            }
+
+            return total + count(link);
+        }
+
+        size_t visitBlock(const Block& node) override
+        {
+            size_t total = 1;
+
+            for (const auto* stmt : node.getStatements())
+                total += count(stmt);
+
+            return total;
+        }
+
+        size_t visitMatch(const Match& node) override
+        {
+            size_t total = 1 + count(node.getFallback());
+
+            for (const auto* stmt : node.getCases())
+                total += count(stmt);
+
+            return total;
+        }
+    };
+
+    [[nodiscard]] static size_t countNodes(const IStatement* stmt)
+    {
+        NodeCounter counter;
+
+        return counter.count(stmt);
+    }
+
+    [[nodiscard]] static bool isBoolLiteral(const IExpression* expr, bool value) noexcept
+    {
+        if (expr->getKind() != ExprKind::literal)
+            return false;
+
+        const auto& literal = static_cast<const Literal&>(*expr);
+
+        return literal.getDataType() == DataType::boolean && literal.toNativeType<bool>() == value;
+    }
+
+    template <typename Nt>
+    [[nodiscard]] static bool compareNative(OpType op, const Nt& lhs, const Nt& rhs) noexcept
+    {
+        switch (op)
+        {
+            case OpType::equality:
+                return lhs == rhs;
+            case OpType::inequality:
+                return lhs != rhs;
+            case OpType::lesser:
+                return lhs < rhs;
+            case OpType::atmost:
+                return lhs <= rhs;
+            case OpType::greater:
+                return lhs > rhs;
+            case OpType::atleast:
+            default:
+                return lhs >= rhs;
+        }
+    }
+
+    /// @brief Keeps the low 48 bits of a result computed with 64-bit wrapping, which is how the VM's Integer arithmetic wraps.
+    [[nodiscard]] static int64_t wrapInteger(uint64_t bits) noexcept
+    {
+        return static_cast<int64_t>(bits << 16) >> 16;
+    }
+
+    [[nodiscard]] static bool isComparison(OpType op) noexcept
+    {
+        return op == OpType::equality || op == OpType::inequality || op == OpType::lesser || op == OpType::atmost || op == OpType::greater || op == OpType::atleast;
+    }
+
+    /* ConstantFolder private impl. */
+
+    const IExpression* ConstantFolder::fold(const IExpression* expr)
+    {
+        // Past the nesting limit the subtree is left as written for the compiler to reject.
+        if (expr == nullptr || depth >= max_nesting_depth)
+            return expr;
+
+        depth++;
+
+        const IExpression* folded = expr->acceptVisitor<const IExpression*>(*this);
+
+        depth--;
+
+        return folded;
+    }
+
+    const IStatement* ConstantFolder::foldBody(const IStatement* body)
+    {
+        if (depth >= max_nesting_depth)
+            return body;
+
+        depth++;
+
+        const IStatement* folded = body->acceptVisitor<const IStatement*>(*this);
+
+        depth--;
+
+        // A removed body still needs a node, and an empty block compiles to nothing.
+        return (folded != nullptr) ? folded : context.make<Block>(StmtList {});
+    }
+
+    const Literal* ConstantFolder::foldBinary(OpType op, const Literal& lhs, const Literal& rhs)
+    {
+        DataType type = lhs.getDataType();
+
+        // Mixed operands are a type error, which the checker should still see.
+        if (type != rhs.getDataType())
+            return nullptr;
+
+        if (op == OpType::logic_and || op == OpType::logic_or)
+        {
+            if (type != DataType::boolean)
+                return nullptr;
+
+            bool result = (op == OpType::logic_and) ? (lhs.toNativeType<bool>() && rhs.toNativeType<bool>()) : (lhs.toNativeType<bool>() || rhs.toNativeType<bool>());
+
+            return context.make<Literal>(result);
+        }
+
+        if (isComparison(op))
+        {
+            bool is_equality = op == OpType::equality || op == OpType::inequality;
+
+            switch (type)
+            {
+                case DataType::integer:
+                    return context.make<Literal>(compareNative(op, lhs.toNativeType<int64_t>(), rhs.toNativeType<int64_t>()));
+                case DataType::ndouble:
+                    return context.make<Literal>(compareNative(op, lhs.toNativeType<double>(), rhs.toNativeType<double>()));
+                case DataType::string:
+                    return context.make<Literal>(compareNative(op, lhs.toNativeType<std::string>(), rhs.toNativeType<std::string>()));
+                case DataType::boolean:
+                    return is_equality ? context.make<Literal>(compareNative(op, lhs.toNativeType<bool>(), rhs.toNativeType<bool>())) : nullptr;
+                case DataType::nil:
+                    return is_equality ? context.make<Literal>(op == OpType::equality) : nullptr;
+                default:
+                    return nullptr;
+            }
+        }
+
+        if (type == DataType::integer)
+        {
+            auto a = static_cast<uint64_t>(lhs.toNativeType<int64_t>());
+            auto b = static_cast<uint64_t>(rhs.toNativeType<int64_t>());
+
+            switch (op)
+            {
+                case OpType::plus:
+                    return context.make<Literal>(wrapInteger(a + b));
+                case OpType::minus:
+                    return context.make<Literal>(wrapInteger(a - b));
+                case OpType::times:
+                    return context.make<Literal>(wrapInteger(a * b));
+                case OpType::slash:
+                    // Division by zero stays a runtime error.
+                    if (b == 0)
+                        return nullptr;
+
+                    // 48-bit operands cannot overflow a 64-bit quotient.
+                    return context.make<Literal>(wrapInteger(static_cast<uint64_t>(lhs.toNativeType<int64_t>() / rhs.toNativeType<int64_t>())));
+                default:
+                    return nullptr;
+            }
+        }
+
+        if (type == DataType::ndouble)
+        {
+            double a = lhs.toNativeType<double>();
+            double b = rhs.toNativeType<double>();
+
+            switch (op)
+            {
+                case OpType::plus:
+                    return context.make<Literal>(a + b);
+                case OpType::minus:
+                    return context.make<Literal>(a - b);
+                case OpType::times:
+                    return context.make<Literal>(a * b);
+                case OpType::slash:
+                    return context.make<Literal>(a / b);
+                default:
+                    return nullptr;
+            }
+        }
+
+        if (type == DataType::string && op == OpType::plus)
+            return context.make<Literal>(lhs.toNativeType<std::string>() + rhs.toNativeType<std::string>());
+
+        return nullptr;
+    }
+
+    const Literal* ConstantFolder::foldNegate(const Literal& inner)
+    {
+        if (inner.getDataType() == DataType::ndouble)
+            return context.make<Literal>(-inner.toNativeType<double>());
+
+        if (inner.getDataType() == DataType::integer)
+            return context.make<Literal>(wrapInteger(0 - static_cast<uint64_t>(inner.toNativeType<int64_t>())));
+
+        return nullptr;
+    }
+
+    /* ConstantFolder public impl. */
+
+    ConstantFolder::ConstantFolder(AstContext& context_arg) noexcept
+    : context {context_arg}, stats {.folded_exprs = 0, .pruned_cases = 0, .removed_loops = 0, .removed_nodes = 0}, chain {}, depth {0} {}
+
+    StmtList ConstantFolder::foldModule(StmtList top_level)
+    {
+        std::vector<const IStatement*> folded;
+
+        folded.reserve(top_level.size());
+
+        for (const auto* stmt : top_level)
+        {
+            if (const IStatement* result = stmt->acceptVisitor<const IStatement*>(*this); result != nullptr)
+                folded.push_back(result);
+        }
+
+        return context.makeList(folded);
+    }
+
+    const FoldStats& ConstantFolder::getStats() const noexcept
+    {
+        return stats;
+    }
+
+    /* Expressions */
+
+    const IExpression* ConstantFolder::visitLiteral(const Literal& node)
+    {
+        return &node;
+    }
+
+    const IExpression* ConstantFolder::visitUnary(const Unary& node)
+    {
+        const IExpression* inner = fold(node.getInner());
+
+        if (node.getOpType() == OpType::minus && inner->getKind() == ExprKind::literal)
+        {
+            if (const Literal* folded = foldNegate(static_cast<const Literal&>(*inner)); folded != nullptr)
+            {
+                stats.folded_exprs++;
+                stats.removed_nodes++;
+
+                return folded;
+            }
+        }
+
+        ExprList args = node.getArgs();
+        std::vector<const IExpression*> folded_args;
+        bool changed = inner != node.getInner();
+
+        folded_args.reserve(args.size());
+
+        for (const auto* arg : args)
+        {
+            folded_args.push_back(fold(arg));
+            changed = changed || folded_args.back() != arg;
+        }
+
+        if (!changed)
+            return &node;
+
+        return context.make<Unary>(inner, node.getOpType(), context.makeList(folded_args));
+    }
+
+    const IExpression* ConstantFolder::visitBinary(const Binary& node)
+    {
+        size_t chain_mark = chain.size();
+        const IExpression* first = collectChain(node, chain);
+        size_t chain_end = chain.size();
+        const IExpression* lhs = fold(first);
+
+        for (size_t link_pos = chain_end; link_pos-- > chain_mark;)
+        {
+            const Binary* link = chain[link_pos];
+            const IExpression* rhs = fold(link->getRight());
+
+            if (lhs->getKind() == ExprKind::literal && rhs->getKind() == ExprKind::literal)
+            {
+                if (const Literal* folded = foldBinary(link->getOpType(), static_cast<const Literal&>(*lhs), static_cast<const Literal&>(*rhs)); folded != nullptr)
+                {
+                    stats.folded_exprs++;
+                    stats.removed_nodes += 2;
+                    lhs = folded;
+                    continue;
+                }
+            }
+
+            lhs = (lhs == link->getLeft() && rhs == link->getRight()) ? link : context.make<Binary>(lhs, rhs, link->getOpType());
+        }
+
+        chain.resize(chain_mark);
+
+        return lhs;
+    }
+
+    const IExpression* ConstantFolder::visitName(const Name& node)
+    {
+        return &node;
+    }
+
+    /* Statements */
+
+    const IStatement* ConstantFolder::visitVariable(const Variable& node)
+    {
+        const IExpression* value = fold(node.getValue());
+
+        return (value == node.getValue()) ? &node : context.make<Variable>(node.getName(), value, node.getDataType(), node.isMutable(), node.getTypeName());
+    }
+
+    const IStatement* ConstantFolder::visitMutation(const Mutation& node)
+    {
+        const IExpression* value = fold(node.getExpression());
+
+        return (value == node.getExpression()) ? &node : context.make<Mutation>(node.getName(), value);
+    }
+
+    const IStatement* ConstantFolder::visitFunction(const Function& node)
+    {
+        const IStatement* body = foldBody(node.getBody());
+
+        return (body == node.getBody()) ? &node : context.make<Function>(node.getName(), node.getParams(), body, node.getDataType(), node.getTypeName());
+    }
+
+    const IStatement* ConstantFolder::visitParameter(const Parameter& node)
+    {
+        return &node;
+    }
+
+    const IStatement* ConstantFolder::visitBlock(const Block& node)
+    {
+        StmtList stmts = node.getStatements();
+        std::vector<const IStatement*> folded;
+        bool changed = false;
+
+        folded.reserve(stmts.size());
+
+        for (const auto* stmt : stmts)
+        {
+            const IStatement* result = stmt->acceptVisitor<const IStatement*>(*this);
+
+            changed = changed || result != stmt;
+
+            if (result != nullptr)
+                folded.push_back(result);
+        }
+
+        return changed ? context.make<Block>(context.makeList(folded)) : &node;
+    }
+
+    const IStatement* ConstantFolder::visitMatch(const Match& node)
+    {
+        StmtList cases = node.getCases();
+        std::vector<const IStatement*> kept;
+        const IStatement* fallback = node.getFallback();
+        bool changed = false;
+
+        kept.reserve(cases.size());
+
+        for (size_t case_pos = 0; case_pos < cases.size(); case_pos++)
+        {
+            const auto& match_case = static_cast<const Case&>(*cases[case_pos]);
+            const IExpression* condition = fold(match_case.getCondition());
+
+            // The condition already folded to one literal, and its operands were counted then.
+            if (isBoolLiteral(condition, false))
+            {
+                stats.pruned_cases++;
+                stats.removed_nodes += 2 + countNodes(match_case.getBody());
+                changed = true;
+                continue;
+            }
+
+            if (isBoolLiteral(condition, true))
+            {
+                // Nothing after an always-taken case can run, and the case itself becomes the fallback.
+                for (size_t dead_pos = case_pos + 1; dead_pos < cases.size(); dead_pos++)
+                {
+                    stats.pruned_cases++;
+                    stats.removed_nodes += countNodes(cases[dead_pos]);
+                }
+
+                stats.pruned_cases++;
+                stats.removed_nodes += countNodes(fallback) + 2;
+                fallback = foldBody(match_case.getBody());
+                changed = true;
+                break;
+            }
+
+            const IStatement* body = foldBody(match_case.getBody());
+
+            if (condition == match_case.getCondition() && body == match_case.getBody())
+                kept.push_back(&match_case);
+            else
+            {
+                kept.push_back(context.make<Case>(condition, body));
+                changed = true;
+            }
+        }
+
+        if (fallback != nullptr && fallback == node.getFallback())
+            fallback = foldBody(fallback);
+
+        if (!changed && fallback == node.getFallback())
+            return &node;
+
+        // The Match itself stays even with no cases left, so the compiler still scopes its bodies and checks the input name.
+        return context.make<Match>(node.getName(), context.makeList(kept), fallback);
+    }
+
+    const IStatement* ConstantFolder::visitCase(const Case& node)
+    {
+        return &node;
+    }
+
+    const IStatement* ConstantFolder::visitReturn(const Return& node)
+    {
+        const IExpression* result = fold(node.getResult());
+
+        return (result == node.getResult()) ? &node : context.make<Return>(result);
+    }
+
+    const IStatement* ConstantFolder::visitWhile(const While& node)
+    {
+        const IExpression* condition = fold(node.getConditions());
+
+        if (isBoolLiteral(condition, false))
+        {
+            stats.removed_loops++;
+            stats.removed_nodes += 2 + countNodes(node.getBody());
+
+            return nullptr;
+        }
+
+        const IStatement* body = foldBody(node.getBody());
+
+        return (condition == node.getConditions() && body == node.getBody()) ? &node : context.make<While>(condition, body);
+    }
+
+    const IStatement* ConstantFolder::visitGeneric(const Generic& node)
+    {
+        const IStatement* item = foldBody(node.getItem());
+
+        return (item == node.getItem()) ? &node : context.make<Generic>(node.getParams(), item);
+    }
+
+    const IStatement* ConstantFolder::visitSubstitution(const Substitution& node)
+    {
+        return &node;
+    }
+
+    const IStatement* ConstantFolder::visitImport(const Import& node)
+    {
+        return &node;
+    }
+
+    const IStatement* ConstantFolder::visitExprStmt(const ExprStmt& node)
+    {
+        const IExpression* expr = fold(node.getExpression());
+
+        return (expr == node.getExpression()) ? &node : context.make<ExprStmt>(expr);
+    }
+}
@@ -8,72 +8,71 @@
  * 
  */
 
-#include <utility>
 #include "ast/stmts.hpp"
 
 namespace tisp::ast
 {
     /* Variable */
 
-    Variable::Variable(std::string name_arg, std::unique_ptr<IExpression> rv_arg, DataType type_arg, bool is_var)
-    : name(std::move(name_arg)), rv(std::move(rv_arg)), type {type_arg}, is_mutable {is_var} {}
+    Variable::Variable(SymbolId name_arg, const IExpression* rv_arg, DataType type_arg, bool is_var, SymbolId type_name_arg)
+    : IStatement {StmtKind::variable}, name {name_arg}, rv {rv_arg}, type {type_arg}, type_name {type_name_arg}, is_mutable {is_var} {}
 
-    const std::string& Variable::getName() const noexcept
+    SymbolId Variable::getName() const noexcept
     {
         return name;
     }
 
+    const IExpression* Variable::getValue() const noexcept
+    {
+        return rv;
+    }
+
     DataType Variable::getDataType() const noexcept
     {
         return type;
     }
 
-    bool Variable::isMutable() const noexcept
+    SymbolId Variable::getTypeName() const noexcept
     {
-        return is_mutable;
+        return type_name;
     }
 
-    std::any Variable::acceptVisitor(IStmtVisitor<std::any>& visitor) const
+    bool Variable::isMutable() const noexcept
     {
-        return visitor.visitVariable(*this);
+        return is_mutable;
     }
 
     /* Mutation */
 
-    Mutation::Mutation(std::string name_arg, std::unique_ptr<IExpression> rv_arg)
-    : name(std::move(name_arg)), rv(std::move(rv_arg)) {}
+    Mutation::Mutation(SymbolId name_arg, const IExpression* rv_arg)
+    : IStatement {StmtKind::mutation}, name {name_arg}, rv {rv_arg} {}
 
-    const std::string& Mutation::getName() const noexcept
+    SymbolId Mutation::getName() const noexcept
     {
         return name;
     }
 
-    const std::unique_ptr<IExpression>& Mutation::getExpression() const noexcept
+    const IExpression* Mutation::getExpression() const noexcept
     {
         return rv;
     }
 
-    std::any Mutation::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitMutation(*this);
-    }
-
     /* Function */
 
-    Function::Function(std::string name_arg, std::vector<std::unique_ptr<IStatement>> params_arg, std::unique_ptr<IStatement> body_arg, DataType type_arg)
-    : name(std::move(name_arg)), params(std::move(params_arg)), body(std::move(body_arg)), type {type_arg} {}
+    Function::Function(SymbolId name_arg, StmtList params_arg, const IStatement* body_arg, DataType type_arg, SymbolId type_name_arg)
+    : IStatement {StmtKind::function}, name {name_arg}, params {params_arg}, body {body_arg}, type {type_arg}, type_name {type_name_arg} {}
 
-    const std::string& Function::getName() const noexcept
+    SymbolId Function::getName() const noexcept
     {
         return name;
     }
 
-    const std::vector<std::unique_ptr<IStatement>>& Function::getParams() const noexcept
+    StmtList Function::getParams() const noexcept
     {
         return params;
     }
 
-    const std::unique_ptr<IStatement>& Function::getBody() const noexcept
+    const IStatement* Function::getBody() const noexcept
     {
         return body;
     }
@@ -83,17 +82,17 @@ namespace tisp::ast
         return type;
     }
 
-    [[nodiscard]] std::any Function::acceptVisitor(IStmtVisitor<std::any> &visitor) const
+    SymbolId Function::getTypeName() const noexcept
     {
-        return visitor.visitFunction(*this);
+        return type_name;
     }
 
     /* Parameter */
 
-    Parameter::Parameter(std::string name_arg, DataType type_arg)
-    : name(std::move(name_arg)), type {type_arg} {}
+    Parameter::Parameter(SymbolId name_arg, DataType type_arg, SymbolId type_name_arg)
+    : IStatement {StmtKind::parameter}, name {name_arg}, type {type_arg}, type_name {type_name_arg} {}
 
-    const std::string& Parameter::getName() const noexcept
+    SymbolId Parameter::getName() const noexcept
     {
         return name;
     }
@@ -103,153 +102,128 @@ namespace tisp::ast
         return type;
     }
 
-    std::any Parameter::acceptVisitor(IStmtVisitor<std::any>& visitor) const
+    SymbolId Parameter::getTypeName() const noexcept
     {
-        return visitor.visitParameter(*this);
+        return type_name;
     }
 
     /* Block */
 
-    Block::Block(std::vector<std::unique_ptr<IStatement>> stmts_arg)
-    : stmts(std::move(stmts_arg)) {}
+    Block::Block(StmtList stmts_arg)
+    : IStatement {StmtKind::block}, stmts {stmts_arg} {}
 
-    const std::vector<std::unique_ptr<IStatement>>& Block::getStatements() const noexcept
+    StmtList Block::getStatements() const noexcept
     {
         return stmts;
     }
 
-    std::any Block::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitBlock(*this);
-    }
-
     /* Match */
 
-    Match::Match(std::string input_arg, std::vector<std::unique_ptr<IStatement>> cases_arg, std::unique_ptr<IStatement> fallback_arg)
-    : input_name(std::move(input_arg)), cases(std::move(cases_arg)), fallback(std::move(fallback_arg)) {}
+    Match::Match(SymbolId input_arg, StmtList cases_arg, const IStatement* fallback_arg)
+    : IStatement {StmtKind::match}, input_name {input_arg}, cases {cases_arg}, fallback {fallback_arg} {}
 
-    const std::string& Match::getName() const noexcept
+    SymbolId Match::getName() const noexcept
     {
         return input_name;
     }
 
-    const std::vector<std::unique_ptr<IStatement>>& Match::getCases() const noexcept
+    StmtList Match::getCases() const noexcept
     {
         return cases;
     }
 
-    const std::unique_ptr<IStatement>& Match::getFallback() const noexcept
+    const IStatement* Match::getFallback() const noexcept
     {
         return fallback;
     }
 
-    std::any Match::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitMatch(*this);
-    }
-
     /* Case */
 
-    Case::Case(std::unique_ptr<IExpression> condition_arg, std::unique_ptr<IStatement> body_arg)
-    : condition(std::move(condition_arg)), body(std::move(body_arg)) {}
+    Case::Case(const IExpression* condition_arg, const IStatement* body_arg)
+    : IStatement {StmtKind::match_case}, condition {condition_arg}, body {body_arg} {}
 
-    const std::unique_ptr<IExpression>& Case::getCondition() const noexcept
+    const IExpression* Case::getCondition() const noexcept
     {
         return condition;
     }
 
-    const std::unique_ptr<IStatement>& Case::getBody() const noexcept
+    const IStatement* Case::getBody() const noexcept
     {
         return body;
     }
 
-    std::any Case::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitCase(*this);
-    }
-
     /* Return */
 
-    Return::Return(std::unique_ptr<IExpression> result_arg)
-    : result(std::move(result_arg)) {}
+    Return::Return(const IExpression* result_arg)
+    : IStatement {StmtKind::return_value}, result {result_arg} {}
 
-    const std::unique_ptr<IExpression>& Return::getResult() const noexcept
+    const IExpression* Return::getResult() const noexcept
     {
         return result;
     }
 
-    std::any Return::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitReturn(*this);
-    }
-
     /* While */
 
-    While::While(std::unique_ptr<IExpression> conditions_arg, std::unique_ptr<IStatement> body_arg)
-    : conditions(std::move(conditions_arg)), body(std::move(body_arg)) {}
+    While::While(const IExpression* conditions_arg, const IStatement* body_arg)
+    : IStatement {StmtKind::while_loop}, conditions {conditions_arg}, body {body_arg} {}
 
-    const std::unique_ptr<IExpression>& While::getConditions() const noexcept
+    const IExpression* While::getConditions() const noexcept
     {
         return conditions;
     }
 
-    const std::unique_ptr<IStatement>& While::getBody() const noexcept
+    const IStatement* While::getBody() const noexcept
     {
         return body;
     }
 
-    std::any While::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitWhile(*this);
-    }
-
     /* Generic */
 
-    Generic::Generic(std::vector<std::string> params_arg, std::unique_ptr<IStatement> item_arg)
-    : params(std::move(params_arg)), item(std::move(item_arg)) {}
+    Generic::Generic(SymbolList params_arg, const IStatement* item_arg)
+    : IStatement {StmtKind::generic}, params {params_arg}, item {item_arg} {}
 
-    const std::vector<std::string>& Generic::getParams() const noexcept
+    SymbolList Generic::getParams() const noexcept
     {
         return params;
     }
 
-    const std::unique_ptr<IStatement>& Generic::getItem() const noexcept
+    const IStatement* Generic::getItem() const noexcept
     {
         return item;
     }
 
-    std::any Generic::acceptVisitor(IStmtVisitor<std::any>& visitor) const
-    {
-        return visitor.visitGeneric(*this);
-    }
-
     /* Substitution */
 
-    Substitution::Substitution(std::string name_arg, std::vector<std::string> tname_args)
-    : name(std::move(name_arg)), type_names(std::move(tname_args)) {}
+    Substitution::Substitution(SymbolId name_arg, SymbolList tname_args)
+    : IStatement {StmtKind::substitution}, name {name_arg}, type_names {tname_args} {}
 
-    const std::string& Substitution::getName() const noexcept
+    SymbolId Substitution::getName() const noexcept
     {
         return name;
     }
 
-    const std::vector<std::string>& Substitution::getTypeNames() const noexcept
+    SymbolList Substitution::getTypeNames() const noexcept
     {
         return type_names;
     }
 
-    std::any Substitution::acceptVisitor(IStmtVisitor<std::any>& visitor) const
+    /* Import */
+
+    Import::Import(SymbolList item_path_arg)
+    : IStatement {StmtKind::import}, item_path {item_path_arg} {}
+
+    SymbolList Import::getItemPath() const noexcept
     {
-        return visitor.visitSubstitution(*this);
+        return item_path;
     }
 
-    /* Import */
+    /* ExprStmt */
 
-    Import::Import(std::vector<std::string> item_path_arg)
-    : item_path(std::move(item_path_arg)) {}
+    ExprStmt::ExprStmt(const IExpression* expr_arg)
+    : IStatement {StmtKind::expr_stmt}, expr {expr_arg} {}
 
-    std::any Import::acceptVisitor(IStmtVisitor<std::any>& visitor) const
+    const IExpression* ExprStmt::getExpression() const noexcept
     {
-        return visitor.visitImport(*this);
+        return expr;
     }
 }
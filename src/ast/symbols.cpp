@@ -0,0 +1,74 @@
+/**
+ * @file symbols.cpp
+ * @author DrkWithT
+ * @brief Implements the identifier interner.
+ * @date 2024-05-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ast/symbols.hpp"
+
+namespace tisp::ast
+{
+    /* SymbolTable private impl. */
+
+    std::string_view SymbolTable::store(std::string_view text)
+    {
+        if (text.length() > block_left)
+        {
+            size_t new_size = std::max(block_size, text.length());
+
+            blocks.push_back(std::make_unique_for_overwrite<char[]>(new_size));
+            block_cursor = blocks.back().get();
+            block_left = new_size;
+        }
+
+        char* stored = block_cursor;
+
+        std::memcpy(stored, text.data(), text.length());
+        block_cursor += text.length();
+        block_left -= text.length();
+
+        return {stored, text.length()};
+    }
+
+    /* SymbolTable public impl. */
+
+    SymbolTable::SymbolTable()
+    : blocks {}, ids {}, names {}, block_cursor {nullptr}, block_left {0} {}
+
+    SymbolId SymbolTable::intern(std::string_view text)
+    {
+        if (auto found = ids.find(text); found != ids.end())
+            return found->second;
+
+        auto id = static_cast<SymbolId>(names.size());
+        std::string_view stored = store(text);
+
+        names.push_back(stored);
+        ids.emplace(stored, id);
+
+        return id;
+    }
+
+    SymbolId SymbolTable::find(std::string_view text) const
+    {
+        auto found = ids.find(text);
+
+        return (found != ids.end()) ? found->second : no_symbol;
+    }
+
+    std::string_view SymbolTable::nameOf(SymbolId id) const noexcept
+    {
+        return (id < names.size()) ? names[id] : std::string_view {};
+    }
+
+    size_t SymbolTable::size() const noexcept
+    {
+        return names.size();
+    }
+}
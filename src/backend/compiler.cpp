@@ -0,0 +1,1427 @@
+/**
+ * @file compiler.cpp
+ * @author DrkWithT
+ * @brief Implements the AST to register bytecode compiler.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <any>
+#include <optional>
+#include <span>
+#include <utility>
+#include "ast/context.hpp"
+#include "ast/exprs.hpp"
+#include "runtime/builtins.hpp"
+#include "backend/compiler.hpp"
+
+namespace tisp::backend
+{
+    using runtime::Instruction;
+    using runtime::Opcode;
+    using runtime::Value;
+
+    /// @brief Thrown after an error is recorded to abandon the current function.
+    struct CompileFailure {};
+
+    static constexpr unsigned max_registers = 255;
+
+    /* Match dispatch */
+
+    /// @brief Smaller matches on Integers or Strings stay compare-and-branch chains, which are as short as any dispatch for them.
+    static constexpr size_t min_dispatch_cases = 4;
+
+    /// @brief A switch_int table is used for at most this many keys, and at most max_table_spread keys per segment it covers.
+    static constexpr int64_t max_table_span = 1024;
+    static constexpr int64_t max_table_spread = 3;
+
+    /// @brief A case condition comparing the matched name with a literal, normalized so that the name is on the left.
+    struct CaseTest
+    {
+        ast::OpType op;
+        const ast::Literal* literal;
+    };
+
+    /// @brief The Integers lo to hi that all select one arm. Arm cases.size() is the default.
+    struct Segment
+    {
+        int64_t lo;
+        int64_t hi;
+        size_t arm;
+    };
+
+    [[nodiscard]] static ast::OpType flipComparison(ast::OpType op) noexcept
+    {
+        switch (op)
+        {
+            case ast::OpType::greater:
+                return ast::OpType::lesser;
+            case ast::OpType::lesser:
+                return ast::OpType::greater;
+            case ast::OpType::atmost:
+                return ast::OpType::atleast;
+            case ast::OpType::atleast:
+                return ast::OpType::atmost;
+            default:
+                return op;
+        }
+    }
+
+    [[nodiscard]] static std::optional<CaseTest> caseTestOf(const ast::IExpression* condition, ast::SymbolId input)
+    {
+        if (condition->getKind() != ast::ExprKind::binary)
+            return {};
+
+        const auto& binary = static_cast<const ast::Binary&>(*condition);
+        ast::OpType op = binary.getOpType();
+
+        // Comparisons are declared together, from equality to atleast.
+        if (op < ast::OpType::equality || op > ast::OpType::atleast)
+            return {};
+
+        auto is_input = [input](const ast::IExpression* expr) {
+            return expr->getKind() == ast::ExprKind::name && static_cast<const ast::Name&>(*expr).getName() == input;
+        };
+
+        if (is_input(binary.getLeft()) && binary.getRight()->getKind() == ast::ExprKind::literal)
+            return CaseTest {.op = op, .literal = static_cast<const ast::Literal*>(binary.getRight())};
+
+        if (binary.getLeft()->getKind() == ast::ExprKind::literal && is_input(binary.getRight()))
+            return CaseTest {.op = flipComparison(op), .literal = static_cast<const ast::Literal*>(binary.getLeft())};
+
+        return {};
+    }
+
+    /// @brief Whether an Integer or Boolean test holds for key, with Booleans as 0 and 1.
+    [[nodiscard]] static bool testAccepts(const CaseTest& test, int64_t key) noexcept
+    {
+        int64_t value = (test.literal->getDataType() == ast::DataType::boolean) ? test.literal->toNativeType<bool>() : test.literal->toNativeType<int64_t>();
+
+        switch (test.op)
+        {
+            case ast::OpType::equality:
+                return key == value;
+            case ast::OpType::inequality:
+                return key != value;
+            case ast::OpType::greater:
+                return key > value;
+            case ast::OpType::atmost:
+                return key <= value;
+            case ast::OpType::lesser:
+                return key < value;
+            case ast::OpType::atleast:
+            default:
+                return key >= value;
+        }
+    }
+
+    /// @brief The arm the match takes for key: its first case that holds, as a chain would find it.
+    [[nodiscard]] static size_t armFor(std::span<const CaseTest> tests, int64_t key) noexcept
+    {
+        for (size_t test_pos = 0; test_pos < tests.size(); test_pos++)
+        {
+            if (testAccepts(tests[test_pos], key))
+                return test_pos;
+        }
+
+        return tests.size();
+    }
+
+    /// @brief Splits the Integer range into segments that each select one arm, merging neighbors with the same arm.
+    [[nodiscard]] static std::vector<Segment> segmentCases(std::span<const CaseTest> tests)
+    {
+        // A test against k can only change its answer at k and at k + 1, which does not exist past max_integer.
+        std::vector<int64_t> bounds {Value::min_integer};
+
+        for (const auto& test : tests)
+        {
+            int64_t value = test.literal->toNativeType<int64_t>();
+
+            bounds.push_back(value);
+
+            if (value < Value::max_integer)
+                bounds.push_back(value + 1);
+        }
+
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        std::vector<Segment> segments;
+
+        for (size_t bound_pos = 0; bound_pos < bounds.size(); bound_pos++)
+        {
+            int64_t hi = (bound_pos + 1 < bounds.size()) ? bounds[bound_pos + 1] - 1 : Value::max_integer;
+            size_t arm = armFor(tests, bounds[bound_pos]);
+
+            if (!segments.empty() && segments.back().arm == arm)
+                segments.back().hi = hi;
+            else
+                segments.push_back({.lo = bounds[bound_pos], .hi = hi, .arm = arm});
+        }
+
+        return segments;
+    }
+
+    /* FunctionCompiler */
+
+    /**
+     * @brief Emits the code of one function. Locals own registers 0 to locals.size() - 1 in declaration order, and temporaries are stacked above them and freed after each statement.
+     *
+     * Expression visitors write their result into target. Every visitor writes target with its last instruction, so target may be a local that the expression also reads.
+     */
+    class FunctionCompiler : public ast::IExprVisitor<void>, public ast::IStmtVisitor<void>
+    {
+    private:
+        struct Local
+        {
+            ast::SymbolId name;
+            ast::DataType type;
+            bool is_mutable;
+        };
+
+        Compiler& module;
+        runtime::Program& program;
+        const TypeTable& types;
+        TypeBindings bindings;
+        std::vector<Local> locals;
+        uint16_t function_id;
+        ast::DataType return_type;
+        unsigned free_reg;
+        unsigned max_reg;
+        uint8_t target;
+        bool tail_position;
+        size_t depth; // nesting of the expression or body being compiled
+        std::vector<const ast::Binary*> chain; // links of the operator chains being compiled, each chain above the mark of the one containing it
+
+        [[nodiscard]] runtime::FunctionProto& proto() noexcept
+        {
+            return program.functions[function_id];
+        }
+
+        [[nodiscard]] std::string nameOf(ast::SymbolId name) const
+        {
+            return std::string {module.symbols.nameOf(name)};
+        }
+
+        [[noreturn]] void fail(std::string message)
+        {
+            module.errors.push_back({.message = "in " + proto().name + ": " + std::move(message)});
+
+            throw CompileFailure {};
+        }
+
+        size_t emit(Instruction code)
+        {
+            proto().code.push_back(code);
+
+            return proto().code.size() - 1;
+        }
+
+        [[nodiscard]] uint8_t allocRegister()
+        {
+            if (free_reg >= max_registers)
+                fail("needs more than 255 registers");
+
+            auto reg = static_cast<uint8_t>(free_reg++);
+
+            max_reg = std::max(max_reg, free_reg);
+
+            return reg;
+        }
+
+        [[nodiscard]] bool isLocalRegister(uint8_t reg) const noexcept
+        {
+            return reg < locals.size();
+        }
+
+        /// @brief Returns the register of the innermost local with this name, or -1.
+        [[nodiscard]] int findLocal(ast::SymbolId name) const noexcept
+        {
+            for (size_t local_pos = locals.size(); local_pos > 0; local_pos--)
+            {
+                if (locals[local_pos - 1].name == name)
+                    return static_cast<int>(local_pos - 1);
+            }
+
+            return -1;
+        }
+
+        [[nodiscard]] const GlobalSlot* findGlobal(ast::SymbolId name) const noexcept
+        {
+            auto found = module.global_slots.find(name);
+
+            return (found != module.global_slots.end()) ? &found->second : nullptr;
+        }
+
+        /* Jumps */
+
+        [[nodiscard]] size_t emitJump(Opcode op, uint8_t condition)
+        {
+            return (op == Opcode::jump) ? emit(runtime::encodesAx(op, 0)) : emit(runtime::encodeAsBx(op, condition, 0));
+        }
+
+        /// @brief Points a forward jump at the next instruction to be emitted.
+        void patchJump(size_t jump_pos)
+        {
+            Instruction& code = proto().code[jump_pos];
+            auto offset = static_cast<int64_t>(proto().code.size()) - static_cast<int64_t>(jump_pos) - 1;
+
+            if (runtime::opOf(code) == Opcode::jump)
+            {
+                if (offset > runtime::max_sax)
+                    fail("jump is too long");
+
+                code = runtime::encodesAx(Opcode::jump, static_cast<int32_t>(offset));
+            }
+            else
+            {
+                if (offset > runtime::max_sbx)
+                    fail("conditional jump is too long");
+
+                code = runtime::encodeAsBx(runtime::opOf(code), runtime::argA(code), static_cast<int32_t>(offset));
+            }
+        }
+
+        void emitLoop(size_t loop_top)
+        {
+            auto offset = static_cast<int64_t>(loop_top) - static_cast<int64_t>(proto().code.size()) - 1;
+
+            if (offset < runtime::min_sax)
+                fail("loop body is too long");
+
+            emit(runtime::encodesAx(Opcode::jump, static_cast<int32_t>(offset)));
+        }
+
+        /* Constants */
+
+        [[nodiscard]] uint16_t addConstant(Value value)
+        {
+            auto& constants = proto().constants;
+
+            for (size_t constant_pos = 0; constant_pos < constants.size(); constant_pos++)
+            {
+                Value existing = constants[constant_pos];
+
+                // Doubles match bit for bit, since 0.0 == -0.0 but they print differently.
+                bool same = (existing.isDouble() || value.isDouble()) ? existing.getBits() == value.getBits() : runtime::valuesEqual(existing, value);
+
+                if (same)
+                    return static_cast<uint16_t>(constant_pos);
+            }
+
+            if (constants.size() > UINT16_MAX)
+                fail("has more than 65536 constants");
+
+            constants.push_back(value);
+
+            return static_cast<uint16_t>(constants.size() - 1);
+        }
+
+        void emitInteger(uint8_t dest, int64_t value)
+        {
+            if (value >= runtime::min_sbx && value <= runtime::max_sbx)
+                emit(runtime::encodeAsBx(Opcode::load_int, dest, static_cast<int32_t>(value)));
+            else
+                emit(runtime::encodeABx(Opcode::load_const, dest, addConstant(Value::fromInteger(value))));
+        }
+
+        [[nodiscard]] Value makeSeqConstant(const ast::Sequence& seq)
+        {
+            std::vector<Value> items;
+
+            items.reserve(seq.items.size());
+
+            for (const auto& item : seq.items)
+            {
+                if (const auto* as_bool = std::any_cast<bool>(&item))
+                    items.push_back(Value::fromBool(*as_bool));
+                else if (const auto* as_int = std::any_cast<int64_t>(&item))
+                    items.push_back(Value::fromInteger(*as_int));
+                else if (const auto* as_dbl = std::any_cast<double>(&item))
+                    items.push_back(Value::fromDouble(*as_dbl));
+                else if (const auto* as_str = std::any_cast<std::string>(&item))
+                    items.push_back(Value::fromObject(program.heap.makeString(*as_str)));
+                else
+                    items.push_back(Value {});
+            }
+
+            return Value::fromObject(program.heap.makeSeq(std::move(items)));
+        }
+
+        /* Types */
+
+        [[nodiscard]] ast::DataType typeOf(const ast::IExpression* expr) const noexcept
+        {
+            auto found = types.find(expr);
+
+            return (found != types.end()) ? found->second : ast::DataType::unknown;
+        }
+
+        [[nodiscard]] static runtime::ValueTag tagOf(ast::DataType type) noexcept
+        {
+            switch (type)
+            {
+                case ast::DataType::boolean:
+                    return runtime::ValueTag::boolean;
+                case ast::DataType::integer:
+                    return runtime::ValueTag::integer;
+                case ast::DataType::ndouble:
+                    return runtime::ValueTag::ndouble;
+                case ast::DataType::string:
+                    return runtime::ValueTag::string;
+                case ast::DataType::sequence:
+                    return runtime::ValueTag::sequence;
+                case ast::DataType::nil:
+                default:
+                    return runtime::ValueTag::nil;
+            }
+        }
+
+        [[nodiscard]] bool needsTypeCheck(ast::DataType slot_type, const ast::IExpression* expr) const noexcept
+        {
+            return slot_type != ast::DataType::unknown && typeOf(expr) == ast::DataType::unknown;
+        }
+
+        /// @brief Guards a typed slot against a value the checker could not type. Values it did type were already checked statically.
+        void emitTypeCheck(uint8_t reg, ast::DataType slot_type, const ast::IExpression* expr)
+        {
+            if (needsTypeCheck(slot_type, expr))
+                emit(runtime::encodeABC(Opcode::check_type, reg, static_cast<uint8_t>(tagOf(slot_type)), 0));
+        }
+
+        /* Expression helpers */
+
+        void emitExpr(const ast::IExpression* expr, uint8_t dest)
+        {
+            uint8_t saved_target = target;
+
+            if (depth >= ast::max_nesting_depth)
+                fail("expression is nested too deeply");
+
+            depth++;
+            target = dest;
+            expr->acceptVisitor<void>(*this);
+            target = saved_target;
+            depth--;
+        }
+
+        /// @brief Returns a register holding expr's value, which is the local's own register for a plain local name.
+        [[nodiscard]] uint8_t exprRegister(const ast::IExpression* expr)
+        {
+            if (expr->getKind() == ast::ExprKind::name)
+            {
+                if (int local = findLocal(static_cast<const ast::Name*>(expr)->getName()); local >= 0)
+                    return static_cast<uint8_t>(local);
+            }
+
+            uint8_t temp = allocRegister();
+
+            emitExpr(expr, temp);
+
+            return temp;
+        }
+
+        /// @brief Loads a defun passed by name to a builtin, e.g double in $(parallelMap double nums), as a function value. Returns false when arg names no defun or a variable shadows it.
+        [[nodiscard]] bool emitFunctionRef(const ast::IExpression* arg, uint8_t dest)
+        {
+            if (arg->getKind() != ast::ExprKind::name)
+                return false;
+
+            const auto& ref = static_cast<const ast::Name&>(*arg);
+            ast::SymbolId name = ref.getName();
+            auto found = module.function_ids.find(name);
+
+            if (found == module.function_ids.end() || findLocal(name) >= 0 || findGlobal(name) != nullptr)
+                return false;
+
+            // A generic passes as its dynamically checked version, since only callees take substitutions.
+            emit(runtime::encodeABx(Opcode::load_const, dest, addConstant(Value::fromFunction(found->second))));
+
+            return true;
+        }
+
+        void compileCall(const ast::Unary& node)
+        {
+            const ast::IExpression* callee = node.getInner();
+            ast::ExprList args = node.getArgs();
+
+            if (callee->getKind() != ast::ExprKind::name)
+                fail("only named functions can be called");
+
+            const auto& callee_ref = static_cast<const ast::Name&>(*callee);
+            ast::SymbolId callee_name = callee_ref.getName();
+            unsigned mark = free_reg;
+            bool is_tail = std::exchange(tail_position, false);
+
+            // Reuse the target as the argument base when it is the newest temporary, which saves a move.
+            uint8_t call_base = (target + 1u == free_reg && !isLocalRegister(target)) ? target : allocRegister();
+
+            for (size_t arg_pos = 1; arg_pos < args.size(); arg_pos++)
+                static_cast<void>(allocRegister());
+
+            bool to_builtin = !module.function_ids.contains(callee_name) && runtime::findBuiltin(module.symbols.nameOf(callee_name)) != runtime::no_builtin;
+
+            for (size_t arg_pos = 0; arg_pos < args.size(); arg_pos++)
+            {
+                if (!to_builtin || !emitFunctionRef(args[arg_pos], static_cast<uint8_t>(call_base + arg_pos)))
+                    emitExpr(args[arg_pos], static_cast<uint8_t>(call_base + arg_pos));
+            }
+
+            uint16_t callee_id = runtime::no_function;
+
+            if (auto found = module.function_ids.find(callee_name); found != module.function_ids.end())
+                callee_id = found->second;
+
+            if (const ast::Substitution* substitution = callee_ref.getSubstitution(); substitution != nullptr && module.generics.contains(callee_name))
+                callee_id = module.instantiate(*substitution, bindings, program);
+
+            if (callee_id != runtime::no_function)
+            {
+                const auto& callee_proto = program.functions[callee_id];
+
+                if (callee_proto.arity != args.size())
+                    fail("'" + callee_proto.name + "' takes " + std::to_string(callee_proto.arity) + " argument(s) but got " + std::to_string(args.size()));
+
+                for (size_t arg_pos = 0; arg_pos < args.size(); arg_pos++)
+                    emitTypeCheck(static_cast<uint8_t>(call_base + arg_pos), module.paramType(callee_id, arg_pos), args[arg_pos]);
+
+                // A tail call replaces this frame, and the callee's ret then returns straight to this function's caller.
+                if (is_tail)
+                {
+                    emit(runtime::encodeABx(Opcode::tail_call, call_base, callee_id));
+                    free_reg = mark;
+                    return;
+                }
+
+                emit(runtime::encodeABx(Opcode::call, call_base, callee_id));
+            }
+            else if (uint8_t builtin = runtime::findBuiltin(module.symbols.nameOf(callee_name)); builtin != runtime::no_builtin)
+            {
+                const auto& entry = runtime::builtinTable()[builtin];
+
+                if (entry.arity != args.size())
+                    fail("'" + std::string {entry.name} + "' takes " + std::to_string(entry.arity) + " argument(s) but got " + std::to_string(args.size()));
+
+                emit(runtime::encodeABC(Opcode::call_builtin, call_base, builtin, static_cast<uint8_t>(args.size())));
+            }
+            else
+                fail("unknown function '" + nameOf(callee_name) + "'");
+
+            if (call_base != target)
+                emit(runtime::encodeABC(Opcode::move, target, call_base, 0));
+
+            free_reg = mark;
+        }
+
+        void compileAccess(const ast::Unary& node)
+        {
+            ast::ExprList args = node.getArgs();
+            unsigned mark = free_reg;
+            uint8_t seq = exprRegister(node.getInner());
+
+            // @(items length) reads the length unless length names a variable.
+            if (args[0]->getKind() == ast::ExprKind::name)
+            {
+                ast::SymbolId index_name = static_cast<const ast::Name*>(args[0])->getName();
+
+                if (module.symbols.nameOf(index_name) == "length" && findLocal(index_name) < 0 && findGlobal(index_name) == nullptr)
+                {
+                    emit(runtime::encodeABC(Opcode::length, target, seq, 0));
+                    free_reg = mark;
+                    return;
+                }
+            }
+
+            uint8_t position = exprRegister(args[0]);
+            Opcode op = Opcode::index;
+
+            // A typed item means the checker traced the Seq to a literal, which makeSeq stored unboxed.
+            switch ((typeOf(args[0]) == ast::DataType::integer) ? typeOf(&node) : ast::DataType::unknown)
+            {
+                case ast::DataType::integer:
+                    op = Opcode::index_i64;
+                    break;
+                case ast::DataType::ndouble:
+                    op = Opcode::index_f64;
+                    break;
+                case ast::DataType::boolean:
+                    op = Opcode::index_bool;
+                    break;
+                default:
+                    break;
+            }
+
+            emit(runtime::encodeABC(op, target, seq, position));
+            free_reg = mark;
+        }
+
+        /// @brief Picks the unchecked opcode for operands of a known type. Sets swap when the operands must be exchanged, since > and >= reuse < and <=.
+        [[nodiscard]] static bool typedBinaryOpcode(ast::OpType op, ast::DataType operand, Opcode& result, bool& swap) noexcept
+        {
+            swap = op == ast::OpType::greater || op == ast::OpType::atleast;
+
+            if (operand == ast::DataType::string)
+            {
+                result = Opcode::concat_str;
+                return op == ast::OpType::plus;
+            }
+
+            if (operand != ast::DataType::integer && operand != ast::DataType::ndouble)
+                return false;
+
+            bool is_int = operand == ast::DataType::integer;
+
+            switch (op)
+            {
+                case ast::OpType::plus:
+                    result = is_int ? Opcode::add_i64 : Opcode::add_f64;
+                    return true;
+                case ast::OpType::minus:
+                    result = is_int ? Opcode::sub_i64 : Opcode::sub_f64;
+                    return true;
+                case ast::OpType::times:
+                    result = is_int ? Opcode::mul_i64 : Opcode::mul_f64;
+                    return true;
+                case ast::OpType::slash:
+                    result = is_int ? Opcode::div_i64 : Opcode::div_f64;
+                    return true;
+                case ast::OpType::equality:
+                    result = is_int ? Opcode::eq_i64 : Opcode::eq_f64;
+                    return true;
+                case ast::OpType::inequality:
+                    result = is_int ? Opcode::ne_i64 : Opcode::ne_f64;
+                    return true;
+                case ast::OpType::lesser:
+                case ast::OpType::greater:
+                    result = is_int ? Opcode::lt_i64 : Opcode::lt_f64;
+                    return true;
+                case ast::OpType::atmost:
+                case ast::OpType::atleast:
+                    result = is_int ? Opcode::le_i64 : Opcode::le_f64;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        [[nodiscard]] static Opcode binaryOpcode(ast::OpType op) noexcept
+        {
+            switch (op)
+            {
+                case ast::OpType::plus:
+                    return Opcode::add;
+                case ast::OpType::minus:
+                    return Opcode::sub;
+                case ast::OpType::times:
+                    return Opcode::mul;
+                case ast::OpType::slash:
+                    return Opcode::div;
+                case ast::OpType::equality:
+                    return Opcode::eq;
+                case ast::OpType::inequality:
+                    return Opcode::ne;
+                case ast::OpType::lesser:
+                    return Opcode::lt;
+                case ast::OpType::atmost:
+                    return Opcode::le;
+                case ast::OpType::greater:
+                    return Opcode::gt;
+                case ast::OpType::atleast:
+                default:
+                    return Opcode::ge;
+            }
+        }
+
+        void compileBody(const ast::IStatement* body)
+        {
+            size_t scope_mark = locals.size();
+
+            if (depth >= ast::max_nesting_depth)
+                fail("block is nested too deeply");
+
+            depth++;
+            body->acceptVisitor<void>(*this);
+            depth--;
+
+            locals.resize(scope_mark);
+            free_reg = static_cast<unsigned>(locals.size());
+        }
+
+        /* Match dispatch */
+
+        /// @brief Jumps from a match's dispatch code to its arms. Switch tables hold arm numbers until the arms are laid out.
+        struct DispatchJumps
+        {
+            std::vector<std::vector<size_t>> arms;
+            std::vector<size_t> switches;
+        };
+
+        template <typename Table>
+        void emitSwitch(Opcode op, uint8_t input, std::vector<Table>& tables, Table table, DispatchJumps& jumps)
+        {
+            if (tables.size() > UINT16_MAX)
+                fail("has more than 65536 switch tables");
+
+            tables.push_back(std::move(table));
+            jumps.switches.push_back(emit(runtime::encodeABx(op, input, static_cast<uint16_t>(tables.size() - 1))));
+        }
+
+        /// @brief Emits a binary search over the segments, ending in a switch_int wherever the remaining keys are dense.
+        void emitDecisionTree(uint8_t input, uint8_t scratch, std::span<const Segment> segments, DispatchJumps& jumps)
+        {
+            if (segments.size() == 1)
+            {
+                jumps.arms[segments[0].arm].push_back(emitJump(Opcode::jump, 0));
+                return;
+            }
+
+            // Unbounded end segments are the table's below and above targets, so only the ones between need entries.
+            size_t first = (segments.front().lo == Value::min_integer) ? 1 : 0;
+            size_t last = segments.size() - ((segments.back().hi == Value::max_integer) ? 1 : 0);
+
+            if (last >= first + min_dispatch_cases)
+            {
+                int64_t span = segments[last - 1].hi - segments[first].lo + 1;
+
+                if (span <= max_table_span && span <= max_table_spread * static_cast<int64_t>(last - first))
+                {
+                    runtime::IntSwitch table {.low = segments[first].lo, .targets = {}, .below = static_cast<int32_t>(segments.front().arm), .above = static_cast<int32_t>(segments.back().arm)};
+
+                    for (size_t segment_pos = first; segment_pos < last; segment_pos++)
+                        table.targets.insert(table.targets.end(), static_cast<size_t>(segments[segment_pos].hi - segments[segment_pos].lo + 1), static_cast<int32_t>(segments[segment_pos].arm));
+
+                    emitSwitch(Opcode::switch_int, input, proto().int_switches, std::move(table), jumps);
+                    return;
+                }
+            }
+
+            size_t middle = segments.size() / 2;
+
+            emitInteger(scratch, segments[middle].lo);
+            emit(runtime::encodeABC(Opcode::lt_i64, scratch, input, scratch));
+
+            // A lone lower segment needs no subtree, so the branch goes straight to its arm.
+            if (middle == 1)
+            {
+                jumps.arms[segments[0].arm].push_back(emitJump(Opcode::jump_if_true, scratch));
+                emitDecisionTree(input, scratch, segments.subspan(middle), jumps);
+                return;
+            }
+
+            size_t to_lower = emitJump(Opcode::jump_if_true, scratch);
+
+            emitDecisionTree(input, scratch, segments.subspan(middle), jumps);
+            patchJump(to_lower);
+            emitDecisionTree(input, scratch, segments.first(middle), jumps);
+        }
+
+        /// @brief Compiles a match whose cases all compare its name with literals to a switch_int, switch_str, or decision tree ahead of the arms. Returns false, having emitted nothing, for any other match.
+        [[nodiscard]] bool compileDispatch(const ast::Match& node)
+        {
+            ast::StmtList cases = node.getCases();
+            int local = findLocal(node.getName());
+            const GlobalSlot* global = (local < 0) ? findGlobal(node.getName()) : nullptr;
+            ast::DataType input_type = (local >= 0) ? locals[local].type : global->type;
+            std::vector<CaseTest> tests;
+
+            if (cases.size() < ((input_type == ast::DataType::boolean) ? 2 : min_dispatch_cases))
+                return false;
+
+            for (const auto* stmt : cases)
+            {
+                std::optional<CaseTest> test = caseTestOf(static_cast<const ast::Case&>(*stmt).getCondition(), node.getName());
+
+                if (!test || test->literal->getDataType() != input_type)
+                    return false;
+
+                bool is_equality = test->op == ast::OpType::equality || test->op == ast::OpType::inequality;
+
+                if ((input_type == ast::DataType::boolean && !is_equality) || (input_type == ast::DataType::string && test->op != ast::OpType::equality))
+                    return false;
+
+                tests.push_back(*test);
+            }
+
+            if (input_type != ast::DataType::integer && input_type != ast::DataType::boolean && input_type != ast::DataType::string)
+                return false;
+
+            uint8_t input = (local >= 0) ? static_cast<uint8_t>(local) : allocRegister();
+            DispatchJumps jumps {.arms = std::vector<std::vector<size_t>>(cases.size() + 1), .switches = {}};
+
+            if (global != nullptr)
+                emit(runtime::encodeABx(Opcode::get_global, input, global->index));
+
+            switch (input_type)
+            {
+                case ast::DataType::integer:
+                    emitDecisionTree(input, allocRegister(), segmentCases(tests), jumps);
+                    break;
+                case ast::DataType::boolean:
+                    jumps.arms[armFor(tests, 0)].push_back(emitJump(Opcode::jump_if_false, input));
+                    jumps.arms[armFor(tests, 1)].push_back(emitJump(Opcode::jump, 0));
+                    break;
+                case ast::DataType::string:
+                default:
+                {
+                    runtime::StringSwitch table {.targets = {}, .fallback = static_cast<int32_t>(cases.size())};
+
+                    for (size_t test_pos = 0; test_pos < tests.size(); test_pos++)
+                        table.targets.try_emplace(tests[test_pos].literal->toNativeType<std::string>(), static_cast<int32_t>(test_pos));
+
+                    emitSwitch(Opcode::switch_str, input, proto().string_switches, std::move(table), jumps);
+                    break;
+                }
+            }
+
+            free_reg = static_cast<unsigned>(locals.size());
+
+            std::vector<size_t> arm_starts;
+            std::vector<size_t> exits;
+
+            for (size_t arm = 0; arm <= cases.size(); arm++)
+            {
+                for (size_t jump : jumps.arms[arm])
+                    patchJump(jump);
+
+                arm_starts.push_back(proto().code.size());
+
+                if (arm < cases.size())
+                {
+                    compileBody(static_cast<const ast::Case&>(*cases[arm]).getBody());
+                    exits.push_back(emitJump(Opcode::jump, 0));
+                }
+                else if (node.getFallback() != nullptr)
+                    compileBody(node.getFallback());
+            }
+
+            for (size_t exit : exits)
+                patchJump(exit);
+
+            for (size_t switch_pos : jumps.switches)
+            {
+                Instruction code = proto().code[switch_pos];
+                auto offset_of = [&arm_starts, switch_pos](int32_t arm) {
+                    return static_cast<int32_t>(static_cast<int64_t>(arm_starts[static_cast<size_t>(arm)]) - static_cast<int64_t>(switch_pos) - 1);
+                };
+
+                if (runtime::opOf(code) == Opcode::switch_int)
+                {
+                    runtime::IntSwitch& table = proto().int_switches[runtime::argBx(code)];
+
+                    for (auto& table_target : table.targets)
+                        table_target = offset_of(table_target);
+
+                    table.below = offset_of(table.below);
+                    table.above = offset_of(table.above);
+                }
+                else
+                {
+                    runtime::StringSwitch& table = proto().string_switches[runtime::argBx(code)];
+
+                    for (auto& [key, table_target] : table.targets)
+                        table_target = offset_of(table_target);
+
+                    table.fallback = offset_of(table.fallback);
+                }
+            }
+
+            return true;
+        }
+
+    public:
+        FunctionCompiler(Compiler& module_arg, runtime::Program& program_arg, uint16_t function_id_arg, const TypeTable& types_arg, TypeBindings bindings_arg)
+        : module {module_arg}, program {program_arg}, types {types_arg}, bindings {std::move(bindings_arg)}, locals {}, function_id {function_id_arg}, return_type {ast::DataType::unknown}, free_reg {0}, max_reg {0}, target {0}, tail_position {false}, depth {0}, chain {} {}
+
+        void compileFunction(const ast::Function& node)
+        {
+            return_type = resolveType(node.getDataType(), node.getTypeName(), bindings);
+
+            for (const auto* param : node.getParams())
+            {
+                const auto& parameter = static_cast<const ast::Parameter&>(*param);
+
+                ast::DataType type = resolveType(parameter.getDataType(), parameter.getTypeName(), bindings);
+
+                locals.push_back({.name = parameter.getName(), .type = type, .is_mutable = true});
+                proto().param_tags.push_back((type != ast::DataType::unknown) ? std::optional {tagOf(type)} : std::nullopt);
+                static_cast<void>(allocRegister());
+            }
+
+            node.getBody()->acceptVisitor<void>(*this);
+            emit(runtime::encodeABC(Opcode::ret_nil, 0, 0, 0));
+
+            proto().register_count = static_cast<uint16_t>(std::max(max_reg, 1u));
+        }
+
+        void compileInitializer(ast::StmtList top_level)
+        {
+            for (const auto* stmt : top_level)
+            {
+                if (stmt->getKind() != ast::StmtKind::variable)
+                    continue;
+
+                const auto& variable = static_cast<const ast::Variable&>(*stmt);
+                const GlobalSlot& global = module.global_slots.at(variable.getName());
+                uint8_t value = exprRegister(variable.getValue());
+
+                emitTypeCheck(value, global.type, variable.getValue());
+                emit(runtime::encodeABx(Opcode::set_global, value, global.index));
+                free_reg = 0;
+            }
+
+            emit(runtime::encodeABC(Opcode::ret_nil, 0, 0, 0));
+
+            proto().register_count = static_cast<uint16_t>(std::max(max_reg, 1u));
+        }
+
+        /* Expressions */
+
+        void visitLiteral(const ast::Literal& node) override
+        {
+            switch (node.getDataType())
+            {
+                case ast::DataType::boolean:
+                    emit(runtime::encodeABC(Opcode::load_bool, target, node.toNativeType<bool>() ? 1 : 0, 0));
+                    break;
+                case ast::DataType::integer:
+                    emitInteger(target, node.toNativeType<int64_t>());
+                    break;
+                case ast::DataType::ndouble:
+                    emit(runtime::encodeABx(Opcode::load_const, target, addConstant(Value::fromDouble(node.toNativeType<double>()))));
+                    break;
+                case ast::DataType::string:
+                {
+                    Value text = Value::fromObject(program.heap.makeString(node.toNativeType<std::string>()));
+
+                    emit(runtime::encodeABx(Opcode::load_const, target, addConstant(text)));
+                    break;
+                }
+                case ast::DataType::sequence:
+                    emit(runtime::encodeABx(Opcode::load_const, target, addConstant(makeSeqConstant(node.toNativeType<ast::Sequence>()))));
+                    break;
+                default:
+                    emit(runtime::encodeABC(Opcode::load_nil, target, 0, 0));
+                    break;
+            }
+        }
+
+        void visitUnary(const ast::Unary& node) override
+        {
+            switch (node.getOpType())
+            {
+                case ast::OpType::invoke:
+                    compileCall(node);
+                    break;
+                case ast::OpType::access:
+                    compileAccess(node);
+                    break;
+                case ast::OpType::minus:
+                {
+                    unsigned mark = free_reg;
+                    uint8_t inner = exprRegister(node.getInner());
+
+                    ast::DataType inner_type = typeOf(node.getInner());
+                    Opcode op = (inner_type == ast::DataType::integer) ? Opcode::neg_i64 : ((inner_type == ast::DataType::ndouble) ? Opcode::neg_f64 : Opcode::neg);
+
+                    emit(runtime::encodeABC(op, target, inner, 0));
+                    free_reg = mark;
+                    break;
+                }
+                default:
+                    fail("unsupported unary operator");
+            }
+        }
+
+        void visitBinary(const ast::Binary& node) override
+        {
+            unsigned mark = free_reg;
+            size_t chain_mark = chain.size();
+            const ast::IExpression* first = ast::collectChain(node, chain);
+            size_t chain_end = chain.size();
+            ast::OpType op = node.getOpType();
+
+            if (op == ast::OpType::logic_and || op == ast::OpType::logic_or)
+            {
+                // The left value lands in the result before the right side runs, so never build it in a local the right side may read.
+                uint8_t work = isLocalRegister(target) ? allocRegister() : target;
+
+                emitExpr(first, work);
+
+                for (size_t link_pos = chain_end; link_pos-- > chain_mark;)
+                {
+                    const ast::Binary* link = chain[link_pos];
+                    size_t skip_right = emitJump((link->getOpType() == ast::OpType::logic_and) ? Opcode::jump_if_false : Opcode::jump_if_true, work);
+
+                    emitExpr(link->getRight(), work);
+                    patchJump(skip_right);
+                }
+
+                if (work != target)
+                    emit(runtime::encodeABC(Opcode::move, target, work, 0));
+
+                chain.resize(chain_mark);
+                free_reg = mark;
+                return;
+            }
+
+            // Every link but the outermost one leaves its value in one shared temporary, so a chain of any length needs the same few registers.
+            uint8_t partial = (chain_end - chain_mark > 1) ? allocRegister() : target;
+            unsigned partial_mark = free_reg;
+            uint8_t lhs = exprRegister(first);
+
+            for (size_t link_pos = chain_end; link_pos-- > chain_mark;)
+            {
+                const ast::Binary* link = chain[link_pos];
+                uint8_t rhs = exprRegister(link->getRight());
+                uint8_t dest = (link == &node) ? target : partial;
+                ast::DataType lhs_type = typeOf(link->getLeft());
+                Opcode typed_op;
+                bool swap = false;
+
+                // Only operands the checker typed alike skip the runtime dispatch.
+                if (lhs_type == typeOf(link->getRight()) && typedBinaryOpcode(link->getOpType(), lhs_type, typed_op, swap))
+                    emit(swap ? runtime::encodeABC(typed_op, dest, rhs, lhs) : runtime::encodeABC(typed_op, dest, lhs, rhs));
+                else
+                    emit(runtime::encodeABC(binaryOpcode(link->getOpType()), dest, lhs, rhs));
+
+                lhs = dest;
+                free_reg = partial_mark;
+            }
+
+            chain.resize(chain_mark);
+            free_reg = mark;
+        }
+
+        void visitName(const ast::Name& node) override
+        {
+            ast::SymbolId name = node.getName();
+
+            if (int local = findLocal(name); local >= 0)
+            {
+                if (local != target)
+                    emit(runtime::encodeABC(Opcode::move, target, static_cast<uint8_t>(local), 0));
+            }
+            else if (const GlobalSlot* global = findGlobal(name); global != nullptr)
+                emit(runtime::encodeABx(Opcode::get_global, target, global->index));
+            else if (module.function_ids.contains(name))
+                fail("function '" + nameOf(name) + "' can only be used as a value when passed to a builtin");
+            else
+                fail("unknown name '" + nameOf(name) + "'");
+        }
+
+        /* Statements */
+
+        void visitVariable(const ast::Variable& node) override
+        {
+            uint8_t reg = allocRegister();
+
+            emitExpr(node.getValue(), reg);
+            ast::DataType type = resolveType(node.getDataType(), node.getTypeName(), bindings);
+
+            emitTypeCheck(reg, type, node.getValue());
+            locals.push_back({.name = node.getName(), .type = type, .is_mutable = node.isMutable()});
+        }
+
+        void visitMutation(const ast::Mutation& node) override
+        {
+            ast::SymbolId name = node.getName();
+
+            if (int local = findLocal(name); local >= 0)
+            {
+                if (!locals[local].is_mutable)
+                    fail("cannot assign to constant '" + nameOf(name) + "'");
+
+                emitExpr(node.getExpression(), static_cast<uint8_t>(local));
+                emitTypeCheck(static_cast<uint8_t>(local), locals[local].type, node.getExpression());
+            }
+            else if (const GlobalSlot* global = findGlobal(name); global != nullptr)
+            {
+                if (!global->is_mutable)
+                    fail("cannot assign to constant '" + nameOf(name) + "'");
+
+                uint8_t value = exprRegister(node.getExpression());
+
+                emitTypeCheck(value, global->type, node.getExpression());
+                emit(runtime::encodeABx(Opcode::set_global, value, global->index));
+            }
+            else
+                fail("unknown name '" + nameOf(name) + "'");
+
+            free_reg = static_cast<unsigned>(locals.size());
+        }
+
+        void visitFunction(const ast::Function& node) override
+        {
+            fail("nested function '" + nameOf(node.getName()) + "' is not supported");
+        }
+
+        void visitParameter([[maybe_unused]] const ast::Parameter& node) override
+        {
+            fail("stray parameter");
+        }
+
+        void visitBlock(const ast::Block& node) override
+        {
+            size_t scope_mark = locals.size();
+
+            for (const auto* stmt : node.getStatements())
+            {
+                stmt->acceptVisitor<void>(*this);
+                free_reg = static_cast<unsigned>(locals.size());
+            }
+
+            locals.resize(scope_mark);
+            free_reg = static_cast<unsigned>(locals.size());
+        }
+
+        void visitMatch(const ast::Match& node) override
+        {
+            std::vector<size_t> exits;
+
+            if (findLocal(node.getName()) < 0 && findGlobal(node.getName()) == nullptr)
+                fail("unknown name '" + nameOf(node.getName()) + "' in match");
+
+            if (compileDispatch(node))
+                return;
+
+            for (const auto* stmt : node.getCases())
+            {
+                const auto& match_case = static_cast<const ast::Case&>(*stmt);
+                uint8_t condition = exprRegister(match_case.getCondition());
+                size_t next_case = emitJump(Opcode::jump_if_false, condition);
+
+                free_reg = static_cast<unsigned>(locals.size());
+                compileBody(match_case.getBody());
+                exits.push_back(emitJump(Opcode::jump, 0));
+                patchJump(next_case);
+            }
+
+            if (node.getFallback() != nullptr)
+                compileBody(node.getFallback());
+
+            for (size_t exit : exits)
+                patchJump(exit);
+        }
+
+        void visitCase([[maybe_unused]] const ast::Case& node) override
+        {
+            fail("case outside of match");
+        }
+
+        void visitReturn(const ast::Return& node) override
+        {
+            if (node.getResult() == nullptr)
+            {
+                emit(runtime::encodeABC(Opcode::ret_nil, 0, 0, 0));
+                return;
+            }
+
+            const ast::IExpression* result_expr = node.getResult();
+
+            // A call can only replace this frame when its result needs no type check before returning.
+            tail_position = result_expr->getKind() == ast::ExprKind::unary && static_cast<const ast::Unary&>(*result_expr).getOpType() == ast::OpType::invoke && !needsTypeCheck(return_type, result_expr);
+
+            size_t result_start = proto().code.size();
+            uint8_t result = exprRegister(result_expr);
+
+            tail_position = false;
+
+            if (proto().code.size() > result_start && runtime::opOf(proto().code.back()) == Opcode::tail_call)
+                return;
+
+            emitTypeCheck(result, return_type, result_expr);
+            emit(runtime::encodeABC(Opcode::ret, result, 0, 0));
+        }
+
+        void visitWhile(const ast::While& node) override
+        {
+            size_t loop_top = proto().code.size();
+            uint8_t condition = exprRegister(node.getConditions());
+            size_t exit = emitJump(Opcode::jump_if_false, condition);
+
+            free_reg = static_cast<unsigned>(locals.size());
+            compileBody(node.getBody());
+            emitLoop(loop_top);
+            patchJump(exit);
+        }
+
+        void visitGeneric([[maybe_unused]] const ast::Generic& node) override
+        {
+            fail("generic declarations must be at top level");
+        }
+
+        void visitSubstitution([[maybe_unused]] const ast::Substitution& node) override
+        {
+            fail("stray substitution");
+        }
+
+        void visitImport([[maybe_unused]] const ast::Import& node) override
+        {
+            fail("imports must be at top level");
+        }
+
+        void visitExprStmt(const ast::ExprStmt& node) override
+        {
+            emitExpr(node.getExpression(), allocRegister());
+        }
+    };
+
+    /* Compiler private impl. */
+
+    [[nodiscard]] static Value zeroOf(ast::DataType type, runtime::Heap& heap)
+    {
+        switch (type)
+        {
+            case ast::DataType::boolean:
+                return Value::fromBool(false);
+            case ast::DataType::integer:
+                return Value::fromInteger(0);
+            case ast::DataType::ndouble:
+                return Value::fromDouble(0.0);
+            case ast::DataType::string:
+                return Value::fromObject(heap.makeString(""));
+            case ast::DataType::sequence:
+                return Value::fromObject(heap.makeSeq(std::vector<Value> {}));
+            default:
+                return Value {};
+        }
+    }
+
+    uint16_t Compiler::declareFunction(const ast::Function& node, std::string name, TypeBindings bindings, runtime::Program& program)
+    {
+        if (program.functions.size() >= runtime::no_function)
+        {
+            errors.push_back({.message = "too many functions"});
+            return runtime::no_function;
+        }
+
+        if (node.getParams().size() >= max_registers)
+        {
+            errors.push_back({.message = "function '" + name + "' has too many parameters"});
+            return runtime::no_function;
+        }
+
+        auto function_id = static_cast<uint16_t>(program.functions.size());
+
+        function_entries.push_back({.node = &node, .bindings = std::move(bindings)});
+        program.functions.push_back({.name = std::move(name), .code = {}, .constants = {}, .int_switches = {}, .string_switches = {}, .param_tags = {}, .arity = static_cast<uint16_t>(node.getParams().size()), .register_count = 1, .is_pure = false});
+
+        return function_id;
+    }
+
+    uint16_t Compiler::instantiate(const ast::Substitution& substitution, const TypeBindings& outer, runtime::Program& program)
+    {
+        uint16_t generic_id = function_ids.at(substitution.getName());
+        const ast::Generic& generic = *generics.at(substitution.getName());
+
+        // The checker reports a wrong type argument count, so such calls just go to the dynamic version.
+        if (generic.getParams().size() != substitution.getTypeNames().size())
+            return generic_id;
+
+        TypeBindings bindings = bindSubstitution(generic, substitution, symbols, outer);
+
+        if (bindings.empty())
+            return generic_id;
+
+        InstanceKey key {.generic = substitution.getName(), .types = {}};
+        std::string name {symbols.nameOf(substitution.getName())};
+
+        for (auto param : generic.getParams())
+        {
+            auto bound = bindings.find(param);
+
+            key.types.push_back((bound != bindings.end()) ? bound->second : ast::DataType::unknown);
+            name += (key.types.size() == 1 ? "(" : ", ") + std::string {ast::dataTypeName(key.types.back())};
+        }
+
+        if (auto found = instances.find(key); found != instances.end())
+            return found->second;
+
+        uint16_t instance_id = declareFunction(*function_entries[generic_id].node, name + ")", std::move(bindings), program);
+
+        if (instance_id == runtime::no_function)
+            return generic_id;
+
+        instances.emplace(std::move(key), instance_id);
+
+        return instance_id;
+    }
+
+    void Compiler::markPureFunctions(runtime::Program& program) const
+    {
+        for (auto& function : program.functions)
+            function.is_pure = true;
+
+        // Clearing until nothing changes finds the largest pure set, so recursive functions with no effects stay pure.
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+
+            for (auto& function : program.functions)
+            {
+                if (!function.is_pure)
+                    continue;
+
+                for (Instruction code : function.code)
+                {
+                    Opcode op = runtime::opOf(code);
+                    bool has_effect = op == Opcode::set_global
+                        || (op == Opcode::call_builtin && !runtime::builtinTable()[runtime::argB(code)].is_pure)
+                        || ((op == Opcode::call || op == Opcode::tail_call) && !program.functions[runtime::argBx(code)].is_pure);
+
+                    if (has_effect)
+                    {
+                        function.is_pure = false;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    ast::DataType Compiler::paramType(uint16_t function_id, size_t param_pos) const noexcept
+    {
+        const FunctionEntry& entry = function_entries[function_id];
+
+        if (entry.node == nullptr || param_pos >= entry.node->getParams().size())
+            return ast::DataType::unknown;
+
+        const auto& param = static_cast<const ast::Parameter&>(*entry.node->getParams()[param_pos]);
+
+        return resolveType(param.getDataType(), param.getTypeName(), entry.bindings);
+    }
+
+    void Compiler::declare(ast::StmtList top_level, runtime::Program& program)
+    {
+        for (const auto* stmt : top_level)
+        {
+            switch (stmt->getKind())
+            {
+                case ast::StmtKind::variable:
+                {
+                    const auto& variable = static_cast<const ast::Variable&>(*stmt);
+
+                    if (global_slots.contains(variable.getName()))
+                        errors.push_back({.message = "global '" + std::string {symbols.nameOf(variable.getName())} + "' is defined twice"});
+                    else if (program.global_defaults.size() > UINT16_MAX)
+                        errors.push_back({.message = "too many globals"});
+                    else
+                    {
+                        global_slots[variable.getName()] = {.index = static_cast<uint16_t>(program.global_defaults.size()), .type = variable.getDataType(), .is_mutable = variable.isMutable()};
+                        program.global_defaults.push_back(zeroOf(variable.getDataType(), program.heap));
+                    }
+                    break;
+                }
+                case ast::StmtKind::function:
+                case ast::StmtKind::generic:
+                {
+                    // A generic's own function runs on dynamically checked opcodes, and serves calls without concrete type arguments.
+                    const ast::IStatement* item = (stmt->getKind() == ast::StmtKind::generic) ? static_cast<const ast::Generic&>(*stmt).getItem() : stmt;
+
+                    if (item->getKind() != ast::StmtKind::function)
+                        break;
+
+                    const auto& function = static_cast<const ast::Function&>(*item);
+                    std::string name {symbols.nameOf(function.getName())};
+
+                    if (function_ids.contains(function.getName()))
+                    {
+                        errors.push_back({.message = "function '" + name + "' is defined twice"});
+                        break;
+                    }
+
+                    if (uint16_t function_id = declareFunction(function, std::move(name), {}, program); function_id != runtime::no_function)
+                        function_ids[function.getName()] = function_id;
+
+                    if (stmt->getKind() == ast::StmtKind::generic)
+                        generics.try_emplace(function.getName(), static_cast<const ast::Generic*>(stmt));
+                    break;
+                }
+                case ast::StmtKind::import:
+                {
+                    ast::SymbolList path = static_cast<const ast::Import&>(*stmt).getItemPath();
+                    uint8_t builtin = runtime::findBuiltin(symbols.nameOf(path.back()));
+
+                    if (path.size() != 2 || builtin == runtime::no_builtin || runtime::builtinTable()[builtin].module != symbols.nameOf(path.front()))
+                    {
+                        std::string dotted {};
+
+                        for (auto item : path)
+                            dotted += (dotted.empty() ? "" : ".") + std::string {symbols.nameOf(item)};
+
+                        errors.push_back({.message = "unknown import '" + dotted + "'"});
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    /* Compiler public impl. */
+
+    Compiler::Compiler(const ast::SymbolTable& symbols_arg)
+    : symbols {symbols_arg}, errors {}, function_ids {}, global_slots {}, function_entries {}, generics {}, instances {}, checker {symbols_arg}, expr_types {} {}
+
+    runtime::Program Compiler::compile(ast::StmtList top_level)
+    {
+        runtime::Program program {};
+
+        declare(top_level, program);
+        expr_types = checker.check(top_level);
+
+        program.init_function = static_cast<uint16_t>(program.functions.size());
+        function_entries.push_back({.node = nullptr, .bindings = {}});
+        program.functions.push_back({.name = "<module>", .code = {}, .constants = {}, .int_switches = {}, .string_switches = {}, .param_tags = {}, .arity = 0, .register_count = 1, .is_pure = false});
+
+        try
+        {
+            FunctionCompiler init {*this, program, program.init_function, expr_types, {}};
+
+            init.compileInitializer(top_level);
+        }
+        catch (const CompileFailure&) {}
+
+        // Instances are appended as their first calls compile, so this also reaches instances made by other instances.
+        for (size_t function_pos = 0; function_pos < function_entries.size(); function_pos++)
+        {
+            const ast::Function* node = function_entries[function_pos].node;
+            TypeBindings bindings = function_entries[function_pos].bindings;
+
+            if (node == nullptr)
+                continue;
+
+            try
+            {
+                TypeTable instance_types = bindings.empty() ? TypeTable {} : checker.checkInstance(*node, bindings, program.functions[function_pos].name);
+                FunctionCompiler function {*this, program, static_cast<uint16_t>(function_pos), bindings.empty() ? expr_types : instance_types, std::move(bindings)};
+
+                function.compileFunction(*node);
+            }
+            catch (const CompileFailure&) {}
+        }
+
+        errors.insert(errors.end(), checker.getErrors().begin(), checker.getErrors().end());
+        markPureFunctions(program);
+
+        if (ast::SymbolId main_name = symbols.find("main"); function_ids.contains(main_name))
+        {
+            program.main_function = function_ids[main_name];
+
+            if (program.functions[program.main_function].arity != 0)
+                errors.push_back({.message = "main must not take parameters"});
+        }
+
+        return program;
+    }
+
+    const std::vector<CompileError>& Compiler::getErrors() const noexcept
+    {
+        return errors;
+    }
+}
@@ -0,0 +1,519 @@
+/**
+ * @file typechecker.cpp
+ * @author DrkWithT
+ * @brief Implements static type inference and checking.
+ * @date 2024-05-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <utility>
+#include "ast/context.hpp"
+#include "backend/typechecker.hpp"
+
+namespace tisp::backend
+{
+    using ast::DataType;
+
+    [[nodiscard]] static std::string_view opSpelling(ast::OpType op) noexcept
+    {
+        switch (op)
+        {
+            case ast::OpType::plus:
+                return "+";
+            case ast::OpType::minus:
+                return "-";
+            case ast::OpType::times:
+                return "*";
+            case ast::OpType::slash:
+                return "/";
+            case ast::OpType::equality:
+                return "==";
+            case ast::OpType::inequality:
+                return "!=";
+            case ast::OpType::greater:
+                return ">";
+            case ast::OpType::atmost:
+                return "<=";
+            case ast::OpType::lesser:
+                return "<";
+            case ast::OpType::atleast:
+                return ">=";
+            case ast::OpType::logic_and:
+                return "&&";
+            case ast::OpType::logic_or:
+                return "||";
+            default:
+                return "?";
+        }
+    }
+
+    [[nodiscard]] static bool isNumeric(DataType type) noexcept
+    {
+        return type == DataType::integer || type == DataType::ndouble;
+    }
+
+    DataType resolveType(DataType type, ast::SymbolId type_name, const TypeBindings& bindings) noexcept
+    {
+        if (type != DataType::unknown)
+            return type;
+
+        auto bound = bindings.find(type_name);
+
+        return (bound != bindings.end()) ? bound->second : DataType::unknown;
+    }
+
+    TypeBindings bindSubstitution(const ast::Generic& generic, const ast::Substitution& substitution, const ast::SymbolTable& symbols, const TypeBindings& outer)
+    {
+        TypeBindings result;
+        ast::SymbolList params = generic.getParams();
+        ast::SymbolList args = substitution.getTypeNames();
+
+        for (size_t param_pos = 0; param_pos < params.size() && param_pos < args.size(); param_pos++)
+        {
+            // An unknown name like int leaves the parameter unbound, so that part of the instance stays dynamically checked.
+            if (DataType type = resolveType(ast::dataTypeFromName(symbols.nameOf(args[param_pos])), args[param_pos], outer); type != DataType::unknown)
+                result[params[param_pos]] = type;
+        }
+
+        return result;
+    }
+
+    /* TypeChecker private impl. */
+
+    void TypeChecker::error(std::string message)
+    {
+        errors.push_back({.message = "in " + function_name + ": " + std::move(message)});
+    }
+
+    void TypeChecker::expect(DataType expected, DataType actual, const std::string& what)
+    {
+        if (expected != DataType::unknown && actual != DataType::unknown && expected != actual)
+            error(what + " must be " + std::string {ast::dataTypeName(expected)} + ", not " + std::string {ast::dataTypeName(actual)});
+    }
+
+    DataType TypeChecker::infer(const ast::IExpression* expr)
+    {
+        // The compiler reports trees this deep, so the checker only has to stop recursing.
+        if (depth >= ast::max_nesting_depth)
+            return DataType::unknown;
+
+        depth++;
+
+        DataType type = expr->acceptVisitor<DataType>(*this);
+
+        depth--;
+        types[expr] = type;
+
+        return type;
+    }
+
+    DataType TypeChecker::typeOfName(ast::SymbolId name) const noexcept
+    {
+        for (size_t local_pos = locals.size(); local_pos > 0; local_pos--)
+        {
+            if (locals[local_pos - 1].name == name)
+                return locals[local_pos - 1].type;
+        }
+
+        auto global = global_types.find(name);
+
+        return (global != global_types.end()) ? global->second : DataType::unknown;
+    }
+
+    bool TypeChecker::isVariable(ast::SymbolId name) const noexcept
+    {
+        for (const auto& local : locals)
+        {
+            if (local.name == name)
+                return true;
+        }
+
+        return global_types.contains(name);
+    }
+
+    DataType TypeChecker::elementTypeOf(const ast::IExpression* expr) const
+    {
+        if (expr->getKind() == ast::ExprKind::literal)
+        {
+            const auto& literal = static_cast<const ast::Literal&>(*expr);
+
+            return (literal.getDataType() == DataType::sequence) ? literal.toNativeType<ast::Sequence>().homogen_type : DataType::unknown;
+        }
+
+        if (expr->getKind() != ast::ExprKind::name)
+            return DataType::unknown;
+
+        ast::SymbolId name = static_cast<const ast::Name&>(*expr).getName();
+
+        for (size_t local_pos = locals.size(); local_pos > 0; local_pos--)
+        {
+            if (locals[local_pos - 1].name == name)
+                return locals[local_pos - 1].element;
+        }
+
+        auto global = global_elements.find(name);
+
+        return (global != global_elements.end()) ? global->second : DataType::unknown;
+    }
+
+    void TypeChecker::declare(ast::StmtList top_level)
+    {
+        for (const auto* stmt : top_level)
+        {
+            if (stmt->getKind() == ast::StmtKind::variable)
+            {
+                const auto& variable = static_cast<const ast::Variable&>(*stmt);
+
+                global_types.try_emplace(variable.getName(), variable.getDataType());
+            }
+            else if (stmt->getKind() == ast::StmtKind::function)
+            {
+                const auto& function = static_cast<const ast::Function&>(*stmt);
+
+                functions.try_emplace(function.getName(), &function);
+            }
+            else if (stmt->getKind() == ast::StmtKind::generic)
+            {
+                const auto& generic = static_cast<const ast::Generic&>(*stmt);
+
+                if (generic.getItem()->getKind() != ast::StmtKind::function)
+                    continue;
+
+                const auto& function = static_cast<const ast::Function&>(*generic.getItem());
+
+                functions.try_emplace(function.getName(), &function);
+                generics.try_emplace(function.getName(), &generic);
+            }
+        }
+    }
+
+    void TypeChecker::checkFunction(const ast::Function& node, std::string name)
+    {
+        locals.clear();
+        function_name = std::move(name);
+        return_type = resolveType(node.getDataType(), node.getTypeName(), bindings);
+
+        for (const auto* param : node.getParams())
+        {
+            const auto& parameter = static_cast<const ast::Parameter&>(*param);
+
+            locals.push_back({.name = parameter.getName(), .type = resolveType(parameter.getDataType(), parameter.getTypeName(), bindings), .element = DataType::unknown});
+        }
+
+        node.getBody()->acceptVisitor<void>(*this);
+    }
+
+    void TypeChecker::checkBody(const ast::IStatement* body)
+    {
+        size_t scope_mark = locals.size();
+
+        if (depth >= ast::max_nesting_depth)
+            return;
+
+        depth++;
+        body->acceptVisitor<void>(*this);
+        depth--;
+        locals.resize(scope_mark);
+    }
+
+    void TypeChecker::checkCondition(const ast::IExpression* condition, const char* where)
+    {
+        expect(DataType::boolean, infer(condition), std::string {where} + " condition");
+    }
+
+    DataType TypeChecker::inferCall(const ast::Unary& node)
+    {
+        ast::ExprList args = node.getArgs();
+        const ast::Function* callee = nullptr;
+        TypeBindings call_bindings;
+
+        if (node.getInner()->getKind() == ast::ExprKind::name)
+        {
+            const auto& callee_name = static_cast<const ast::Name&>(*node.getInner());
+
+            if (auto found = functions.find(callee_name.getName()); found != functions.end())
+                callee = found->second;
+
+            // A substitution binds the generic's parameters for this call. Without one, a generic call is checked at runtime.
+            if (const ast::Substitution* substitution = callee_name.getSubstitution(); substitution != nullptr)
+            {
+                auto generic = generics.find(callee_name.getName());
+                std::string name {symbols.nameOf(callee_name.getName())};
+
+                if (generic == generics.end())
+                    error("'" + name + "' is not generic");
+                else if (generic->second->getParams().size() != substitution->getTypeNames().size())
+                    error("'" + name + "' takes " + std::to_string(generic->second->getParams().size()) + " type argument(s) but got " + std::to_string(substitution->getTypeNames().size()));
+                else
+                    call_bindings = bindSubstitution(*generic->second, *substitution, symbols, bindings);
+            }
+        }
+
+        for (size_t arg_pos = 0; arg_pos < args.size(); arg_pos++)
+        {
+            DataType arg_type = infer(args[arg_pos]);
+
+            if (callee == nullptr || arg_pos >= callee->getParams().size())
+                continue;
+
+            const auto& param = static_cast<const ast::Parameter&>(*callee->getParams()[arg_pos]);
+
+            expect(resolveType(param.getDataType(), param.getTypeName(), call_bindings), arg_type, "argument " + std::to_string(arg_pos + 1) + " of '" + std::string {symbols.nameOf(callee->getName())} + "'");
+        }
+
+        // Builtins are not typed yet.
+        return (callee != nullptr) ? resolveType(callee->getDataType(), callee->getTypeName(), call_bindings) : DataType::unknown;
+    }
+
+    DataType TypeChecker::inferAccess(const ast::Unary& node)
+    {
+        ast::ExprList args = node.getArgs();
+        DataType target = infer(node.getInner());
+
+        // Mirrors the compiler: @(items length) reads the length unless length names a variable.
+        if (args[0]->getKind() == ast::ExprKind::name)
+        {
+            ast::SymbolId index_name = static_cast<const ast::Name*>(args[0])->getName();
+
+            if (symbols.nameOf(index_name) == "length" && !isVariable(index_name))
+            {
+                if (target != DataType::unknown && target != DataType::sequence && target != DataType::string)
+                    error("length needs a Seq or String, not " + std::string {ast::dataTypeName(target)});
+
+                types[args[0]] = DataType::integer;
+
+                return DataType::integer;
+            }
+        }
+
+        expect(DataType::sequence, target, "the target of '@'");
+        expect(DataType::integer, infer(args[0]), "a position");
+
+        return elementTypeOf(node.getInner());
+    }
+
+    DataType TypeChecker::checkOperands(ast::OpType op, DataType lhs, DataType rhs)
+    {
+        std::string spelling {opSpelling(op)};
+
+        if (op == ast::OpType::logic_and || op == ast::OpType::logic_or)
+        {
+            expect(DataType::boolean, lhs, "the left operand of '" + spelling + "'");
+            expect(DataType::boolean, rhs, "the right operand of '" + spelling + "'");
+
+            return DataType::boolean;
+        }
+
+        if (op == ast::OpType::equality || op == ast::OpType::inequality)
+        {
+            if (lhs != DataType::unknown && rhs != DataType::unknown && lhs != rhs)
+                error("cannot compare " + std::string {ast::dataTypeName(lhs)} + " with " + std::string {ast::dataTypeName(rhs)} + " using '" + spelling + "'");
+
+            return DataType::boolean;
+        }
+
+        // When one side is unknown the operator can still only succeed on the other side's type.
+        DataType operand = (lhs != DataType::unknown) ? lhs : rhs;
+        bool is_ordering = op != ast::OpType::plus && op != ast::OpType::minus && op != ast::OpType::times && op != ast::OpType::slash;
+        bool allows_string = is_ordering || op == ast::OpType::plus;
+        bool operands_ok = (lhs == DataType::unknown || rhs == DataType::unknown || lhs == rhs)
+            && (operand == DataType::unknown || isNumeric(operand) || (allows_string && operand == DataType::string));
+
+        if (!operands_ok)
+        {
+            error("operands of '" + spelling + "' must both be Integer" + (allows_string ? ", Double, or String" : " or Double") + ", not "
+                + std::string {ast::dataTypeName(lhs)} + " and " + std::string {ast::dataTypeName(rhs)});
+
+            return is_ordering ? DataType::boolean : DataType::unknown;
+        }
+
+        return is_ordering ? DataType::boolean : operand;
+    }
+
+    /* TypeChecker public impl. */
+
+    TypeChecker::TypeChecker(const ast::SymbolTable& symbols_arg)
+    : symbols {symbols_arg}, types {}, errors {}, global_types {}, functions {}, generics {}, locals {}, bindings {}, function_name {}, return_type {DataType::unknown}, depth {0}, chain {} {}
+
+    TypeTable TypeChecker::check(ast::StmtList top_level)
+    {
+        declare(top_level);
+
+        function_name = "<module>";
+
+        for (const auto* stmt : top_level)
+        {
+            if (stmt->getKind() != ast::StmtKind::variable)
+                continue;
+
+            const auto& variable = static_cast<const ast::Variable&>(*stmt);
+
+            expect(variable.getDataType(), infer(variable.getValue()), "global '" + std::string {symbols.nameOf(variable.getName())} + "'");
+
+            if (!variable.isMutable())
+                global_elements[variable.getName()] = elementTypeOf(variable.getValue());
+        }
+
+        for (const auto* stmt : top_level)
+        {
+            const ast::IStatement* item = (stmt->getKind() == ast::StmtKind::generic) ? static_cast<const ast::Generic&>(*stmt).getItem() : stmt;
+
+            if (item->getKind() == ast::StmtKind::function)
+            {
+                const auto& function = static_cast<const ast::Function&>(*item);
+
+                checkFunction(function, std::string {symbols.nameOf(function.getName())});
+            }
+        }
+
+        return std::move(types);
+    }
+
+    TypeTable TypeChecker::checkInstance(const ast::Function& node, TypeBindings instance_bindings, std::string instance_name)
+    {
+        types.clear();
+        bindings = std::move(instance_bindings);
+        checkFunction(node, std::move(instance_name));
+        bindings.clear();
+
+        return std::move(types);
+    }
+
+    const std::vector<CompileError>& TypeChecker::getErrors() const noexcept
+    {
+        return errors;
+    }
+
+    /* Expressions */
+
+    DataType TypeChecker::visitLiteral(const ast::Literal& node)
+    {
+        return node.getDataType();
+    }
+
+    DataType TypeChecker::visitUnary(const ast::Unary& node)
+    {
+        switch (node.getOpType())
+        {
+            case ast::OpType::invoke:
+                return inferCall(node);
+            case ast::OpType::access:
+                return inferAccess(node);
+            case ast::OpType::minus:
+            {
+                DataType inner = infer(node.getInner());
+
+                if (inner == DataType::unknown || isNumeric(inner))
+                    return inner;
+
+                error("operand of unary '-' must be Integer or Double, not " + std::string {ast::dataTypeName(inner)});
+                return DataType::unknown;
+            }
+            default:
+                return DataType::unknown;
+        }
+    }
+
+    DataType TypeChecker::visitBinary(const ast::Binary& node)
+    {
+        size_t chain_mark = chain.size();
+        const ast::IExpression* first = ast::collectChain(node, chain);
+        size_t chain_end = chain.size();
+        DataType lhs = infer(first);
+
+        for (size_t link_pos = chain_end; link_pos-- > chain_mark;)
+        {
+            const ast::Binary* link = chain[link_pos];
+
+            lhs = checkOperands(link->getOpType(), lhs, infer(link->getRight()));
+
+            // infer() records the outermost link itself, so only the inner ones are stored here.
+            if (link != &node)
+                types[link] = lhs;
+        }
+
+        chain.resize(chain_mark);
+
+        return lhs;
+    }
+
+    DataType TypeChecker::visitName(const ast::Name& node)
+    {
+        return typeOfName(node.getName());
+    }
+
+    /* Statements */
+
+    void TypeChecker::visitVariable(const ast::Variable& node)
+    {
+        DataType type = resolveType(node.getDataType(), node.getTypeName(), bindings);
+
+        expect(type, infer(node.getValue()), "'" + std::string {symbols.nameOf(node.getName())} + "'");
+        locals.push_back({.name = node.getName(), .type = type, .element = node.isMutable() ? DataType::unknown : elementTypeOf(node.getValue())});
+    }
+
+    void TypeChecker::visitMutation(const ast::Mutation& node)
+    {
+        expect(typeOfName(node.getName()), infer(node.getExpression()), "'" + std::string {symbols.nameOf(node.getName())} + "'");
+    }
+
+    void TypeChecker::visitFunction([[maybe_unused]] const ast::Function& node) {}
+
+    void TypeChecker::visitParameter([[maybe_unused]] const ast::Parameter& node) {}
+
+    void TypeChecker::visitBlock(const ast::Block& node)
+    {
+        size_t scope_mark = locals.size();
+
+        for (const auto* stmt : node.getStatements())
+            stmt->acceptVisitor<void>(*this);
+
+        locals.resize(scope_mark);
+    }
+
+    void TypeChecker::visitMatch(const ast::Match& node)
+    {
+        for (const auto* stmt : node.getCases())
+        {
+            const auto& match_case = static_cast<const ast::Case&>(*stmt);
+
+            checkCondition(match_case.getCondition(), "case");
+            checkBody(match_case.getBody());
+        }
+
+        if (node.getFallback() != nullptr)
+            checkBody(node.getFallback());
+    }
+
+    void TypeChecker::visitCase([[maybe_unused]] const ast::Case& node) {}
+
+    void TypeChecker::visitReturn(const ast::Return& node)
+    {
+        if (node.getResult() == nullptr)
+        {
+            expect(return_type, DataType::nil, "the result");
+            return;
+        }
+
+        expect(return_type, infer(node.getResult()), "the result");
+    }
+
+    void TypeChecker::visitWhile(const ast::While& node)
+    {
+        checkCondition(node.getConditions(), "while");
+        checkBody(node.getBody());
+    }
+
+    void TypeChecker::visitGeneric([[maybe_unused]] const ast::Generic& node) {}
+
+    void TypeChecker::visitSubstitution([[maybe_unused]] const ast::Substitution& node) {}
+
+    void TypeChecker::visitImport([[maybe_unused]] const ast::Import& node) {}
+
+    void TypeChecker::visitExprStmt(const ast::ExprStmt& node)
+    {
+        static_cast<void>(infer(node.getExpression()));
+    }
+}
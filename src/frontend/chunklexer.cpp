@@ -0,0 +1,143 @@
+/**
+ * @file chunklexer.cpp
+ * @author DrkWithT
+ * @brief Implements multi-threaded tokenizing of large sources.
+ * @date 2024-05-01
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <thread>
+#include "frontend/scanning.hpp"
+#include "frontend/lexer.hpp"
+#include "frontend/chunklexer.hpp"
+
+namespace tisp::frontend
+{
+    /* Helpers */
+
+    /// @brief Appends one chunk's tokens, joining a whitespace run that the split cut in two.
+    static void stitchChunk(TokenBuffer& result, const TokenBuffer& part, size_t part_count, size_t chunk_begin)
+    {
+        size_t first = 0;
+
+        if (part_count > 0 && !result.isEmpty())
+        {
+            Token tail = result.at(result.size() - 1);
+            Token head = part.at(0);
+
+            if (tail.type == TokenType::whitespace && head.type == TokenType::whitespace && tail.begin + tail.length == chunk_begin && head.begin == 0)
+            {
+                result.growLast(head.length);
+                first = 1;
+            }
+        }
+
+        result.appendShifted(part, first, part_count, chunk_begin);
+    }
+
+    /* Chunked lexing impl. */
+
+    std::vector<size_t> findChunkBounds(std::string_view source_view, size_t chunk_count)
+    {
+        const char* data = source_view.data();
+        size_t limit = source_view.length();
+        std::vector<size_t> bounds {0};
+
+        auto targetOf = [limit, chunk_count](size_t chunk_pos) { return limit / chunk_count * chunk_pos; };
+
+        size_t pos = 0;
+        size_t chunk_pos = 1;
+
+        // Walk code regions between comments and strings, splitting after the first newline past each target.
+        while (chunk_pos < chunk_count && pos < limit)
+        {
+            size_t opener = scanUntilEither(data, pos, limit, '#', '\"');
+
+            while (chunk_pos < chunk_count && targetOf(chunk_pos) < opener)
+            {
+                size_t lf_pos = scanUntil(data, std::max(pos, targetOf(chunk_pos)), opener, '\n');
+
+                if (lf_pos >= opener || lf_pos + 1 >= limit)
+                    break;
+
+                pos = lf_pos + 1;
+                bounds.push_back(pos);
+
+                while (chunk_pos < chunk_count && targetOf(chunk_pos) <= pos)
+                    chunk_pos++;
+            }
+
+            if (opener >= limit)
+                break;
+
+            size_t closer = scanUntil(data, opener + 1, limit, data[opener]);
+
+            pos = closer + 1;
+        }
+
+        bounds.push_back(limit);
+
+        return bounds;
+    }
+
+    TokenBuffer tokenizeSourceParallel(std::string_view source_view, size_t worker_count, TriviaMode mode, TokenBuffer* trivia)
+    {
+        if (worker_count == 0)
+            worker_count = std::max(1U, std::thread::hardware_concurrency());
+
+        if (worker_count < 2 || source_view.length() < min_parallel_source_length || source_view.length() >= TokenBuffer::max_source_length)
+        {
+            Lexer lexer {};
+
+            return lexer.tokenizeSource(source_view, mode, trivia);
+        }
+
+        std::vector<size_t> bounds = findChunkBounds(source_view, worker_count);
+        size_t chunk_count = bounds.size() - 1;
+
+        std::vector<TokenBuffer> parts (chunk_count);
+        std::vector<TokenBuffer> trivia_parts ((trivia != nullptr) ? chunk_count : 0);
+        std::vector<std::thread> workers {};
+
+        workers.reserve(chunk_count);
+
+        for (size_t chunk_pos = 0; chunk_pos < chunk_count; chunk_pos++)
+        {
+            workers.emplace_back([&, chunk_pos]() {
+                Lexer lexer {};
+                auto chunk_view = source_view.substr(bounds[chunk_pos], bounds[chunk_pos + 1] - bounds[chunk_pos]);
+                TokenBuffer* chunk_trivia = (trivia != nullptr) ? &trivia_parts[chunk_pos] : nullptr;
+
+                parts[chunk_pos] = lexer.tokenizeSource(chunk_view, mode, chunk_trivia);
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        size_t total = 0;
+
+        for (const auto& part : parts)
+            total += part.size();
+
+        TokenBuffer result {};
+
+        result.reserve(total);
+
+        for (size_t chunk_pos = 0; chunk_pos < chunk_count; chunk_pos++)
+        {
+            // Every chunk ends with its own eof, which only survives for the whole source.
+            stitchChunk(result, parts[chunk_pos], parts[chunk_pos].size() - 1, bounds[chunk_pos]);
+
+            if (trivia != nullptr)
+                stitchChunk(*trivia, trivia_parts[chunk_pos], trivia_parts[chunk_pos].size(), bounds[chunk_pos]);
+        }
+
+        result.push({.begin = source_view.length(), .length = 1, .type = TokenType::eof});
+
+        return result;
+    }
+}
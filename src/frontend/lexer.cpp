@@ -8,13 +8,16 @@
  *
  */
 
+#include <algorithm>
+#include "frontend/lexicon.hpp"
+#include "frontend/scanning.hpp"
 #include "frontend/lexer.hpp"
 
 namespace tisp::frontend
 {
     /* Lexical config for Lexer */
 
-    static const LexicalEntry entries[] {
+    static constexpr LexicalEntry entries[] {
         {.lexeme = "Boolean", .type = TokenType::tname},
         {.lexeme = "Integer", .type = TokenType::tname},
         {.lexeme = "Double", .type = TokenType::tname},
@@ -30,6 +33,9 @@ namespace tisp::frontend
         {.lexeme = "while", .type = TokenType::keyword},
         {.lexeme = "generic", .type = TokenType::keyword},
         {.lexeme = "use", .type = TokenType::keyword},
+        {.lexeme = "default", .type = TokenType::keyword},
+        {.lexeme = "true", .type = TokenType::keyword},
+        {.lexeme = "false", .type = TokenType::keyword},
         {.lexeme = "$", .type = TokenType::op_invoke},
         {.lexeme = "@", .type = TokenType::op_access},
         {.lexeme = "=", .type = TokenType::op_set},
@@ -41,21 +47,40 @@ namespace tisp::frontend
         {.lexeme = ">=", .type = TokenType::op_gte},
         {.lexeme = "<", .type = TokenType::op_lt},
         {.lexeme = "<=", .type = TokenType::op_lte},
+        {.lexeme = "==", .type = TokenType::op_eq},
+        {.lexeme = "!=", .type = TokenType::op_neq},
         {.lexeme = "&&", .type = TokenType::op_and},
         {.lexeme = "||", .type = TokenType::op_or},
         {.lexeme = ":", .type = TokenType::colon},
         {.lexeme = "->", .type = TokenType::arrow}
     };
 
-    static const size_t entry_count = 30;
+    static constexpr Lexicon lexicon {entries};
+
+    static_assert([] {
+        for (const auto& entry : entries)
+        {
+            if (lexicon.classify(entry.lexeme, TokenType::unknown) != entry.type)
+                return false;
+        }
+
+        return lexicon.classify("print", TokenType::identifier) == TokenType::identifier
+            && lexicon.classify("Seqs", TokenType::identifier) == TokenType::identifier
+            && lexicon.classify("=>", TokenType::unknown) == TokenType::unknown;
+    }(), "lexicon must classify exactly like the entries table");
+
+    std::span<const LexicalEntry> lexicalEntries() noexcept
+    {
+        return entries;
+    }
 
     /* Lexer private impl. */
 
-    void Lexer::reset(std::string_view source_view) noexcept
+    void Lexer::reset(std::string_view source_view, size_t start_pos) noexcept
     {
         source = source_view;
         limit = source.length();
-        pos = 0;
+        pos = start_pos;
     }
 
     bool Lexer::isAtEnd() const noexcept
@@ -71,59 +96,25 @@ namespace tisp::frontend
     Token Lexer::lexWhitespace() noexcept
     {
         size_t lex_begin = pos;
-        size_t lex_len = 0;
-        size_t lex_line = line;
-        char temp;
-        bool found_lf = false;
-
-        while (!isAtEnd())
-        {
-            temp = peekSymbol();
-
-            if (temp == '\n' && !found_lf)
-            {
-                line += 1;
-                found_lf = true;
-                lex_line = line;
-            }
 
-            if (!matchWhitespace(temp))
-                break;
-
-            lex_len++;
-            pos++;
-        }
+        pos = scanWhitespace(source.data(), pos, limit);
 
-        return {.begin = lex_begin, .length = lex_len, .line = lex_line, .type = TokenType::whitespace};
+        return {.begin = lex_begin, .length = pos - lex_begin, .type = TokenType::whitespace};
     }
 
-    Token Lexer::lexOtherWord() noexcept
+    Token Lexer::lexOtherWord()
     {
         size_t lex_begin = pos;
-        size_t lex_len = 0;
-        char temp;
-
-        while (!isAtEnd())
-        {
-            temp = peekSymbol();
 
-            if (!matchAlphabetic(temp))
-                break;
+        pos = scanAlphabetic(source.data(), pos, limit);
 
-            lex_len++;
-            pos++;
-        }
+        Token result {.begin = lex_begin, .length = pos - lex_begin, .type = TokenType::unknown};
+        std::string_view lexeme = viewLexeme(result, source);
 
-        Token result {.begin = lex_begin, .length = lex_len, .line = line, .type = TokenType::unknown};
+        result.type = lexicon.classify(lexeme, TokenType::identifier);
 
-        std::string lexeme = getLexeme(result, source);
-
-        if (tnames.find(lexeme) != tnames.end())
-            result.type = TokenType::tname;
-        else if (kwords.find(lexeme) != kwords.end())
-            result.type = TokenType::keyword;
-        else
-            result.type = TokenType::identifier;
+        if (symbols != nullptr && (result.type == TokenType::identifier || result.type == TokenType::tname))
+            result.symbol = symbols->intern(lexeme);
 
         return result;
     }
@@ -131,30 +122,18 @@ namespace tisp::frontend
     Token Lexer::lexNumber() noexcept
     {
         size_t lex_begin = pos;
-        size_t lex_len = 0;
-        int dots = 0;
-        char temp;
-
-        while (!isAtEnd())
-        {
-            temp = peekSymbol();
-
-            if (!matchNumeric(temp))
-                break;
 
-            if (temp == '.')
-                dots++;
+        pos = scanNumeric(source.data(), pos, limit);
 
-            lex_len++;
-            pos++;
-        }
+        size_t lex_len = pos - lex_begin;
+        auto dots = std::count(source.data() + lex_begin, source.data() + pos, '.');
 
         if (dots < 1)
-            return {.begin = lex_begin, .length = lex_len, .line = line, .type = TokenType::num_int};
+            return {.begin = lex_begin, .length = lex_len, .type = TokenType::num_int};
         else if (dots == 1)
-            return {.begin = lex_begin, .length = lex_len, .line = line, .type = TokenType::num_dbl};
+            return {.begin = lex_begin, .length = lex_len, .type = TokenType::num_dbl};
 
-        return {.begin = lex_begin, .length = lex_len, .line = line, .type = TokenType::unknown};
+        return {.begin = lex_begin, .length = lex_len, .type = TokenType::unknown};
     }
 
     Token Lexer::lexPunctuation() noexcept
@@ -174,13 +153,9 @@ namespace tisp::frontend
             pos++;
         }
 
-        Token result {.begin = lex_begin, .length = lex_len, .line = line, .type = TokenType::unknown};
-        std::string lexeme = getLexeme(result, source);
+        Token result {.begin = lex_begin, .length = lex_len, .type = TokenType::unknown};
 
-        if (symbols.find(lexeme) == symbols.end())
-            result.type = TokenType::unknown;
-        else
-            result.type = symbols.at(lexeme);
+        result.type = lexicon.classify(viewLexeme(result, source), TokenType::unknown);
 
         return result;
     }
@@ -191,7 +166,7 @@ namespace tisp::frontend
 
         pos++;
 
-        return {.begin = lex_begin, .length = 1, .line = line, .type = type};
+        return {.begin = lex_begin, .length = 1, .type = type};
     }
 
     [[nodiscard]] Token Lexer::lexBetween(char delim, TokenType type) noexcept
@@ -199,48 +174,25 @@ namespace tisp::frontend
         pos++; // skip 1st delim after it's peeked
 
         size_t lex_begin = pos;
-        size_t lex_len = 0;
-        char temp;
-
-        while (!isAtEnd())
-        {
-            temp = peekSymbol();
-
-            if (temp == delim)
-            {
-                pos++;
-                break;
-            }
+        size_t lex_end = scanUntil(source.data(), pos, limit, delim);
 
-            lex_len++;
-            pos++;
-        }
+        pos = (lex_end < limit) ? lex_end + 1 : limit;
 
-        return {.begin = lex_begin, .length = lex_len, .line = line, .type = type};
+        return {.begin = lex_begin, .length = lex_end - lex_begin, .type = type};
     }
 
     /* Lexer public impl. */
 
     Lexer::Lexer()
-    : symbols {}, kwords {}, tnames {}, source {}, limit {0}, pos {0}
-    {
-        for (size_t entries_pos = 0; entries_pos < entry_count; entries_pos++)
-        {
-            auto entry_type = entries[entries_pos].type;
-
-            if (entry_type == TokenType::tname)
-                tnames.insert(entries[entries_pos].lexeme);
-            else if (entry_type == TokenType::keyword)
-                kwords.insert(entries[entries_pos].lexeme);
-            else if (entry_type >= TokenType::op_invoke && entry_type <= TokenType::arrow)
-                symbols[entries[entries_pos].lexeme] = entry_type;
-        }
-    }
+    : source {}, symbols {nullptr}, limit {0}, pos {0} {}
+
+    Lexer::Lexer(ast::SymbolTable* symbols_arg)
+    : source {}, symbols {symbols_arg}, limit {0}, pos {0} {}
 
     Token Lexer::lexNext()
     {
         if (isAtEnd())
-            return {.begin = limit, .length = 1, .line = line, .type = TokenType::eof};
+            return {.begin = limit, .length = 1, .type = TokenType::eof};
 
         char c = peekSymbol();
 
@@ -284,20 +236,57 @@ namespace tisp::frontend
 
         pos += 1;
 
-        return {.begin = pos - 1, .length = 1, .line = line, .type = TokenType::unknown};
+        return {.begin = pos - 1, .length = 1, .type = TokenType::unknown};
     }
 
-    std::vector<Token> Lexer::tokenizeSource(std::string_view source_view)
+    Token Lexer::lexNextSignificant(TokenBuffer* trivia)
     {
+        Token next = lexNext();
+
+        while (isTrivia(next.type))
+        {
+            if (trivia != nullptr)
+                trivia->push(next);
+
+            next = lexNext();
+        }
+
+        return next;
+    }
+
+    TokenBuffer Lexer::tokenizeSource(std::string_view source_view, TriviaMode mode, TokenBuffer* trivia)
+    {
+        TokenBuffer tokens {};
+
+        // Offsets past 32 bits do not fit, so mark the whole source as one unlexable token instead of looking empty.
+        if (source_view.length() >= TokenBuffer::max_source_length)
+        {
+            tokens.push({.begin = 0, .length = 0, .type = TokenType::unknown});
+            tokens.push({.begin = 0, .length = 0, .type = TokenType::eof});
+
+            return tokens;
+        }
+
         reset(source_view);
+        tokens.reserveFor(limit, mode);
 
-        std::vector<Token> tokens {};
         Token next;
 
+        if (mode == TriviaMode::skip)
+        {
+            do
+            {
+                next = lexNextSignificant(trivia);
+                tokens.push(next);
+            } while (next.type != TokenType::eof);
+
+            return tokens;
+        }
+
         do
         {
             next = lexNext();
-            tokens.push_back(next);
+            tokens.push(next);
         } while (next.type != TokenType::eof);
 
         return tokens;
@@ -0,0 +1,60 @@
+/**
+ * @file lineindex.cpp
+ * @author DrkWithT
+ * @brief Implements lazy offset to line lookup.
+ * @date 2024-04-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include "frontend/scanning.hpp"
+#include "frontend/lineindex.hpp"
+
+namespace tisp::frontend
+{
+    /* LineIndex private impl. */
+
+    void LineIndex::build()
+    {
+        const char* data = source.data();
+        size_t limit = source.length();
+        size_t pos = 0;
+
+        line_starts.push_back(0);
+
+        while ((pos = scanUntil(data, pos, limit, '\n')) < limit)
+        {
+            pos++;
+            line_starts.push_back(pos);
+        }
+
+        built = true;
+    }
+
+    /* LineIndex public impl. */
+
+    LineIndex::LineIndex(std::string_view source_view) noexcept
+    : source {source_view}, line_starts {}, built {false} {}
+
+    SourceLocation LineIndex::locate(size_t offset)
+    {
+        if (!built)
+            build();
+
+        // The last line start at or before offset owns it.
+        auto owner = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - 1;
+        size_t line_pos = static_cast<size_t>(owner - line_starts.begin());
+
+        return {.line = line_pos + 1, .column = offset - *owner + 1};
+    }
+
+    size_t LineIndex::lineCount()
+    {
+        if (!built)
+            build();
+
+        return line_starts.size();
+    }
+}
@@ -0,0 +1,652 @@
+/**
+ * @file parser.cpp
+ * @author DrkWithT
+ * @brief Implements the recursive descent parser.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <charconv>
+#include <utility>
+#include "frontend/parser.hpp"
+
+namespace tisp::frontend
+{
+    /// @brief Thrown after an error is recorded to unwind to the declaration loop.
+    struct ParseFailure {};
+
+    /* Parser private impl. */
+
+    const Token& Parser::peek(size_t offset)
+    {
+        return tokens.peek(offset);
+    }
+
+    std::string_view Parser::lexemeOf(const Token& token) const noexcept
+    {
+        return viewLexeme(token, source);
+    }
+
+    bool Parser::atKeyword(std::string_view word)
+    {
+        const Token& current = peek();
+
+        return current.type == TokenType::keyword && lexemeOf(current) == word;
+    }
+
+    bool Parser::match(TokenType type)
+    {
+        if (peek().type != type)
+            return false;
+
+        static_cast<void>(tokens.next());
+
+        return true;
+    }
+
+    Token Parser::expect(TokenType type, const char* what)
+    {
+        if (peek().type != type)
+            fail(peek(), std::string {"expected "} + what);
+
+        return tokens.next();
+    }
+
+    void Parser::expectKeyword(std::string_view word)
+    {
+        if (!atKeyword(word))
+            fail(peek(), "expected '" + std::string {word} + "'");
+
+        static_cast<void>(tokens.next());
+    }
+
+    void Parser::fail(const Token& token, std::string message)
+    {
+        errors.push_back({.offset = token.begin, .message = std::move(message)});
+
+        throw ParseFailure {};
+    }
+
+    void Parser::enterNesting(const char* what)
+    {
+        if (depth >= ast::max_nesting_depth)
+            fail(peek(), std::string {what} + " is nested too deeply");
+
+        depth++;
+    }
+
+    void Parser::synchronize()
+    {
+        // Skip at least one token so a bad declaration keyword cannot loop forever.
+        static_cast<void>(tokens.next());
+
+        while (!tokens.isAtEnd())
+        {
+            if (atKeyword("defun") || atKeyword("generic") || atKeyword("use"))
+                return;
+
+            static_cast<void>(tokens.next());
+        }
+    }
+
+    ast::SymbolId Parser::parseIdentifier()
+    {
+        return expect(TokenType::identifier, "an identifier").symbol;
+    }
+
+    ast::SymbolId Parser::parseTypeName()
+    {
+        const Token& current = peek();
+
+        if (current.type != TokenType::tname && current.type != TokenType::identifier)
+            fail(current, "expected a type name");
+
+        return tokens.next().symbol;
+    }
+
+    ast::DataType Parser::dataTypeOf(ast::SymbolId type_name) const
+    {
+        // Generic parameters and ADT names stay unknown here and are resolved by name later.
+        return ast::dataTypeFromName(symbols.nameOf(type_name));
+    }
+
+    /* Statements */
+
+    const ast::IStatement* Parser::parseOuter()
+    {
+        if (atKeyword("const") || atKeyword("var"))
+            return parseVariable();
+        else if (atKeyword("defun"))
+            return parseFunction();
+        else if (atKeyword("generic"))
+            return parseGeneric();
+        else if (atKeyword("use"))
+            return parseImport();
+
+        fail(peek(), "expected a declaration");
+    }
+
+    const ast::IStatement* Parser::parseInner()
+    {
+        if (atKeyword("const") || atKeyword("var"))
+            return parseVariable();
+        else if (atKeyword("defun"))
+            return parseFunction();
+        else if (atKeyword("match"))
+            return parseMatch();
+        else if (atKeyword("while"))
+            return parseWhile();
+        else if (atKeyword("return"))
+            return parseReturn();
+        else if (peek().type == TokenType::identifier && peek(1).type == TokenType::op_set)
+            return parseMutation();
+
+        return context.make<ast::ExprStmt>(parseExpr());
+    }
+
+    const ast::IStatement* Parser::parseBlock()
+    {
+        std::vector<const ast::IStatement*> stmts;
+
+        enterNesting("block");
+        expect(TokenType::lbrace, "'{'");
+
+        while (peek().type != TokenType::rbrace)
+        {
+            if (tokens.isAtEnd())
+                fail(peek(), "expected '}'");
+
+            stmts.push_back(parseInner());
+        }
+
+        static_cast<void>(tokens.next());
+        depth--;
+
+        return context.make<ast::Block>(context.makeList(stmts));
+    }
+
+    const ast::IStatement* Parser::parseVariable()
+    {
+        bool is_var = atKeyword("var");
+
+        static_cast<void>(tokens.next());
+
+        ast::SymbolId name = parseIdentifier();
+
+        expect(TokenType::colon, "':'");
+
+        ast::SymbolId type_name = parseTypeName();
+        const ast::IExpression* rv = parseExpr();
+
+        return context.make<ast::Variable>(name, rv, dataTypeOf(type_name), is_var, type_name);
+    }
+
+    const ast::IStatement* Parser::parseMutation()
+    {
+        ast::SymbolId name = parseIdentifier();
+
+        expect(TokenType::op_set, "'='");
+
+        return context.make<ast::Mutation>(name, parseExpr());
+    }
+
+    const ast::IStatement* Parser::parseFunction()
+    {
+        std::vector<const ast::IStatement*> params;
+
+        expectKeyword("defun");
+
+        ast::SymbolId name = parseIdentifier();
+
+        expect(TokenType::lparen, "'('");
+
+        while (!match(TokenType::rparen))
+        {
+            ast::SymbolId param_name = parseIdentifier();
+
+            expect(TokenType::colon, "':'");
+
+            ast::SymbolId param_type = parseTypeName();
+
+            params.push_back(context.make<ast::Parameter>(param_name, dataTypeOf(param_type), param_type));
+            static_cast<void>(match(TokenType::comma));
+        }
+
+        expect(TokenType::arrow, "'->'");
+
+        ast::SymbolId result_type = parseTypeName();
+        const ast::IStatement* body = parseBlock();
+
+        return context.make<ast::Function>(name, context.makeList(params), body, dataTypeOf(result_type), result_type);
+    }
+
+    const ast::IStatement* Parser::parseMatch()
+    {
+        std::vector<const ast::IStatement*> cases;
+        const ast::IStatement* fallback = nullptr;
+
+        expectKeyword("match");
+
+        ast::SymbolId input = parseIdentifier();
+
+        expect(TokenType::lbrace, "'{'");
+
+        while (atKeyword("case"))
+        {
+            static_cast<void>(tokens.next());
+
+            const ast::IExpression* condition = parseExpr();
+            const ast::IStatement* body = parseBlock();
+
+            cases.push_back(context.make<ast::Case>(condition, body));
+        }
+
+        if (atKeyword("default"))
+        {
+            static_cast<void>(tokens.next());
+            fallback = parseBlock();
+        }
+
+        expect(TokenType::rbrace, "'}' after match cases");
+
+        return context.make<ast::Match>(input, context.makeList(cases), fallback);
+    }
+
+    const ast::IStatement* Parser::parseReturn()
+    {
+        expectKeyword("return");
+
+        if (peek().type == TokenType::rbrace)
+            return context.make<ast::Return>(nullptr);
+
+        return context.make<ast::Return>(parseExpr());
+    }
+
+    const ast::IStatement* Parser::parseWhile()
+    {
+        expectKeyword("while");
+
+        const ast::IExpression* conditions = parseExpr();
+        const ast::IStatement* body = parseBlock();
+
+        return context.make<ast::While>(conditions, body);
+    }
+
+    const ast::IStatement* Parser::parseGeneric()
+    {
+        std::vector<ast::SymbolId> params;
+
+        expectKeyword("generic");
+        expect(TokenType::lparen, "'('");
+
+        while (!match(TokenType::rparen))
+        {
+            params.push_back(parseIdentifier());
+            static_cast<void>(match(TokenType::comma));
+        }
+
+        return context.make<ast::Generic>(context.makeList(params), parseFunction());
+    }
+
+    const ast::IStatement* Parser::parseImport()
+    {
+        std::vector<ast::SymbolId> item_path;
+
+        expectKeyword("use");
+        item_path.push_back(parseIdentifier());
+
+        while (match(TokenType::dot))
+            item_path.push_back(parseIdentifier());
+
+        return context.make<ast::Import>(context.makeList(item_path));
+    }
+
+    /* Expressions */
+
+    const ast::IExpression* Parser::parseExpr()
+    {
+        enterNesting("expression");
+
+        const ast::IExpression* result = parseConditional();
+
+        depth--;
+
+        return result;
+    }
+
+    const ast::IExpression* Parser::parseConditional()
+    {
+        const ast::IExpression* lhs = parseCompare();
+
+        // Chains grow a left-deep tree, but the parser loops over them and every pass walks them with ast::collectChain, so links do not count toward the depth limit.
+        while (peek().type == TokenType::op_and || peek().type == TokenType::op_or)
+        {
+            ast::OpType op = (tokens.next().type == TokenType::op_and) ? ast::OpType::logic_and : ast::OpType::logic_or;
+
+            lhs = context.make<ast::Binary>(lhs, parseCompare(), op);
+        }
+
+        return lhs;
+    }
+
+    const ast::IExpression* Parser::parseCompare()
+    {
+        const ast::IExpression* lhs = parseTerm();
+        ast::OpType op;
+
+        switch (peek().type)
+        {
+            case TokenType::op_eq:
+                op = ast::OpType::equality;
+                break;
+            case TokenType::op_neq:
+                op = ast::OpType::inequality;
+                break;
+            case TokenType::op_gt:
+                op = ast::OpType::greater;
+                break;
+            case TokenType::op_gte:
+                op = ast::OpType::atleast;
+                break;
+            case TokenType::op_lt:
+                op = ast::OpType::lesser;
+                break;
+            case TokenType::op_lte:
+                op = ast::OpType::atmost;
+                break;
+            default:
+                return lhs;
+        }
+
+        static_cast<void>(tokens.next());
+
+        return context.make<ast::Binary>(lhs, parseTerm(), op);
+    }
+
+    const ast::IExpression* Parser::parseTerm()
+    {
+        const ast::IExpression* lhs = parseFactor();
+
+        while (peek().type == TokenType::op_plus || peek().type == TokenType::op_minus)
+        {
+            ast::OpType op = (tokens.next().type == TokenType::op_plus) ? ast::OpType::plus : ast::OpType::minus;
+
+            lhs = context.make<ast::Binary>(lhs, parseFactor(), op);
+        }
+
+        return lhs;
+    }
+
+    const ast::IExpression* Parser::parseFactor()
+    {
+        const ast::IExpression* lhs = parseUnary();
+
+        while (peek().type == TokenType::op_times || peek().type == TokenType::op_slash)
+        {
+            ast::OpType op = (tokens.next().type == TokenType::op_times) ? ast::OpType::times : ast::OpType::slash;
+
+            lhs = context.make<ast::Binary>(lhs, parseUnary(), op);
+        }
+
+        return lhs;
+    }
+
+    const ast::IExpression* Parser::parseUnary()
+    {
+        TokenType prefix = peek().type;
+
+        if (prefix == TokenType::op_invoke)
+        {
+            std::vector<const ast::IExpression*> args;
+
+            static_cast<void>(tokens.next());
+            expect(TokenType::lparen, "'(' after '$'");
+
+            const ast::IExpression* callee = parseCallee();
+
+            while (!match(TokenType::rparen))
+            {
+                if (tokens.isAtEnd())
+                    fail(peek(), "expected ')' after call arguments");
+
+                args.push_back(parseExpr());
+            }
+
+            return context.make<ast::Unary>(callee, ast::OpType::invoke, context.makeList(args));
+        }
+        else if (prefix == TokenType::op_access)
+        {
+            std::vector<const ast::IExpression*> index;
+
+            static_cast<void>(tokens.next());
+            expect(TokenType::lparen, "'(' after '@'");
+
+            const ast::IExpression* target = parseExpr();
+
+            index.push_back(parseExpr());
+            expect(TokenType::rparen, "')' after access index");
+
+            return context.make<ast::Unary>(target, ast::OpType::access, context.makeList(index));
+        }
+        else if (prefix == TokenType::op_minus)
+        {
+            static_cast<void>(tokens.next());
+            enterNesting("expression");
+
+            const ast::IExpression* inner = parseUnary();
+
+            depth--;
+
+            return context.make<ast::Unary>(inner, ast::OpType::minus);
+        }
+
+        return parsePrimary();
+    }
+
+    const ast::IExpression* Parser::parseCallee()
+    {
+        const Token& callee = peek();
+
+        if (callee.type != TokenType::identifier)
+            fail(callee, "expected a function name after '$('");
+
+        ast::SymbolId name = parseIdentifier();
+        const Token& after = peek();
+
+        // addAny(Integer) is a substitution only when the '(' touches the name, since $(f (x)) passes (x) as an argument.
+        if (after.type != TokenType::lparen || after.begin != callee.begin + callee.length)
+            return context.make<ast::Name>(name);
+
+        std::vector<ast::SymbolId> type_names;
+
+        static_cast<void>(tokens.next());
+
+        while (!match(TokenType::rparen))
+        {
+            const Token& type_name = peek();
+
+            if (type_name.type != TokenType::tname && type_name.type != TokenType::identifier)
+                fail(type_name, "expected a type name in substitution");
+
+            type_names.push_back(tokens.next().symbol);
+        }
+
+        const auto* substitution = context.make<ast::Substitution>(name, context.makeList(type_names));
+
+        return context.make<ast::Name>(name, substitution);
+    }
+
+    const ast::IExpression* Parser::parsePrimary()
+    {
+        const Token& current = peek();
+        std::string_view lexeme = lexemeOf(current);
+
+        switch (current.type)
+        {
+            case TokenType::num_int:
+            {
+                int64_t value = 0;
+                auto [end, status] = std::from_chars(lexeme.data(), lexeme.data() + lexeme.length(), value);
+
+                // Integers are 48-bit at runtime, so a wider literal could not keep its value.
+                if (status != std::errc {} || end != lexeme.data() + lexeme.length() || value > ast::max_integer)
+                    fail(current, "integer literal is out of range");
+
+                static_cast<void>(tokens.next());
+
+                return context.make<ast::Literal>(value);
+            }
+            case TokenType::num_dbl:
+            {
+                double value = 0.0;
+                auto [end, status] = std::from_chars(lexeme.data(), lexeme.data() + lexeme.length(), value);
+
+                if (status != std::errc {} || end != lexeme.data() + lexeme.length())
+                    fail(current, "malformed double literal");
+
+                static_cast<void>(tokens.next());
+
+                return context.make<ast::Literal>(value);
+            }
+            case TokenType::strbody:
+            {
+                std::string text {lexeme};
+
+                static_cast<void>(tokens.next());
+
+                return context.make<ast::Literal>(std::move(text));
+            }
+            case TokenType::keyword:
+                if (lexeme == "true" || lexeme == "false")
+                {
+                    bool value = lexeme == "true";
+
+                    static_cast<void>(tokens.next());
+
+                    return context.make<ast::Literal>(value);
+                }
+                break;
+            case TokenType::tname:
+                if (lexeme == "Nil")
+                {
+                    static_cast<void>(tokens.next());
+
+                    return context.make<ast::Literal>();
+                }
+                break;
+            case TokenType::identifier:
+                return context.make<ast::Name>(parseIdentifier());
+            case TokenType::lbrack:
+                return parseSequence();
+            case TokenType::lparen:
+            {
+                static_cast<void>(tokens.next());
+
+                const ast::IExpression* inner = parseExpr();
+
+                expect(TokenType::rparen, "')'");
+
+                return inner;
+            }
+            default:
+                break;
+        }
+
+        fail(current, "expected an expression");
+    }
+
+    const ast::IExpression* Parser::parseSequence()
+    {
+        std::vector<std::any> items;
+        ast::DataType homogen_type = ast::DataType::unknown;
+
+        expect(TokenType::lbrack, "'['");
+
+        while (!match(TokenType::rbrack))
+        {
+            // Copied, since peek's reference is into the lookahead the item is parsed out of. Errors point at the item, not at what follows it.
+            const Token item_start = peek();
+            const ast::IExpression* item = parseUnary();
+            bool negate = false;
+
+            if (item->getKind() == ast::ExprKind::unary && static_cast<const ast::Unary*>(item)->getOpType() == ast::OpType::minus)
+            {
+                negate = true;
+                item = static_cast<const ast::Unary*>(item)->getInner();
+            }
+
+            if (item->getKind() != ast::ExprKind::literal)
+                fail(item_start, "sequence items must be literals");
+
+            const auto& literal = static_cast<const ast::Literal&>(*item);
+            ast::DataType item_type = literal.getDataType();
+
+            switch (item_type)
+            {
+                case ast::DataType::boolean:
+                    items.emplace_back(literal.toNativeType<bool>());
+                    break;
+                case ast::DataType::integer:
+                    items.emplace_back(negate ? -literal.toNativeType<int64_t>() : literal.toNativeType<int64_t>());
+                    break;
+                case ast::DataType::ndouble:
+                    items.emplace_back(negate ? -literal.toNativeType<double>() : literal.toNativeType<double>());
+                    break;
+                case ast::DataType::string:
+                    items.emplace_back(literal.toNativeType<std::string>());
+                    break;
+                default:
+                    fail(item_start, "sequence items must be Boolean, Integer, Double, or String");
+            }
+
+            if (negate && item_type != ast::DataType::integer && item_type != ast::DataType::ndouble)
+                fail(item_start, "only numbers can be negated");
+
+            if (items.size() == 1)
+                homogen_type = item_type;
+            else if (homogen_type != item_type)
+                fail(item_start, "sequence items must all have the same type");
+
+            static_cast<void>(match(TokenType::comma));
+        }
+
+        return context.make<ast::Literal>(ast::Sequence {std::move(items), homogen_type});
+    }
+
+    /* Parser public impl. */
+
+    Parser::Parser(std::string_view source_view, ast::AstContext& context_arg, ast::SymbolTable& symbols_arg)
+    : tokens {source_view, TokenStream::default_lookahead, TriviaMode::skip, &symbols_arg}, source {source_view}, context {context_arg}, symbols {symbols_arg}, errors {}, depth {0} {}
+
+    ast::StmtList Parser::parseModule()
+    {
+        std::vector<const ast::IStatement*> top_level;
+
+        while (!tokens.isAtEnd())
+        {
+            try
+            {
+                top_level.push_back(parseOuter());
+            }
+            catch (const ParseFailure&)
+            {
+                depth = 0;
+                synchronize();
+            }
+        }
+
+        return context.makeList(top_level);
+    }
+
+    const std::vector<ParseError>& Parser::getErrors() const noexcept
+    {
+        return errors;
+    }
+
+    size_t Parser::getTokenCount() const noexcept
+    {
+        return tokens.consumedCount();
+    }
+}
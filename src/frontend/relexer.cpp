@@ -0,0 +1,90 @@
+/**
+ * @file relexer.cpp
+ * @author DrkWithT
+ * @brief Implements incremental re-lexing after source edits.
+ * @date 2024-05-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "frontend/lexer.hpp"
+#include "frontend/relexer.hpp"
+
+namespace tisp::frontend
+{
+    /// @brief Comment and string tokens begin after their opening delimiter, so their text really starts a byte earlier.
+    static size_t startOf(const Token& token) noexcept
+    {
+        if (token.type == TokenType::comment || token.type == TokenType::strbody)
+            return token.begin - 1;
+
+        return token.begin;
+    }
+
+    RelexResult relexSource(TokenBuffer& tokens, std::string_view new_source, const SourceEdit& edit, TriviaMode mode)
+    {
+        Lexer lexer {};
+
+        // An empty unknown token is how tokenizeSource marks an oversized source, which has no real tokens to keep.
+        bool was_oversized = !tokens.isEmpty() && tokens.typeAt(0) == TokenType::unknown && tokens.at(0).length == 0;
+
+        if (tokens.isEmpty() || was_oversized || new_source.length() >= TokenBuffer::max_source_length)
+        {
+            size_t old_count = tokens.size();
+
+            tokens = lexer.tokenizeSource(new_source, mode);
+
+            return {.first = 0, .removed_count = old_count, .inserted_count = tokens.size()};
+        }
+
+        // A token ending right at the edit may absorb inserted text, so restart at the one covering the byte before it.
+        size_t first = (edit.offset > 0) ? tokens.indexAtOrBefore(edit.offset - 1) : 0;
+        size_t restart_pos = startOf(tokens.at(first));
+
+        // Skipped trivia can leave the first kept token after the edit, so restart from the top then.
+        if (first == 0 && (edit.offset == 0 || restart_pos >= edit.offset))
+            restart_pos = 0;
+
+        size_t old_edit_end = edit.offset + edit.removed_length;
+        size_t new_edit_end = edit.offset + edit.inserted_text.length();
+        auto shift = static_cast<std::ptrdiff_t>(edit.inserted_text.length()) - static_cast<std::ptrdiff_t>(edit.removed_length);
+
+        TokenBuffer fresh {};
+        size_t old_pos = first;
+        size_t old_count = tokens.size();
+
+        lexer.reset(new_source, restart_pos);
+
+        while (true)
+        {
+            Token next = (mode == TriviaMode::skip) ? lexer.lexNextSignificant(nullptr) : lexer.lexNext();
+
+            size_t next_start = startOf(next);
+
+            if (next_start >= new_edit_end)
+            {
+                size_t old_start = static_cast<size_t>(static_cast<std::ptrdiff_t>(next_start) - shift);
+
+                while (old_pos < old_count && startOf(tokens.at(old_pos)) < old_start)
+                    old_pos++;
+
+                // Identical text from a token start lexes identically, so the old tail is still valid.
+                if (old_pos < old_count && old_start >= old_edit_end && startOf(tokens.at(old_pos)) == old_start)
+                    break;
+            }
+
+            fresh.push(next);
+
+            if (next.type == TokenType::eof)
+            {
+                old_pos = old_count;
+                break;
+            }
+        }
+
+        tokens.splice(first, old_pos, fresh, shift);
+
+        return {.first = first, .removed_count = old_pos - first, .inserted_count = fresh.size()};
+    }
+}
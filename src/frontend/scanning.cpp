@@ -0,0 +1,333 @@
+/**
+ * @file scanning.cpp
+ * @author DrkWithT
+ * @brief Implements vectorized character class scanning for the lexer.
+ * @date 2024-04-27
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <atomic>
+#include "frontend/lexer.hpp"
+#include "frontend/scanning.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TISP_SCAN_X86 1
+#include <immintrin.h>
+#else
+#define TISP_SCAN_X86 0
+#endif
+
+namespace tisp::frontend
+{
+    enum class CharClass
+    {
+        whitespace,
+        alphabetic,
+        numeric
+    };
+
+    /* Scalar kernels */
+
+    template <CharClass Cc>
+    constexpr bool matchClass(char c) noexcept
+    {
+        if constexpr (Cc == CharClass::whitespace)
+            return matchWhitespace(c);
+        else if constexpr (Cc == CharClass::alphabetic)
+            return matchAlphabetic(c);
+        else
+            return matchNumeric(c);
+    }
+
+    template <CharClass Cc>
+    static size_t scanRunScalar(const char* data, size_t pos, size_t limit) noexcept
+    {
+        while (pos < limit && matchClass<Cc>(data[pos]))
+            pos++;
+
+        return pos;
+    }
+
+    static size_t scanUntilScalar(const char* data, size_t pos, size_t limit, char target) noexcept
+    {
+        while (pos < limit && data[pos] != target)
+            pos++;
+
+        return pos;
+    }
+
+    static size_t scanUntilEitherScalar(const char* data, size_t pos, size_t limit, char first, char second) noexcept
+    {
+        while (pos < limit && data[pos] != first && data[pos] != second)
+            pos++;
+
+        return pos;
+    }
+
+#if TISP_SCAN_X86
+
+    /* SSE2 kernels: always present on x86-64. */
+
+    template <CharClass Cc>
+    static inline __m128i classMaskSse2(__m128i chunk) noexcept
+    {
+        if constexpr (Cc == CharClass::whitespace)
+        {
+            __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+            __m128i breaks = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+
+            return _mm_or_si128(spaces, breaks);
+        }
+        else if constexpr (Cc == CharClass::alphabetic)
+        {
+            // Folding case maps A-Z onto a-z; bytes >= 0x80 compare as negative and drop out.
+            __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+            __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+
+            return _mm_or_si128(letters, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+        }
+        else
+        {
+            __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+
+            return _mm_or_si128(digits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('.')));
+        }
+    }
+
+    template <CharClass Cc>
+    static size_t scanRunSse2(const char* data, size_t pos, size_t limit) noexcept
+    {
+        while (pos + 16 <= limit)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            unsigned misses = ~static_cast<unsigned>(_mm_movemask_epi8(classMaskSse2<Cc>(chunk))) & 0xffffU;
+
+            if (misses != 0)
+                return pos + __builtin_ctz(misses);
+
+            pos += 16;
+        }
+
+        return scanRunScalar<Cc>(data, pos, limit);
+    }
+
+    static size_t scanUntilSse2(const char* data, size_t pos, size_t limit, char target) noexcept
+    {
+        const __m128i needle = _mm_set1_epi8(target);
+
+        while (pos + 16 <= limit)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+
+            pos += 16;
+        }
+
+        return scanUntilScalar(data, pos, limit, target);
+    }
+
+    static size_t scanUntilEitherSse2(const char* data, size_t pos, size_t limit, char first, char second) noexcept
+    {
+        const __m128i needle_a = _mm_set1_epi8(first);
+        const __m128i needle_b = _mm_set1_epi8(second);
+
+        while (pos + 16 <= limit)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, needle_a), _mm_cmpeq_epi8(chunk, needle_b));
+            unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(matches));
+
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+
+            pos += 16;
+        }
+
+        return scanUntilEitherScalar(data, pos, limit, first, second);
+    }
+
+    /* AVX2 kernels: only called after a CPUID check. */
+
+    template <CharClass Cc>
+    __attribute__((target("avx2"))) static inline __m256i classMaskAvx2(__m256i chunk) noexcept
+    {
+        if constexpr (Cc == CharClass::whitespace)
+        {
+            __m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t')));
+            __m256i breaks = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+
+            return _mm256_or_si256(spaces, breaks);
+        }
+        else if constexpr (Cc == CharClass::alphabetic)
+        {
+            __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+            __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+
+            return _mm256_or_si256(letters, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+        }
+        else
+        {
+            __m256i digits = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+
+            return _mm256_or_si256(digits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('.')));
+        }
+    }
+
+    template <CharClass Cc>
+    __attribute__((target("avx2"))) static size_t scanRunAvx2(const char* data, size_t pos, size_t limit) noexcept
+    {
+        while (pos + 32 <= limit)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            unsigned misses = ~static_cast<unsigned>(_mm256_movemask_epi8(classMaskAvx2<Cc>(chunk)));
+
+            if (misses != 0)
+                return pos + __builtin_ctz(misses);
+
+            pos += 32;
+        }
+
+        return scanRunSse2<Cc>(data, pos, limit);
+    }
+
+    __attribute__((target("avx2"))) static size_t scanUntilAvx2(const char* data, size_t pos, size_t limit, char target) noexcept
+    {
+        const __m256i needle = _mm256_set1_epi8(target);
+
+        while (pos + 32 <= limit)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            unsigned hits = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+
+            pos += 32;
+        }
+
+        return scanUntilSse2(data, pos, limit, target);
+    }
+
+    __attribute__((target("avx2"))) static size_t scanUntilEitherAvx2(const char* data, size_t pos, size_t limit, char first, char second) noexcept
+    {
+        const __m256i needle_a = _mm256_set1_epi8(first);
+        const __m256i needle_b = _mm256_set1_epi8(second);
+
+        while (pos + 32 <= limit)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, needle_a), _mm256_cmpeq_epi8(chunk, needle_b));
+            unsigned hits = static_cast<unsigned>(_mm256_movemask_epi8(matches));
+
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+
+            pos += 32;
+        }
+
+        return scanUntilEitherSse2(data, pos, limit, first, second);
+    }
+
+#endif
+
+    /* Dispatch */
+
+    static ScanKernel detectScanKernel() noexcept
+    {
+#if TISP_SCAN_X86
+        return __builtin_cpu_supports("avx2") ? ScanKernel::avx2 : ScanKernel::sse2;
+#else
+        return ScanKernel::scalar;
+#endif
+    }
+
+    static const ScanKernel best_kernel = detectScanKernel();
+    static std::atomic<ScanKernel> active_kernel {best_kernel};
+
+    ScanKernel bestScanKernel() noexcept
+    {
+        return best_kernel;
+    }
+
+    bool useScanKernel(ScanKernel kernel) noexcept
+    {
+        if (kernel > best_kernel)
+            return false;
+
+        active_kernel.store(kernel, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    template <CharClass Cc>
+    static size_t scanRun(const char* data, size_t pos, size_t limit) noexcept
+    {
+#if TISP_SCAN_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case ScanKernel::avx2:
+                return scanRunAvx2<Cc>(data, pos, limit);
+            case ScanKernel::sse2:
+                return scanRunSse2<Cc>(data, pos, limit);
+            default:
+                break;
+        }
+#endif
+
+        return scanRunScalar<Cc>(data, pos, limit);
+    }
+
+    size_t scanWhitespace(const char* data, size_t pos, size_t limit) noexcept
+    {
+        return scanRun<CharClass::whitespace>(data, pos, limit);
+    }
+
+    size_t scanAlphabetic(const char* data, size_t pos, size_t limit) noexcept
+    {
+        return scanRun<CharClass::alphabetic>(data, pos, limit);
+    }
+
+    size_t scanNumeric(const char* data, size_t pos, size_t limit) noexcept
+    {
+        return scanRun<CharClass::numeric>(data, pos, limit);
+    }
+
+    size_t scanUntil(const char* data, size_t pos, size_t limit, char target) noexcept
+    {
+#if TISP_SCAN_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case ScanKernel::avx2:
+                return scanUntilAvx2(data, pos, limit, target);
+            case ScanKernel::sse2:
+                return scanUntilSse2(data, pos, limit, target);
+            default:
+                break;
+        }
+#endif
+
+        return scanUntilScalar(data, pos, limit, target);
+    }
+
+    size_t scanUntilEither(const char* data, size_t pos, size_t limit, char first, char second) noexcept
+    {
+#if TISP_SCAN_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case ScanKernel::avx2:
+                return scanUntilEitherAvx2(data, pos, limit, first, second);
+            case ScanKernel::sse2:
+                return scanUntilEitherSse2(data, pos, limit, first, second);
+            default:
+                break;
+        }
+#endif
+
+        return scanUntilEitherScalar(data, pos, limit, first, second);
+    }
+}
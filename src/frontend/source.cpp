@@ -0,0 +1,180 @@
+/**
+ * @file source.cpp
+ * @author DrkWithT
+ * @brief Implements source file loading.
+ * @date 2024-04-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <utility>
+#include "frontend/source.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TISP_SOURCE_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TISP_SOURCE_POSIX 0
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#endif
+
+namespace tisp::frontend
+{
+    /* SourceBuffer private impl. */
+
+#if TISP_SOURCE_POSIX
+    SourceBuffer SourceBuffer::fromDescriptor(int fd)
+    {
+        SourceBuffer result {};
+        struct stat info {};
+
+        if (fstat(fd, &info) != 0)
+            return result;
+
+        if (S_ISREG(info.st_mode))
+        {
+            size_t file_length = static_cast<size_t>(info.st_size);
+
+            if (file_length == 0)
+            {
+                result.loaded = true;
+                return result;
+            }
+
+            void* region = mmap(nullptr, file_length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (region != MAP_FAILED)
+            {
+#ifdef MADV_SEQUENTIAL
+                madvise(region, file_length, MADV_SEQUENTIAL);
+#endif
+                result.mapped = static_cast<const char*>(region);
+                result.mapped_length = file_length;
+                result.loaded = true;
+
+                return result;
+            }
+
+            result.storage.reserve(file_length);
+        }
+
+        // Pipes, terminals, and unmappable files are read in chunks until EOF.
+        constexpr size_t chunk_size = 65536;
+        size_t used = result.storage.size();
+
+        while (true)
+        {
+            result.storage.resize(used + chunk_size);
+
+            ssize_t got = read(fd, result.storage.data() + used, chunk_size);
+
+            if (got < 0)
+            {
+                result.storage.clear();
+                return result;
+            }
+
+            if (got == 0)
+                break;
+
+            used += static_cast<size_t>(got);
+        }
+
+        result.storage.resize(used);
+        result.loaded = true;
+
+        return result;
+    }
+#else
+    SourceBuffer SourceBuffer::fromDescriptor([[maybe_unused]] int fd)
+    {
+        SourceBuffer result {};
+
+        result.storage.assign(std::istreambuf_iterator<char> {std::cin}, std::istreambuf_iterator<char> {});
+        result.loaded = !std::cin.bad();
+
+        return result;
+    }
+#endif
+
+    /* SourceBuffer public impl. */
+
+    SourceBuffer::SourceBuffer() noexcept
+    : storage {}, mapped {nullptr}, mapped_length {0}, loaded {false} {}
+
+    SourceBuffer::~SourceBuffer()
+    {
+#if TISP_SOURCE_POSIX
+        if (mapped != nullptr)
+            munmap(const_cast<char*>(mapped), mapped_length);
+#endif
+    }
+
+    SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : storage(std::move(other.storage)), mapped {std::exchange(other.mapped, nullptr)}, mapped_length {std::exchange(other.mapped_length, 0)}, loaded {std::exchange(other.loaded, false)} {}
+
+    SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            std::swap(storage, other.storage);
+            std::swap(mapped, other.mapped);
+            std::swap(mapped_length, other.mapped_length);
+            std::swap(loaded, other.loaded);
+        }
+
+        return *this;
+    }
+
+    SourceBuffer SourceBuffer::fromPath(const std::string& file_path)
+    {
+#if TISP_SOURCE_POSIX
+        if (file_path == "-")
+            return fromDescriptor(STDIN_FILENO);
+
+        int fd = open(file_path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+            return SourceBuffer {};
+
+        SourceBuffer result = fromDescriptor(fd);
+
+        close(fd);
+
+        return result;
+#else
+        if (file_path == "-")
+            return fromDescriptor(0);
+
+        SourceBuffer result {};
+        std::ifstream reader {file_path, std::ios::binary};
+
+        if (!reader.is_open())
+            return result;
+
+        result.storage.assign(std::istreambuf_iterator<char> {reader}, std::istreambuf_iterator<char> {});
+        result.loaded = !reader.bad();
+
+        return result;
+#endif
+    }
+
+    bool SourceBuffer::isLoaded() const noexcept
+    {
+        return loaded;
+    }
+
+    std::string_view SourceBuffer::view() const noexcept
+    {
+        if (mapped != nullptr)
+            return {mapped, mapped_length};
+
+        return storage;
+    }
+}
@@ -0,0 +1,275 @@
+/**
+ * @file tokenbuffer.cpp
+ * @author DrkWithT
+ * @brief Implements compact token storage.
+ * @date 2024-04-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include "frontend/tokenbuffer.hpp"
+
+namespace tisp::frontend
+{
+    /* TokenBuffer private impl. */
+
+    size_t TokenBuffer::slotOf(size_t index) const noexcept
+    {
+        return (index < gap_begin) ? index : index + gap_length;
+    }
+
+    uint32_t TokenBuffer::shiftAt(size_t index) const noexcept
+    {
+        return (index >= gap_begin) ? pending_shift : 0;
+    }
+
+    uint32_t TokenBuffer::beginAt(size_t index) const noexcept
+    {
+        return begins[slotOf(index)] + shiftAt(index);
+    }
+
+    void TokenBuffer::moveGap(size_t index)
+    {
+        if (gap_length == 0 && pending_shift == 0)
+        {
+            gap_begin = index;
+            return;
+        }
+
+        if (index < gap_begin)
+        {
+            // Tokens [index, gap_begin) hop over the gap and start carrying the pending shift.
+            std::move_backward(kinds.begin() + index, kinds.begin() + gap_begin, kinds.begin() + gap_begin + gap_length);
+            std::move_backward(lengths.begin() + index, lengths.begin() + gap_begin, lengths.begin() + gap_begin + gap_length);
+            std::move_backward(begins.begin() + index, begins.begin() + gap_begin, begins.begin() + gap_begin + gap_length);
+            std::for_each(begins.begin() + index + gap_length, begins.begin() + gap_begin + gap_length, [this](uint32_t& begin) { begin -= pending_shift; });
+        }
+        else if (index > gap_begin)
+        {
+            std::move(kinds.begin() + gap_begin + gap_length, kinds.begin() + index + gap_length, kinds.begin() + gap_begin);
+            std::move(lengths.begin() + gap_begin + gap_length, lengths.begin() + index + gap_length, lengths.begin() + gap_begin);
+            std::move(begins.begin() + gap_begin + gap_length, begins.begin() + index + gap_length, begins.begin() + gap_begin);
+            std::for_each(begins.begin() + gap_begin, begins.begin() + index, [this](uint32_t& begin) { begin += pending_shift; });
+        }
+
+        gap_begin = index;
+    }
+
+    /* TokenBuffer public impl. */
+
+    TokenBuffer::TokenBuffer()
+    : kinds {}, begins {}, lengths {}, gap_begin {0}, gap_length {0}, pending_shift {0} {}
+
+    void TokenBuffer::reserveFor(size_t source_length, TriviaMode mode)
+    {
+        // Formatted sources average about one token per four bytes once whitespace runs are counted, and trivia is about half of that.
+        size_t estimate = ((mode == TriviaMode::keep) ? source_length / 4 : source_length / 8) + 1;
+
+        kinds.reserve(estimate);
+        begins.reserve(estimate);
+        lengths.reserve(estimate);
+    }
+
+    void TokenBuffer::reserve(size_t token_count)
+    {
+        kinds.reserve(token_count + gap_length);
+        begins.reserve(token_count + gap_length);
+        lengths.reserve(token_count + gap_length);
+    }
+
+    void TokenBuffer::push(const Token& token)
+    {
+        size_t index = size();
+
+        kinds.push_back(static_cast<uint8_t>(token.type));
+        begins.push_back(static_cast<uint32_t>(token.begin) - shiftAt(index));
+        lengths.push_back(static_cast<uint32_t>(token.length));
+    }
+
+    void TokenBuffer::appendShifted(const TokenBuffer& other, size_t first, size_t last, size_t shift)
+    {
+        if (first >= last)
+            return;
+
+        // Appended tokens land past any gap, so they all carry this buffer's pending shift.
+        auto offset = static_cast<uint32_t>(shift) - pending_shift;
+
+        if (other.gap_length != 0 || other.pending_shift != 0)
+        {
+            reserve(size() + (last - first));
+
+            for (size_t other_pos = first; other_pos < last; other_pos++)
+            {
+                kinds.push_back(static_cast<uint8_t>(other.typeAt(other_pos)));
+                begins.push_back(other.beginAt(other_pos) + offset);
+                lengths.push_back(other.lengths[other.slotOf(other_pos)]);
+            }
+
+            return;
+        }
+
+        kinds.insert(kinds.end(), other.kinds.begin() + first, other.kinds.begin() + last);
+        lengths.insert(lengths.end(), other.lengths.begin() + first, other.lengths.begin() + last);
+
+        size_t old_size = begins.size();
+
+        begins.insert(begins.end(), other.begins.begin() + first, other.begins.begin() + last);
+        std::for_each(begins.begin() + old_size, begins.end(), [offset](uint32_t& begin) { begin += offset; });
+    }
+
+    void TokenBuffer::growLast(size_t extra) noexcept
+    {
+        lengths[slotOf(size() - 1)] += static_cast<uint32_t>(extra);
+    }
+
+    void TokenBuffer::splice(size_t first, size_t last, const TokenBuffer& replacement, std::ptrdiff_t shift)
+    {
+        size_t inserted_count = replacement.size();
+
+        // Bring the gap to the removed tokens and swallow them, so only the tokens between the last splice and this one move.
+        moveGap(last);
+        gap_begin = first;
+        gap_length += last - first;
+
+        if (gap_length < inserted_count)
+        {
+            // Growing by a fraction of the buffer keeps repeated growth amortized, like vector's push_back.
+            size_t extra = std::max(inserted_count - gap_length, size() / 8 + 64);
+            size_t gap_end = gap_begin + gap_length;
+
+            kinds.insert(kinds.begin() + gap_end, extra, 0);
+            lengths.insert(lengths.begin() + gap_end, extra, 0);
+            begins.insert(begins.begin() + gap_end, extra, 0);
+            gap_length += extra;
+        }
+
+        for (size_t pos = 0; pos < inserted_count; pos++)
+        {
+            Token token = replacement.at(pos);
+
+            kinds[gap_begin + pos] = static_cast<uint8_t>(token.type);
+            begins[gap_begin + pos] = static_cast<uint32_t>(token.begin);
+            lengths[gap_begin + pos] = static_cast<uint32_t>(token.length);
+        }
+
+        gap_begin += inserted_count;
+        gap_length -= inserted_count;
+
+        // Offsets wrap modulo 2^32, so adding the two's complement of a negative shift moves them back.
+        pending_shift += static_cast<uint32_t>(shift);
+    }
+
+    void TokenBuffer::compact()
+    {
+        moveGap(size());
+
+        kinds.resize(gap_begin);
+        lengths.resize(gap_begin);
+        begins.resize(gap_begin);
+        gap_length = 0;
+        pending_shift = 0;
+    }
+
+    void TokenBuffer::clear() noexcept
+    {
+        kinds.clear();
+        begins.clear();
+        lengths.clear();
+        gap_begin = 0;
+        gap_length = 0;
+        pending_shift = 0;
+    }
+
+    size_t TokenBuffer::size() const noexcept
+    {
+        return kinds.size() - gap_length;
+    }
+
+    bool TokenBuffer::isEmpty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    TokenType TokenBuffer::typeAt(size_t index) const noexcept
+    {
+        return static_cast<TokenType>(kinds[slotOf(index)]);
+    }
+
+    Token TokenBuffer::at(size_t index) const noexcept
+    {
+        size_t slot = slotOf(index);
+
+        return {.begin = begins[slot] + shiftAt(index), .length = lengths[slot], .type = static_cast<TokenType>(kinds[slot])};
+    }
+
+    size_t TokenBuffer::indexAtOrBefore(size_t offset) const noexcept
+    {
+        // Begins are sorted once the pending shift is added, so search by index rather than over the stored values.
+        size_t low = 0;
+        size_t high = size();
+
+        while (low < high)
+        {
+            size_t middle = low + (high - low) / 2;
+
+            if (beginAt(middle) <= offset)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+
+        return (low > 0) ? low - 1 : 0;
+    }
+
+    const uint8_t* TokenBuffer::kindData() const noexcept
+    {
+        return kinds.data();
+    }
+
+    TokenView TokenBuffer::view() const noexcept
+    {
+        return {this, 0, size()};
+    }
+
+    /* TokenView */
+
+    TokenView::TokenView() noexcept
+    : buffer {nullptr}, first {0}, count {0} {}
+
+    TokenView::TokenView(const TokenBuffer* buffer_arg, size_t first_arg, size_t count_arg) noexcept
+    : buffer {buffer_arg}, first {first_arg}, count {count_arg} {}
+
+    size_t TokenView::size() const noexcept
+    {
+        return count;
+    }
+
+    TokenType TokenView::typeAt(size_t index) const noexcept
+    {
+        return buffer->typeAt(first + index);
+    }
+
+    Token TokenView::operator[](size_t index) const noexcept
+    {
+        return buffer->at(first + index);
+    }
+
+    TokenView TokenView::subview(size_t offset, size_t count_arg) const noexcept
+    {
+        size_t sub_first = std::min(offset, count);
+
+        return {buffer, first + sub_first, std::min(count_arg, count - sub_first)};
+    }
+
+    TokenView::Iterator TokenView::begin() const noexcept
+    {
+        return {buffer, first};
+    }
+
+    TokenView::Iterator TokenView::end() const noexcept
+    {
+        return {buffer, first + count};
+    }
+}
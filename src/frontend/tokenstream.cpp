@@ -0,0 +1,91 @@
+/**
+ * @file tokenstream.cpp
+ * @author DrkWithT
+ * @brief Implements the streaming token window.
+ * @date 2024-04-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "frontend/tokenstream.hpp"
+
+namespace tisp::frontend
+{
+    /* TokenStream private impl. */
+
+    void TokenStream::fill(size_t wanted)
+    {
+        while (buffered < wanted)
+        {
+            Token& slot = window[(head + buffered) & mask];
+
+            if (lexed_eof)
+            {
+                // Repeat the final eof instead of lexing past the end.
+                slot = window[(head + buffered - 1) & mask];
+            }
+            else
+            {
+                slot = (trivia_mode == TriviaMode::skip) ? lexer.lexNextSignificant(nullptr) : lexer.lexNext();
+                lexed_eof = slot.type == TokenType::eof;
+            }
+
+            buffered++;
+        }
+    }
+
+    /* TokenStream public impl. */
+
+    TokenStream::TokenStream(std::string_view source_view, size_t lookahead_arg, TriviaMode mode, ast::SymbolTable* symbols)
+    : window {}, lexer {symbols}, head {0}, buffered {0}, mask {0}, consumed {0}, trivia_mode {mode}, lexed_eof {false}
+    {
+        size_t capacity = 1;
+
+        while (capacity < lookahead_arg)
+            capacity <<= 1;
+
+        window.resize(capacity);
+        mask = capacity - 1;
+        lexer.reset(source_view);
+    }
+
+    size_t TokenStream::lookahead() const noexcept
+    {
+        return window.size();
+    }
+
+    const Token& TokenStream::peek(size_t offset)
+    {
+        if (offset >= window.size())
+            offset = window.size() - 1;
+
+        fill(offset + 1);
+
+        return window[(head + offset) & mask];
+    }
+
+    Token TokenStream::next()
+    {
+        Token current = peek();
+
+        if (current.type != TokenType::eof)
+        {
+            head = (head + 1) & mask;
+            buffered--;
+            consumed++;
+        }
+
+        return current;
+    }
+
+    bool TokenStream::isAtEnd()
+    {
+        return peek().type == TokenType::eof;
+    }
+
+    size_t TokenStream::consumedCount() const noexcept
+    {
+        return consumed;
+    }
+}
@@ -9,41 +9,32 @@
  * 
  */
 
-#include <algorithm>
-#include <memory>
+#include <charconv>
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <string_view>
+#include "ast/context.hpp"
+#include "ast/folder.hpp"
+#include "ast/symbols.hpp"
 #include "frontend/token.hpp"
-#include "frontend/lexer.hpp"
+#include "frontend/tokenbuffer.hpp"
+#include "frontend/tokenstream.hpp"
+#include "frontend/source.hpp"
+#include "frontend/lineindex.hpp"
+#include "frontend/parser.hpp"
+#include "backend/compiler.hpp"
+#include "runtime/bytecode.hpp"
+#include "runtime/vm.hpp"
 
 using MyToken = tisp::frontend::Token;
 using MyLexType = tisp::frontend::TokenType;
-using MyLexer = tisp::frontend::Lexer;
+using MyTokenStream = tisp::frontend::TokenStream;
+using MySource = tisp::frontend::SourceBuffer;
+using MyParser = tisp::frontend::Parser;
+using MyCompiler = tisp::backend::Compiler;
+using MyVm = tisp::runtime::Vm;
 
-[[nodiscard]] std::string readFile(const std::string& file_path)
-{
-    std::ifstream reader {file_path.c_str()};
-
-    if (!reader.is_open())
-    {
-        return std::string {""};
-    }
-
-    reader.seekg(0, std::ios::end);
-    size_t file_len = reader.tellg();
-    reader.seekg(0, std::ios::beg);
-
-    std::unique_ptr<char[]> buffer = std::make_unique<char[]>(file_len + 1);
-    std::fill(buffer.get(), buffer.get() + file_len + 1, '\0');
-
-    bool read_ok = reader.read(buffer.get(), file_len).good();
-
-    if (read_ok)
-        return std::string {buffer.get()};
-
-    return std::string {""};
-}
+constexpr const char* usage_text = "usage: ./tipsi [--workers <n>] [--version | --help | --tokens | --bytecode | --fold-stats] <file | ->\n";
 
 std::ostream& operator<<(std::ostream& os, const MyToken& token) noexcept
 {
@@ -56,11 +47,32 @@ int main(int argc, char* argv[])
 {
     if (argc < 2)
     {
-        std::cerr << "usage: ./tipsi [--version | help] <file>\n";
+        std::cerr << usage_text;
         return 1;
     }
 
+    size_t worker_count = 0;
+
+    // --workers sets the thread count of the parallel builtins, where 0 means one per hardware thread.
+    if (std::string_view {argv[1]} == "--workers")
+    {
+        std::string_view count_text = (argc > 3) ? argv[2] : "";
+        auto [count_end, count_error] = std::from_chars(count_text.data(), count_text.data() + count_text.size(), worker_count);
+
+        if (count_text.empty() || count_error != std::errc {} || count_end != count_text.data() + count_text.size())
+        {
+            std::cerr << usage_text;
+            return 1;
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
     std::string arg {argv[1]};
+    bool dump_tokens = arg == "--tokens";
+    bool dump_bytecode = arg == "--bytecode";
+    bool dump_fold_stats = arg == "--fold-stats";
 
     if (arg == "--version")
     {
@@ -69,17 +81,110 @@ int main(int argc, char* argv[])
     }
     else if (arg == "--help")
     {
-        std::cout << "usage: ./tipsi [--version | help] <file>\n";
+        std::cout << usage_text;
         return 0;
     }
+    else if (dump_tokens || dump_bytecode || dump_fold_stats)
+    {
+        if (argc < 3)
+        {
+            std::cerr << usage_text;
+            return 1;
+        }
+
+        arg = argv[2];
+    }
+
+    MySource source = MySource::fromPath(arg);
+
+    if (!source.isLoaded())
+    {
+        std::cerr << "tipsi: could not read " << arg << '\n';
+        return 1;
+    }
 
-    std::string blob = readFile(arg);
+    if (source.view().length() >= tisp::frontend::TokenBuffer::max_source_length)
+    {
+        std::cerr << "tipsi: " << arg << " is too large to lex, the limit is " << tisp::frontend::TokenBuffer::max_source_length - 1 << " bytes\n";
+        return 1;
+    }
+
+    if (dump_tokens)
+    {
+        MyTokenStream tokens {source.view()};
+        MyToken tk;
+
+        do
+        {
+            tk = tokens.next();
+            std::cout << tk;
+        } while (tk.type != MyLexType::eof);
 
-    MyLexer lexer {};
-    auto tokens = lexer.tokenizeSource(blob);
+        return 0;
+    }
+
+    tisp::ast::SymbolTable symbols {};
+    tisp::ast::AstContext context {};
+    MyParser parser {source.view(), context, symbols};
+    tisp::ast::StmtList module = parser.parseModule();
+
+    if (!parser.getErrors().empty())
+    {
+        tisp::frontend::LineIndex lines {source.view()};
+
+        for (const auto& error : parser.getErrors())
+        {
+            auto [line, column] = lines.locate(error.offset);
+
+            std::cerr << arg << ':' << line << ':' << column << ": error: " << error.message << '\n';
+        }
+
+        return 1;
+    }
+
+    tisp::ast::ConstantFolder folder {context};
+    size_t parsed_nodes = context.nodeCount();
+
+    module = folder.foldModule(module);
+
+    if (dump_fold_stats)
+    {
+        const auto& stats = folder.getStats();
+
+        std::cout << "folded expressions: " << stats.folded_exprs << "\npruned cases: " << stats.pruned_cases << "\nremoved loops: " << stats.removed_loops
+                  << "\nremoved nodes: " << stats.removed_nodes << " of " << parsed_nodes << '\n';
+        return 0;
+    }
+
+    MyCompiler compiler {symbols};
+    tisp::runtime::Program program = compiler.compile(module);
+
+    if (!compiler.getErrors().empty())
+    {
+        for (const auto& error : compiler.getErrors())
+            std::cerr << arg << ": error: " << error.message << '\n';
+
+        return 1;
+    }
+
+    if (dump_bytecode)
+    {
+        tisp::runtime::disassemble(std::cout, program);
+        return 0;
+    }
+
+    MyVm vm {std::cout};
+
+    vm.setWorkerCount(worker_count);
+
+    if (vm.run(program) != tisp::runtime::ExecStatus::ok)
+    {
+        std::cout.flush();
+        std::cerr << "tipsi: runtime error " << vm.getError() << '\n';
+        return 1;
+    }
 
-    for (const auto& tk : tokens)
-        std::cout << tk;
+    tisp::runtime::Value result = vm.getResult();
 
-    // todo: add parsing and then VM runner.
+    return result.isInteger() ? static_cast<int>(result.asInteger()) : 0;
 }
@@ -0,0 +1,608 @@
+/**
+ * @file builtins.cpp
+ * @author DrkWithT
+ * @brief Implements native library functions.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "runtime/vm.hpp"
+#include "runtime/seqkernels.hpp"
+#include "runtime/builtins.hpp"
+
+namespace tisp::runtime
+{
+    /* io */
+
+    static bool builtinPrint(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::ostream& out = vm.getOutput();
+
+        printValue(out, args[0]);
+        out << '\n';
+        result = Value {};
+
+        return true;
+    }
+
+    /* seq */
+
+    /// @brief Views the items of a Seq of Item. An empty Seq has no unboxed storage, so it matches every Item.
+    template <typename Item>
+    static bool itemsOf(Value arg, std::span<const Item>& items) noexcept
+    {
+        if (!arg.isSeq())
+            return false;
+
+        const SeqObject& seq = *arg.asSeq();
+
+        if (seq.size() == 0)
+        {
+            items = {};
+            return true;
+        }
+
+        if (const auto* storage = std::get_if<std::vector<Item>>(&seq.items); storage != nullptr)
+        {
+            items = *storage;
+            return true;
+        }
+
+        return false;
+    }
+
+    /// @brief Views the right operand of an elementwise builtin: a Seq of Item with count items, or one Item kept in scratch for all of them.
+    template <typename Item>
+    static bool operandOf(Value arg, size_t count, Item& scratch, std::span<const Item>& items) noexcept
+    {
+        if (arg.isSeq())
+            return itemsOf(arg, items) && items.size() == count;
+
+        if constexpr (std::is_same_v<Item, int64_t>)
+        {
+            if (!arg.isInteger())
+                return false;
+
+            scratch = arg.asInteger();
+        }
+        else
+        {
+            if (!arg.isDouble())
+                return false;
+
+            scratch = arg.asDouble();
+        }
+
+        items = {&scratch, 1};
+
+        return true;
+    }
+
+    static bool numericSeqError(Vm& vm)
+    {
+        vm.reportError("argument must be a Seq of Integer or Double");
+
+        return false;
+    }
+
+    static bool operandError(Vm& vm)
+    {
+        vm.reportError("operands must be a Seq of Integer or Double and a Seq of the same items and length, or one such item");
+
+        return false;
+    }
+
+    static bool builtinSum(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> integers;
+        std::span<const double> doubles;
+
+        if (itemsOf(args[0], integers))
+            result = Value::fromInteger(sumIntegers(integers));
+        else if (itemsOf(args[0], doubles))
+            result = Value::fromDouble(sumDoubles(doubles));
+        else
+            return numericSeqError(vm);
+
+        return true;
+    }
+
+    template <bool IsMax>
+    static bool builtinExtreme(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> integers;
+        std::span<const double> doubles;
+
+        if (args[0].isSeq() && args[0].asSeq()->size() == 0)
+        {
+            vm.reportError("argument must not be an empty Seq");
+            return false;
+        }
+
+        if (itemsOf(args[0], integers))
+            result = Value::fromInteger(IsMax ? maxIntegers(integers) : minIntegers(integers));
+        else if (itemsOf(args[0], doubles))
+            result = Value::fromDouble(IsMax ? maxDoubles(doubles) : minDoubles(doubles));
+        else
+            return numericSeqError(vm);
+
+        return true;
+    }
+
+    static bool builtinDot(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> lhs_integers;
+        std::span<const int64_t> rhs_integers;
+        std::span<const double> lhs_doubles;
+        std::span<const double> rhs_doubles;
+
+        if (itemsOf(args[0], lhs_integers) && itemsOf(args[1], rhs_integers) && lhs_integers.size() == rhs_integers.size())
+            result = Value::fromInteger(dotIntegers(lhs_integers, rhs_integers));
+        else if (itemsOf(args[0], lhs_doubles) && itemsOf(args[1], rhs_doubles) && lhs_doubles.size() == rhs_doubles.size())
+            result = Value::fromDouble(dotDoubles(lhs_doubles, rhs_doubles));
+        else
+        {
+            vm.reportError("operands must be Seqs of Integer or Double with the same items and length");
+            return false;
+        }
+
+        return true;
+    }
+
+    template <SeqArith Op>
+    static bool builtinMap(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> lhs_integers;
+        std::span<const int64_t> rhs_integers;
+        std::span<const double> lhs_doubles;
+        std::span<const double> rhs_doubles;
+        int64_t integer_item = 0;
+        double double_item = 0.0;
+
+        if (itemsOf(args[0], lhs_integers) && operandOf(args[1], lhs_integers.size(), integer_item, rhs_integers))
+        {
+            std::vector<int64_t> items(lhs_integers.size());
+
+            mapIntegers(Op, lhs_integers, rhs_integers, items);
+            result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+        }
+        else if (itemsOf(args[0], lhs_doubles) && operandOf(args[1], lhs_doubles.size(), double_item, rhs_doubles))
+        {
+            std::vector<double> items(lhs_doubles.size());
+
+            mapDoubles(Op, lhs_doubles, rhs_doubles, items);
+            result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+        }
+        else
+            return operandError(vm);
+
+        return true;
+    }
+
+    static Value makeMask(Vm& vm, const std::vector<uint8_t>& hits)
+    {
+        return Value::fromObject(vm.getHeap().makeSeq(std::vector<bool>(hits.begin(), hits.end())));
+    }
+
+    template <SeqCompare Op>
+    static bool builtinCompare(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> lhs_integers;
+        std::span<const int64_t> rhs_integers;
+        std::span<const double> lhs_doubles;
+        std::span<const double> rhs_doubles;
+        int64_t integer_item = 0;
+        double double_item = 0.0;
+
+        if (itemsOf(args[0], lhs_integers) && operandOf(args[1], lhs_integers.size(), integer_item, rhs_integers))
+        {
+            std::vector<uint8_t> hits(lhs_integers.size());
+
+            compareIntegers(Op, lhs_integers, rhs_integers, hits);
+            result = makeMask(vm, hits);
+        }
+        else if (itemsOf(args[0], lhs_doubles) && operandOf(args[1], lhs_doubles.size(), double_item, rhs_doubles))
+        {
+            std::vector<uint8_t> hits(lhs_doubles.size());
+
+            compareDoubles(Op, lhs_doubles, rhs_doubles, hits);
+            result = makeMask(vm, hits);
+        }
+        else
+            return operandError(vm);
+
+        return true;
+    }
+
+    static bool builtinFilter(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        std::span<const int64_t> integers;
+        std::span<const double> doubles;
+        const bool is_integers = itemsOf(args[0], integers);
+        const SeqObject* mask = args[1].isSeq() ? args[1].asSeq() : nullptr;
+
+        if ((!is_integers && !itemsOf(args[0], doubles)) || mask == nullptr || mask->size() != args[0].asSeq()->size() || (mask->size() != 0 && mask->getKind() != SeqKind::booleans))
+        {
+            vm.reportError("operands must be a Seq of Integer or Double and a Seq of Boolean with the same length");
+            return false;
+        }
+
+        std::vector<uint8_t> keep(mask->size());
+
+        for (size_t item_pos = 0; item_pos < keep.size(); item_pos++)
+            keep[item_pos] = mask->at(item_pos).asBool() ? 1 : 0;
+
+        if (is_integers)
+        {
+            std::vector<int64_t> items(integers.size());
+
+            items.resize(filterIntegers(integers, keep, items));
+            result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+        }
+        else
+        {
+            std::vector<double> items(doubles.size());
+
+            items.resize(filterDoubles(doubles, keep, items));
+            result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+        }
+
+        return true;
+    }
+
+    static bool builtinRange(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        if (!args[0].isInteger() || args[0].asInteger() < 0)
+        {
+            vm.reportError("argument must be an Integer of at least 0");
+            return false;
+        }
+
+        std::vector<int64_t> items(static_cast<size_t>(args[0].asInteger()));
+
+        for (size_t item_pos = 0; item_pos < items.size(); item_pos++)
+            items[item_pos] = static_cast<int64_t>(item_pos);
+
+        result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+
+        return true;
+    }
+
+    /* parallel */
+
+    /// @brief Work is split into this many chunks per worker, so a worker that finishes early can steal from a slower one.
+    static constexpr size_t chunks_per_worker = 4;
+
+    /// @brief Returns the defun a function value names when it takes arity arguments and is pure, else reports why not.
+    static const FunctionProto* pureFunctionOf(Vm& vm, Value arg, uint16_t arity)
+    {
+        if (!arg.isFunction())
+        {
+            vm.reportError("argument 1 must be the name of a defun");
+            return nullptr;
+        }
+
+        const FunctionProto& function = vm.getProgram().functions[arg.asFunction()];
+
+        if (function.arity != arity)
+        {
+            vm.reportError("'" + function.name + "' must take " + std::to_string(arity) + " argument(s)");
+            return nullptr;
+        }
+
+        if (!function.is_pure)
+        {
+            vm.reportError("'" + function.name + "' must be pure, but it assigns a global or calls a builtin with effects");
+            return nullptr;
+        }
+
+        return &function;
+    }
+
+    /// @brief Calls function on vm after the parameter checks compiled calls do at their call sites. On failure the error is left on vm.
+    static bool callFunction(Vm& vm, uint16_t function_id, std::span<const Value> args, Value& returned)
+    {
+        const FunctionProto& function = vm.getProgram().functions[function_id];
+
+        for (size_t arg_pos = 0; arg_pos < args.size(); arg_pos++)
+        {
+            const auto& expected = function.param_tags[arg_pos];
+
+            if (expected && *expected != args[arg_pos].getTag())
+            {
+                vm.reportError("in " + function.name + ": expected " + std::string {valueTagName(*expected)} + " but got " + std::string {valueTagName(args[arg_pos].getTag())});
+                return false;
+            }
+        }
+
+        return vm.call(function_id, args, returned) == ExecStatus::ok;
+    }
+
+    /// @brief How many chunks to split count items into: 1 runs them serially on the calling VM.
+    static size_t planChunks(Vm& vm, size_t count)
+    {
+        if (count < min_parallel_seq_length || vm.isWorker())
+            return 1;
+
+        size_t worker_count = vm.startWorkers().workerCount();
+
+        return (worker_count < 2) ? 1 : std::min(count, worker_count * chunks_per_worker);
+    }
+
+    /**
+     * @brief Runs body(context, task) for every task below task_count, where context is the VM to call Tisp on. A single task runs on vm itself, and more run on the pool's worker VMs.
+     * @return false after reporting the first failed task's error on vm. Tasks not yet started then are skipped.
+     */
+    template <typename Body>
+    static bool runTasks(Vm& vm, size_t task_count, Body body)
+    {
+        if (task_count == 1)
+            return body(vm, 0);
+
+        ThreadPool& pool = vm.startWorkers();
+        std::atomic<bool> failed {false};
+        std::mutex error_lock;
+        std::string first_error;
+        std::vector<ThreadPool::Task> tasks;
+
+        tasks.reserve(task_count);
+
+        for (size_t task = 0; task < task_count; task++)
+        {
+            tasks.push_back([&, task](size_t worker) {
+                Vm& context = vm.getWorker(worker);
+
+                if (failed.load(std::memory_order_relaxed) || body(context, task))
+                    return;
+
+                std::lock_guard error_guard {error_lock};
+
+                if (!failed.exchange(true))
+                    first_error = context.getError();
+            });
+        }
+
+        pool.runAll(std::move(tasks));
+
+        // What the tasks returned may live in worker heaps, so the calling VM takes those objects over and collects the ones nothing holds.
+        for (size_t worker = 0; worker < pool.workerCount(); worker++)
+            vm.getHeap().adopt(vm.getWorker(worker).getHeap());
+
+        if (failed.load())
+        {
+            vm.reportError(std::move(first_error));
+            return false;
+        }
+
+        return true;
+    }
+
+    static size_t chunkBound(size_t count, size_t chunk, size_t chunk_count) noexcept
+    {
+        return count * chunk / chunk_count;
+    }
+
+    static bool builtinParallelMap(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        if (pureFunctionOf(vm, args[0], 1) == nullptr)
+            return false;
+
+        if (!args[1].isSeq())
+        {
+            vm.reportError("argument 2 must be a Seq");
+            return false;
+        }
+
+        const uint16_t function_id = args[0].asFunction();
+        const SeqObject& seq = *args[1].asSeq();
+        const size_t chunk_count = planChunks(vm, seq.size());
+        std::vector<Value> items(seq.size());
+
+        bool ok = runTasks(vm, chunk_count, [&](Vm& context, size_t chunk) {
+            for (size_t item_pos = chunkBound(seq.size(), chunk, chunk_count); item_pos < chunkBound(seq.size(), chunk + 1, chunk_count); item_pos++)
+            {
+                Value item = seq.at(item_pos);
+
+                if (!callFunction(context, function_id, {&item, 1}, items[item_pos]))
+                    return false;
+            }
+
+            return true;
+        });
+
+        if (!ok)
+            return false;
+
+        result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+
+        return true;
+    }
+
+    /// @note Chunks fold separately and their results fold in order, so the function must be associative. Serially this is a plain left fold from the initial value.
+    static bool builtinParallelReduce(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        if (pureFunctionOf(vm, args[0], 2) == nullptr)
+            return false;
+
+        if (!args[1].isSeq())
+        {
+            vm.reportError("argument 2 must be a Seq");
+            return false;
+        }
+
+        const uint16_t function_id = args[0].asFunction();
+        const SeqObject& seq = *args[1].asSeq();
+        const size_t chunk_count = planChunks(vm, seq.size());
+        std::vector<Value> partials(chunk_count);
+
+        // Every chunk but the first starts from its own first item, which keeps init out of all but one fold.
+        bool ok = runTasks(vm, chunk_count, [&](Vm& context, size_t chunk) {
+            size_t item_pos = chunkBound(seq.size(), chunk, chunk_count);
+            Value acc = (chunk == 0) ? args[2] : seq.at(item_pos++);
+
+            for (; item_pos < chunkBound(seq.size(), chunk + 1, chunk_count); item_pos++)
+            {
+                Value pair[2] {acc, seq.at(item_pos)};
+
+                if (!callFunction(context, function_id, pair, acc))
+                    return false;
+            }
+
+            partials[chunk] = acc;
+
+            return true;
+        });
+
+        if (!ok)
+            return false;
+
+        Value acc = partials[0];
+
+        for (size_t chunk = 1; chunk < chunk_count; chunk++)
+        {
+            Value pair[2] {acc, partials[chunk]};
+
+            if (!callFunction(vm, function_id, pair, acc))
+                return false;
+        }
+
+        result = acc;
+
+        return true;
+    }
+
+    /// @brief Wraps a Tisp comparator for the standard algorithms. After the first error it answers false, which any sort or merge survives, and failed stays set.
+    static auto makeComparator(Vm& context, uint16_t function_id, bool& failed)
+    {
+        return [&context, function_id, &failed](Value lhs, Value rhs) {
+            Value pair[2] {lhs, rhs};
+            Value before {};
+
+            if (failed)
+                return false;
+
+            if (!callFunction(context, function_id, pair, before))
+                failed = true;
+            else if (!before.isBool())
+            {
+                context.reportError("'" + context.getProgram().functions[function_id].name + "' must return a Boolean but returned " + std::string {valueTagName(before.getTag())});
+                failed = true;
+            }
+
+            return !failed && before.asBool();
+        };
+    }
+
+    /// @note Chunks are stable sorted on their own and then merged pairwise, every round's merges running in parallel, so the sort is stable.
+    static bool builtinParallelSort(Vm& vm, Value* args, [[maybe_unused]] uint8_t arg_count, Value& result)
+    {
+        if (pureFunctionOf(vm, args[0], 2) == nullptr)
+            return false;
+
+        if (!args[1].isSeq())
+        {
+            vm.reportError("argument 2 must be a Seq");
+            return false;
+        }
+
+        const uint16_t function_id = args[0].asFunction();
+        const SeqObject& seq = *args[1].asSeq();
+        const size_t chunk_count = planChunks(vm, seq.size());
+        std::vector<Value> items(seq.size());
+        std::vector<size_t> runs(chunk_count + 1);
+
+        for (size_t item_pos = 0; item_pos < items.size(); item_pos++)
+            items[item_pos] = seq.at(item_pos);
+
+        for (size_t chunk = 0; chunk <= chunk_count; chunk++)
+            runs[chunk] = chunkBound(items.size(), chunk, chunk_count);
+
+        bool ok = runTasks(vm, chunk_count, [&](Vm& context, size_t chunk) {
+            bool failed = false;
+
+            std::stable_sort(items.begin() + runs[chunk], items.begin() + runs[chunk + 1], makeComparator(context, function_id, failed));
+
+            return !failed;
+        });
+
+        std::vector<Value> merged(items.size());
+
+        while (ok && runs.size() > 2)
+        {
+            const size_t run_count = runs.size() - 1;
+
+            ok = runTasks(vm, (run_count + 1) / 2, [&](Vm& context, size_t pair) {
+                auto first = items.begin() + runs[pair * 2];
+                auto middle = items.begin() + runs[std::min(pair * 2 + 1, run_count)];
+                auto last = items.begin() + runs[std::min(pair * 2 + 2, run_count)];
+                bool failed = false;
+
+                std::merge(first, middle, middle, last, merged.begin() + runs[pair * 2], makeComparator(context, function_id, failed));
+
+                return !failed;
+            });
+
+            std::vector<size_t> merged_runs;
+
+            for (size_t run = 0; run < run_count; run += 2)
+                merged_runs.push_back(runs[run]);
+
+            merged_runs.push_back(runs.back());
+            runs = std::move(merged_runs);
+            items.swap(merged);
+        }
+
+        if (!ok)
+            return false;
+
+        result = Value::fromObject(vm.getHeap().makeSeq(std::move(items)));
+
+        return true;
+    }
+
+    static constexpr BuiltinEntry builtins[] {
+        {.module = "io", .name = "print", .arity = 1, .call = builtinPrint, .is_pure = false},
+        {.module = "seq", .name = "sum", .arity = 1, .call = builtinSum, .is_pure = true},
+        {.module = "seq", .name = "min", .arity = 1, .call = builtinExtreme<false>, .is_pure = true},
+        {.module = "seq", .name = "max", .arity = 1, .call = builtinExtreme<true>, .is_pure = true},
+        {.module = "seq", .name = "dot", .arity = 2, .call = builtinDot, .is_pure = true},
+        {.module = "seq", .name = "add", .arity = 2, .call = builtinMap<SeqArith::add>, .is_pure = true},
+        {.module = "seq", .name = "sub", .arity = 2, .call = builtinMap<SeqArith::sub>, .is_pure = true},
+        {.module = "seq", .name = "mul", .arity = 2, .call = builtinMap<SeqArith::mul>, .is_pure = true},
+        {.module = "seq", .name = "less", .arity = 2, .call = builtinCompare<SeqCompare::less>, .is_pure = true},
+        {.module = "seq", .name = "greater", .arity = 2, .call = builtinCompare<SeqCompare::greater>, .is_pure = true},
+        {.module = "seq", .name = "equal", .arity = 2, .call = builtinCompare<SeqCompare::equal>, .is_pure = true},
+        {.module = "seq", .name = "filter", .arity = 2, .call = builtinFilter, .is_pure = true},
+        {.module = "seq", .name = "range", .arity = 1, .call = builtinRange, .is_pure = true},
+        {.module = "parallel", .name = "parallelMap", .arity = 2, .call = builtinParallelMap, .is_pure = true},
+        {.module = "parallel", .name = "parallelReduce", .arity = 3, .call = builtinParallelReduce, .is_pure = true},
+        {.module = "parallel", .name = "parallelSort", .arity = 2, .call = builtinParallelSort, .is_pure = true}
+    };
+
+    static_assert(std::size(builtins) < no_builtin);
+
+    std::span<const BuiltinEntry> builtinTable() noexcept
+    {
+        return builtins;
+    }
+
+    uint8_t findBuiltin(std::string_view name) noexcept
+    {
+        for (size_t entry_pos = 0; entry_pos < std::size(builtins); entry_pos++)
+        {
+            if (builtins[entry_pos].name == name)
+                return static_cast<uint8_t>(entry_pos);
+        }
+
+        return no_builtin;
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file bytecode.cpp
+ * @author DrkWithT
+ * @brief Implements bytecode listing helpers.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+#include "runtime/bytecode.hpp"
+
+namespace tisp::runtime
+{
+    static constexpr std::string_view opcode_names[] {
+        "move",
+        "load_const",
+        "load_int",
+        "load_nil",
+        "load_bool",
+        "get_global",
+        "set_global",
+        "add",
+        "sub",
+        "mul",
+        "div",
+        "neg",
+        "eq",
+        "ne",
+        "lt",
+        "le",
+        "gt",
+        "ge",
+        "add_i64",
+        "sub_i64",
+        "mul_i64",
+        "div_i64",
+        "neg_i64",
+        "add_f64",
+        "sub_f64",
+        "mul_f64",
+        "div_f64",
+        "neg_f64",
+        "eq_i64",
+        "ne_i64",
+        "lt_i64",
+        "le_i64",
+        "eq_f64",
+        "ne_f64",
+        "lt_f64",
+        "le_f64",
+        "concat_str",
+        "check_type",
+        "jump",
+        "jump_if_false",
+        "jump_if_true",
+        "switch_int",
+        "switch_str",
+        "call",
+        "tail_call",
+        "call_builtin",
+        "length",
+        "index",
+        "index_i64",
+        "index_f64",
+        "index_bool",
+        "ret",
+        "ret_nil"
+    };
+
+    static_assert(std::size(opcode_names) == static_cast<size_t>(Opcode::last) + 1, "every opcode needs a name");
+
+    std::string_view opcodeName(Opcode op) noexcept
+    {
+        auto op_pos = static_cast<size_t>(op);
+
+        return (op_pos < std::size(opcode_names)) ? opcode_names[op_pos] : "unknown";
+    }
+
+    void disassemble(std::ostream& out, const Program& program)
+    {
+        for (const auto& function : program.functions)
+        {
+            out << "function " << function.name << " (arity " << function.arity << ", registers " << function.register_count << ")\n";
+
+            for (size_t code_pos = 0; code_pos < function.code.size(); code_pos++)
+            {
+                Instruction code = function.code[code_pos];
+                Opcode op = opOf(code);
+
+                out << std::setw(6) << code_pos << "  " << std::left << std::setw(14) << opcodeName(op) << std::right;
+
+                switch (op)
+                {
+                    case Opcode::load_const:
+                    case Opcode::get_global:
+                    case Opcode::set_global:
+                    case Opcode::call:
+                    case Opcode::tail_call:
+                        out << static_cast<int>(argA(code)) << ' ' << argBx(code);
+                        break;
+                    case Opcode::load_int:
+                    case Opcode::jump_if_false:
+                    case Opcode::jump_if_true:
+                        out << static_cast<int>(argA(code)) << ' ' << argSBx(code);
+                        break;
+                    case Opcode::jump:
+                        out << argSAx(code);
+                        break;
+                    case Opcode::switch_int:
+                    {
+                        const IntSwitch& table = function.int_switches[argBx(code)];
+
+                        out << static_cast<int>(argA(code)) << ' ' << argBx(code) << "  keys " << table.low << ".." << table.low + static_cast<int64_t>(table.targets.size()) - 1;
+                        break;
+                    }
+                    case Opcode::switch_str:
+                        out << static_cast<int>(argA(code)) << ' ' << argBx(code) << "  keys " << function.string_switches[argBx(code)].targets.size();
+                        break;
+                    case Opcode::ret_nil:
+                        break;
+                    default:
+                        out << static_cast<int>(argA(code)) << ' ' << static_cast<int>(argB(code)) << ' ' << static_cast<int>(argC(code));
+                        break;
+                }
+
+                out << '\n';
+            }
+        }
+    }
+}
@@ -0,0 +1,677 @@
+/**
+ * @file seqkernels.cpp
+ * @author DrkWithT
+ * @brief Implements vectorized bulk kernels for unboxed Seq items.
+ * @date 2024-05-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "runtime/seqkernels.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TISP_SEQ_X86 1
+#include <immintrin.h>
+#else
+#define TISP_SEQ_X86 0
+#endif
+
+namespace tisp::runtime
+{
+    static constexpr uint64_t integer_payload = 0x0000'ffff'ffff'ffff;
+    static constexpr uint64_t integer_sign = 0x0000'8000'0000'0000;
+
+    /// @brief Integers add and multiply as unsigned words so overflow wraps instead of being undefined.
+    template <typename T>
+    using Accum = std::conditional_t<std::is_integral_v<T>, uint64_t, T>;
+
+    /// @brief Sign extends the low 48 bits, the width a Value keeps an Integer at.
+    static constexpr int64_t wrapInteger(uint64_t bits) noexcept
+    {
+        return static_cast<int64_t>(((bits & integer_payload) ^ integer_sign) - integer_sign);
+    }
+
+    template <typename T>
+    static constexpr T toItem(Accum<T> value) noexcept
+    {
+        if constexpr (std::is_integral_v<T>)
+            return wrapInteger(value);
+        else
+            return value;
+    }
+
+    template <typename T, bool IsMax>
+    static constexpr T extremeSentinel() noexcept
+    {
+        if constexpr (std::is_integral_v<T>)
+            return IsMax ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+        else
+            return IsMax ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+    }
+
+    /* Scalar kernels */
+
+    // Each kernel continues from pos, so the vector kernels finish their tails with them.
+
+    template <typename T>
+    static T sumTail(Accum<T> total, const T* items, size_t pos, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+            total += static_cast<Accum<T>>(items[pos]);
+
+        return toItem<T>(total);
+    }
+
+    template <typename T>
+    static T sumScalar(const T* items, size_t count) noexcept
+    {
+        Accum<T> lanes[4] {};
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            for (size_t lane = 0; lane < 4; lane++)
+                lanes[lane] += static_cast<Accum<T>>(items[pos + lane]);
+        }
+
+        return sumTail<T>((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]), items, pos, count);
+    }
+
+    template <typename T>
+    static T dotTail(Accum<T> total, const T* lhs, const T* rhs, size_t pos, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+            total += static_cast<Accum<T>>(lhs[pos]) * static_cast<Accum<T>>(rhs[pos]);
+
+        return toItem<T>(total);
+    }
+
+    template <typename T>
+    static T dotScalar(const T* lhs, const T* rhs, size_t count) noexcept
+    {
+        Accum<T> lanes[4] {};
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            for (size_t lane = 0; lane < 4; lane++)
+                lanes[lane] += static_cast<Accum<T>>(lhs[pos + lane]) * static_cast<Accum<T>>(rhs[pos + lane]);
+        }
+
+        return dotTail<T>((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]), lhs, rhs, pos, count);
+    }
+
+    /// @brief Keeps best unless item beats it. A NaN item never does.
+    template <typename T, bool IsMax>
+    static constexpr T pickExtreme(T item, T best) noexcept
+    {
+        if constexpr (IsMax)
+            return (item > best) ? item : best;
+        else
+            return (item < best) ? item : best;
+    }
+
+    template <typename T, bool IsMax>
+    static T extremeScalar(T best, const T* items, size_t pos, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+            best = pickExtreme<T, IsMax>(items[pos], best);
+
+        return best;
+    }
+
+    template <typename T, SeqArith Op>
+    static constexpr T applyArith(T lhs, T rhs) noexcept
+    {
+        const auto left = static_cast<Accum<T>>(lhs);
+        const auto right = static_cast<Accum<T>>(rhs);
+
+        if constexpr (Op == SeqArith::add)
+            return toItem<T>(left + right);
+        else if constexpr (Op == SeqArith::sub)
+            return toItem<T>(left - right);
+        else
+            return toItem<T>(left * right);
+    }
+
+    template <typename T, SeqCompare Op>
+    static constexpr bool applyCompare(T lhs, T rhs) noexcept
+    {
+        if constexpr (Op == SeqCompare::less)
+            return lhs < rhs;
+        else if constexpr (Op == SeqCompare::greater)
+            return lhs > rhs;
+        else
+            return lhs == rhs;
+    }
+
+    /// @note rhs_step is 0 when rhs holds one item for every lhs item, else 1.
+    template <typename T, SeqArith Op>
+    static void mapScalar(const T* lhs, const T* rhs, size_t rhs_step, T* out, size_t pos, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+            out[pos] = applyArith<T, Op>(lhs[pos], rhs[pos * rhs_step]);
+    }
+
+    template <typename T, SeqCompare Op>
+    static void compareScalar(const T* lhs, const T* rhs, size_t rhs_step, uint8_t* out, size_t pos, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+            out[pos] = applyCompare<T, Op>(lhs[pos], rhs[pos * rhs_step]) ? 1 : 0;
+    }
+
+    /// @brief Branchless compaction: every item is stored at the next free slot, which only advances past kept ones.
+    template <typename T>
+    static size_t filterScalar(const T* items, const uint8_t* keep, T* out, size_t pos, size_t kept, size_t count) noexcept
+    {
+        for (; pos < count; pos++)
+        {
+            out[kept] = items[pos];
+            kept += keep[pos];
+        }
+
+        return kept;
+    }
+
+#if TISP_SEQ_X86
+
+    /* Vector kernels: written once with GCC vector types and inlined into the SSE2 and AVX2 entry points below, which compile them for 2 or 4 items per register. */
+
+    template <typename T>
+    using Quad [[gnu::vector_size(sizeof(T) * 4)]] = T;
+
+    template <typename T>
+    [[gnu::always_inline]] inline T sumVector(const T* items, size_t count) noexcept
+    {
+        Quad<Accum<T>> lanes {};
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            Quad<Accum<T>> chunk;
+
+            std::memcpy(&chunk, items + pos, sizeof(chunk));
+            lanes += chunk;
+        }
+
+        return sumTail<T>((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]), items, pos, count);
+    }
+
+    template <typename T>
+    [[gnu::always_inline]] inline T dotVector(const T* lhs, const T* rhs, size_t count) noexcept
+    {
+        Quad<Accum<T>> lanes {};
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            Quad<Accum<T>> left;
+            Quad<Accum<T>> right;
+
+            std::memcpy(&left, lhs + pos, sizeof(left));
+            std::memcpy(&right, rhs + pos, sizeof(right));
+            lanes += left * right;
+        }
+
+        return dotTail<T>((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]), lhs, rhs, pos, count);
+    }
+
+    template <typename T, bool IsMax>
+    [[gnu::always_inline]] inline T extremeVector(const T* items, size_t count) noexcept
+    {
+        Quad<T> best = Quad<T> {} + extremeSentinel<T, IsMax>();
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            Quad<T> chunk;
+
+            std::memcpy(&chunk, items + pos, sizeof(chunk));
+
+            if constexpr (IsMax)
+                best = (chunk > best) ? chunk : best;
+            else
+                best = (chunk < best) ? chunk : best;
+        }
+
+        T result = best[0];
+
+        for (size_t lane = 1; lane < 4; lane++)
+            result = pickExtreme<T, IsMax>(best[lane], result);
+
+        return extremeScalar<T, IsMax>(result, items, pos, count);
+    }
+
+    template <typename T, SeqArith Op, bool Broadcast>
+    [[gnu::always_inline]] inline void mapVector(const T* lhs, const T* rhs, T* out, size_t count) noexcept
+    {
+        Quad<Accum<T>> right = Quad<Accum<T>> {} + static_cast<Accum<T>>(rhs[0]);
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            Quad<Accum<T>> left;
+            Quad<Accum<T>> result;
+
+            std::memcpy(&left, lhs + pos, sizeof(left));
+
+            if constexpr (!Broadcast)
+                std::memcpy(&right, rhs + pos, sizeof(right));
+
+            if constexpr (Op == SeqArith::add)
+                result = left + right;
+            else if constexpr (Op == SeqArith::sub)
+                result = left - right;
+            else
+                result = left * right;
+
+            if constexpr (std::is_integral_v<T>)
+                result = ((result & integer_payload) ^ integer_sign) - integer_sign;
+
+            std::memcpy(out + pos, &result, sizeof(result));
+        }
+
+        mapScalar<T, Op>(lhs, rhs, Broadcast ? 0 : 1, out, pos, count);
+    }
+
+    template <typename T, SeqCompare Op, bool Broadcast>
+    [[gnu::always_inline]] inline void compareVector(const T* lhs, const T* rhs, uint8_t* out, size_t count) noexcept
+    {
+        Quad<T> right = Quad<T> {} + rhs[0];
+        size_t pos = 0;
+
+        for (; pos + 4 <= count; pos += 4)
+        {
+            Quad<T> left;
+
+            std::memcpy(&left, lhs + pos, sizeof(left));
+
+            if constexpr (!Broadcast)
+                std::memcpy(&right, rhs + pos, sizeof(right));
+
+            Quad<int64_t> hits;
+
+            if constexpr (Op == SeqCompare::less)
+                hits = left < right;
+            else if constexpr (Op == SeqCompare::greater)
+                hits = left > right;
+            else
+                hits = left == right;
+
+            for (size_t lane = 0; lane < 4; lane++)
+                out[pos + lane] = static_cast<uint8_t>(hits[lane] & 1);
+        }
+
+        compareScalar<T, Op>(lhs, rhs, Broadcast ? 0 : 1, out, pos, count);
+    }
+
+    /* SSE2 kernels: always present on x86-64. */
+
+    template <typename T>
+    static T sumSse2(const T* items, size_t count) noexcept
+    {
+        return sumVector(items, count);
+    }
+
+    template <typename T>
+    static T dotSse2(const T* lhs, const T* rhs, size_t count) noexcept
+    {
+        return dotVector(lhs, rhs, count);
+    }
+
+    template <typename T, bool IsMax>
+    static T extremeSse2(const T* items, size_t count) noexcept
+    {
+        return extremeVector<T, IsMax>(items, count);
+    }
+
+    template <typename T, SeqArith Op, bool Broadcast>
+    static void mapSse2(const T* lhs, const T* rhs, T* out, size_t count) noexcept
+    {
+        mapVector<T, Op, Broadcast>(lhs, rhs, out, count);
+    }
+
+    template <typename T, SeqCompare Op, bool Broadcast>
+    static void compareSse2(const T* lhs, const T* rhs, uint8_t* out, size_t count) noexcept
+    {
+        compareVector<T, Op, Broadcast>(lhs, rhs, out, count);
+    }
+
+    // SSE2 cannot permute lanes by a runtime index, so its filter stays the branchless scalar loop.
+
+    /* AVX2 kernels: only called after a CPUID check. */
+
+    template <typename T>
+    __attribute__((target("avx2"))) static T sumAvx2(const T* items, size_t count) noexcept
+    {
+        return sumVector(items, count);
+    }
+
+    template <typename T>
+    __attribute__((target("avx2"))) static T dotAvx2(const T* lhs, const T* rhs, size_t count) noexcept
+    {
+        return dotVector(lhs, rhs, count);
+    }
+
+    template <typename T, bool IsMax>
+    __attribute__((target("avx2"))) static T extremeAvx2(const T* items, size_t count) noexcept
+    {
+        return extremeVector<T, IsMax>(items, count);
+    }
+
+    template <typename T, SeqArith Op, bool Broadcast>
+    __attribute__((target("avx2"))) static void mapAvx2(const T* lhs, const T* rhs, T* out, size_t count) noexcept
+    {
+        mapVector<T, Op, Broadcast>(lhs, rhs, out, count);
+    }
+
+    template <typename T, SeqCompare Op, bool Broadcast>
+    __attribute__((target("avx2"))) static void compareAvx2(const T* lhs, const T* rhs, uint8_t* out, size_t count) noexcept
+    {
+        compareVector<T, Op, Broadcast>(lhs, rhs, out, count);
+    }
+
+    /// @brief For each 4 bit keep mask, the 32-bit lane order that moves the kept 64-bit items to the front.
+    static constexpr auto compress_orders = [] {
+        std::array<std::array<int32_t, 8>, 16> orders {};
+
+        for (size_t mask = 0; mask < orders.size(); mask++)
+        {
+            size_t slot = 0;
+
+            for (int32_t item = 0; item < 4; item++)
+            {
+                if ((mask >> item) & 1)
+                {
+                    orders[mask][slot++] = item * 2;
+                    orders[mask][slot++] = item * 2 + 1;
+                }
+            }
+        }
+
+        return orders;
+    }();
+
+    template <typename T>
+    __attribute__((target("avx2"))) static size_t filterAvx2(const T* items, const uint8_t* keep, T* out, size_t count) noexcept
+    {
+        size_t pos = 0;
+        size_t kept = 0;
+
+        // A full register is stored at out + kept, which stays in bounds because kept never passes pos.
+        for (; pos + 4 <= count; pos += 4)
+        {
+            uint32_t flags;
+
+            std::memcpy(&flags, keep + pos, sizeof(flags));
+
+            const unsigned mask = (flags | (flags >> 7) | (flags >> 14) | (flags >> 21)) & 0xfU;
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + pos));
+            __m256i order = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compress_orders[mask].data()));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + kept), _mm256_permutevar8x32_epi32(chunk, order));
+            kept += std::popcount(mask);
+        }
+
+        return filterScalar(items, keep, out, pos, kept, count);
+    }
+
+#endif
+
+    /* Dispatch */
+
+    static SeqKernel detectSeqKernel() noexcept
+    {
+#if TISP_SEQ_X86
+        return __builtin_cpu_supports("avx2") ? SeqKernel::avx2 : SeqKernel::sse2;
+#else
+        return SeqKernel::scalar;
+#endif
+    }
+
+    static const SeqKernel best_kernel = detectSeqKernel();
+    static std::atomic<SeqKernel> active_kernel {best_kernel};
+
+    SeqKernel bestSeqKernel() noexcept
+    {
+        return best_kernel;
+    }
+
+    bool useSeqKernel(SeqKernel kernel) noexcept
+    {
+        if (kernel > best_kernel)
+            return false;
+
+        active_kernel.store(kernel, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    template <typename T>
+    static T sumItems(std::span<const T> items) noexcept
+    {
+#if TISP_SEQ_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case SeqKernel::avx2:
+                return sumAvx2(items.data(), items.size());
+            case SeqKernel::sse2:
+                return sumSse2(items.data(), items.size());
+            default:
+                break;
+        }
+#endif
+
+        return sumScalar(items.data(), items.size());
+    }
+
+    template <typename T>
+    static T dotItems(std::span<const T> lhs, std::span<const T> rhs) noexcept
+    {
+#if TISP_SEQ_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case SeqKernel::avx2:
+                return dotAvx2(lhs.data(), rhs.data(), lhs.size());
+            case SeqKernel::sse2:
+                return dotSse2(lhs.data(), rhs.data(), lhs.size());
+            default:
+                break;
+        }
+#endif
+
+        return dotScalar(lhs.data(), rhs.data(), lhs.size());
+    }
+
+    template <typename T, bool IsMax>
+    static T extremeKernel(std::span<const T> items) noexcept
+    {
+#if TISP_SEQ_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case SeqKernel::avx2:
+                return extremeAvx2<T, IsMax>(items.data(), items.size());
+            case SeqKernel::sse2:
+                return extremeSse2<T, IsMax>(items.data(), items.size());
+            default:
+                break;
+        }
+#endif
+
+        return extremeScalar<T, IsMax>(extremeSentinel<T, IsMax>(), items.data(), 0, items.size());
+    }
+
+    template <typename T, bool IsMax>
+    static T extremeItems(std::span<const T> items) noexcept
+    {
+        T result = extremeKernel<T, IsMax>(items);
+
+        // Only Doubles can end on the sentinel without having it as an item: when every item is NaN.
+        if constexpr (!std::is_integral_v<T>)
+        {
+            if (result == extremeSentinel<T, IsMax>() && std::find(items.begin(), items.end(), result) == items.end())
+                return std::numeric_limits<T>::quiet_NaN();
+        }
+
+        return result;
+    }
+
+    template <typename T, SeqArith Op>
+    static void mapItems(std::span<const T> lhs, std::span<const T> rhs, std::span<T> out) noexcept
+    {
+        const bool broadcast = rhs.size() == 1 && lhs.size() != 1;
+
+#if TISP_SEQ_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case SeqKernel::avx2:
+                return broadcast ? mapAvx2<T, Op, true>(lhs.data(), rhs.data(), out.data(), lhs.size()) : mapAvx2<T, Op, false>(lhs.data(), rhs.data(), out.data(), lhs.size());
+            case SeqKernel::sse2:
+                return broadcast ? mapSse2<T, Op, true>(lhs.data(), rhs.data(), out.data(), lhs.size()) : mapSse2<T, Op, false>(lhs.data(), rhs.data(), out.data(), lhs.size());
+            default:
+                break;
+        }
+#endif
+
+        mapScalar<T, Op>(lhs.data(), rhs.data(), broadcast ? 0 : 1, out.data(), 0, lhs.size());
+    }
+
+    template <typename T, SeqCompare Op>
+    static void compareItems(std::span<const T> lhs, std::span<const T> rhs, std::span<uint8_t> out) noexcept
+    {
+        const bool broadcast = rhs.size() == 1 && lhs.size() != 1;
+
+#if TISP_SEQ_X86
+        switch (active_kernel.load(std::memory_order_relaxed))
+        {
+            case SeqKernel::avx2:
+                return broadcast ? compareAvx2<T, Op, true>(lhs.data(), rhs.data(), out.data(), lhs.size()) : compareAvx2<T, Op, false>(lhs.data(), rhs.data(), out.data(), lhs.size());
+            case SeqKernel::sse2:
+                return broadcast ? compareSse2<T, Op, true>(lhs.data(), rhs.data(), out.data(), lhs.size()) : compareSse2<T, Op, false>(lhs.data(), rhs.data(), out.data(), lhs.size());
+            default:
+                break;
+        }
+#endif
+
+        compareScalar<T, Op>(lhs.data(), rhs.data(), broadcast ? 0 : 1, out.data(), 0, lhs.size());
+    }
+
+    template <typename T>
+    static size_t filterItems(std::span<const T> items, std::span<const uint8_t> keep, std::span<T> out) noexcept
+    {
+#if TISP_SEQ_X86
+        if (active_kernel.load(std::memory_order_relaxed) == SeqKernel::avx2)
+            return filterAvx2(items.data(), keep.data(), out.data(), items.size());
+#endif
+
+        return filterScalar(items.data(), keep.data(), out.data(), 0, 0, items.size());
+    }
+
+    template <typename T>
+    static void mapBy(SeqArith op, std::span<const T> lhs, std::span<const T> rhs, std::span<T> out) noexcept
+    {
+        switch (op)
+        {
+            case SeqArith::add:
+                return mapItems<T, SeqArith::add>(lhs, rhs, out);
+            case SeqArith::sub:
+                return mapItems<T, SeqArith::sub>(lhs, rhs, out);
+            case SeqArith::mul:
+            default:
+                return mapItems<T, SeqArith::mul>(lhs, rhs, out);
+        }
+    }
+
+    template <typename T>
+    static void compareBy(SeqCompare op, std::span<const T> lhs, std::span<const T> rhs, std::span<uint8_t> out) noexcept
+    {
+        switch (op)
+        {
+            case SeqCompare::less:
+                return compareItems<T, SeqCompare::less>(lhs, rhs, out);
+            case SeqCompare::greater:
+                return compareItems<T, SeqCompare::greater>(lhs, rhs, out);
+            case SeqCompare::equal:
+            default:
+                return compareItems<T, SeqCompare::equal>(lhs, rhs, out);
+        }
+    }
+
+    int64_t sumIntegers(std::span<const int64_t> items) noexcept
+    {
+        return sumItems(items);
+    }
+
+    double sumDoubles(std::span<const double> items) noexcept
+    {
+        return sumItems(items);
+    }
+
+    int64_t minIntegers(std::span<const int64_t> items) noexcept
+    {
+        return extremeItems<int64_t, false>(items);
+    }
+
+    int64_t maxIntegers(std::span<const int64_t> items) noexcept
+    {
+        return extremeItems<int64_t, true>(items);
+    }
+
+    double minDoubles(std::span<const double> items) noexcept
+    {
+        return extremeItems<double, false>(items);
+    }
+
+    double maxDoubles(std::span<const double> items) noexcept
+    {
+        return extremeItems<double, true>(items);
+    }
+
+    int64_t dotIntegers(std::span<const int64_t> lhs, std::span<const int64_t> rhs) noexcept
+    {
+        return dotItems(lhs, rhs);
+    }
+
+    double dotDoubles(std::span<const double> lhs, std::span<const double> rhs) noexcept
+    {
+        return dotItems(lhs, rhs);
+    }
+
+    void mapIntegers(SeqArith op, std::span<const int64_t> lhs, std::span<const int64_t> rhs, std::span<int64_t> out) noexcept
+    {
+        mapBy(op, lhs, rhs, out);
+    }
+
+    void mapDoubles(SeqArith op, std::span<const double> lhs, std::span<const double> rhs, std::span<double> out) noexcept
+    {
+        mapBy(op, lhs, rhs, out);
+    }
+
+    void compareIntegers(SeqCompare op, std::span<const int64_t> lhs, std::span<const int64_t> rhs, std::span<uint8_t> out) noexcept
+    {
+        compareBy(op, lhs, rhs, out);
+    }
+
+    void compareDoubles(SeqCompare op, std::span<const double> lhs, std::span<const double> rhs, std::span<uint8_t> out) noexcept
+    {
+        compareBy(op, lhs, rhs, out);
+    }
+
+    size_t filterIntegers(std::span<const int64_t> items, std::span<const uint8_t> keep, std::span<int64_t> out) noexcept
+    {
+        return filterItems(items, keep, out);
+    }
+
+    size_t filterDoubles(std::span<const double> items, std::span<const uint8_t> keep, std::span<double> out) noexcept
+    {
+        return filterItems(items, keep, out);
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file threadpool.cpp
+ * @author DrkWithT
+ * @brief Implements the work-stealing thread pool behind the parallel builtins.
+ * @date 2024-05-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include "runtime/threadpool.hpp"
+
+namespace tisp::runtime
+{
+    /* ThreadPool private impl. */
+
+    bool ThreadPool::takeTask(size_t worker, Task& task)
+    {
+        {
+            std::lock_guard own_guard {queues[worker]->lock};
+            auto& own = queues[worker]->tasks;
+
+            if (!own.empty())
+            {
+                task = std::move(own.back());
+                own.pop_back();
+                return true;
+            }
+        }
+
+        // Thieves take from the other end, which keeps them off the tasks the owner is about to run.
+        for (size_t offset = 1; offset < queues.size(); offset++)
+        {
+            TaskQueue& victim = *queues[(worker + offset) % queues.size()];
+            std::lock_guard victim_guard {victim.lock};
+
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::workerLoop(size_t worker)
+    {
+        uint64_t seen_batch = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock state_guard {state_lock};
+
+                work_ready.wait(state_guard, [&]() { return stopping || batch != seen_batch; });
+
+                if (stopping)
+                    return;
+
+                seen_batch = batch;
+            }
+
+            Task task;
+
+            while (takeTask(worker, task))
+            {
+                task(worker);
+
+                std::lock_guard state_guard {state_lock};
+
+                if (--pending == 0)
+                    work_done.notify_all();
+            }
+        }
+    }
+
+    /* ThreadPool public impl. */
+
+    ThreadPool::ThreadPool(size_t worker_count)
+    : queues {}, threads {}, state_lock {}, work_ready {}, work_done {}, pending {0}, batch {0}, stopping {false}
+    {
+        if (worker_count == 0)
+            worker_count = std::max(1U, std::thread::hardware_concurrency());
+
+        for (size_t worker = 0; worker < worker_count; worker++)
+            queues.push_back(std::make_unique<TaskQueue>());
+
+        threads.reserve(worker_count);
+
+        for (size_t worker = 0; worker < worker_count; worker++)
+            threads.emplace_back([this, worker]() { workerLoop(worker); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard state_guard {state_lock};
+
+            stopping = true;
+        }
+
+        work_ready.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    size_t ThreadPool::workerCount() const noexcept
+    {
+        return queues.size();
+    }
+
+    void ThreadPool::runAll(std::vector<Task> tasks)
+    {
+        if (tasks.empty())
+            return;
+
+        {
+            std::lock_guard state_guard {state_lock};
+
+            pending += tasks.size();
+
+            for (size_t task_pos = 0; task_pos < tasks.size(); task_pos++)
+            {
+                TaskQueue& queue = *queues[task_pos % queues.size()];
+                std::lock_guard queue_guard {queue.lock};
+
+                queue.tasks.push_back(std::move(tasks[task_pos]));
+            }
+
+            batch++;
+        }
+
+        work_ready.notify_all();
+
+        std::unique_lock state_guard {state_lock};
+
+        work_done.wait(state_guard, [this]() { return pending == 0; });
+    }
+}
@@ -0,0 +1,271 @@
+/**
+ * @file value.cpp
+ * @author DrkWithT
+ * @brief Implements runtime values and the object heap.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "runtime/value.hpp"
+
+namespace tisp::runtime
+{
+    template <typename Item, typename Unbox>
+    [[nodiscard]] static std::vector<Item> unboxItems(const std::vector<Value>& items, Unbox unbox)
+    {
+        std::vector<Item> result;
+
+        result.reserve(items.size());
+
+        for (Value item : items)
+            result.push_back(unbox(item));
+
+        return result;
+    }
+
+    /// @brief Approximate bytes an object holds, counting its text or item storage.
+    [[nodiscard]] static size_t byteSizeOf(const Object& object) noexcept
+    {
+        if (object.kind == ObjectKind::string)
+            return sizeof(StringObject) + static_cast<const StringObject&>(object).text.capacity();
+
+        const auto& seq = static_cast<const SeqObject&>(object);
+
+        return sizeof(SeqObject) + std::visit([](const auto& storage) {
+            using Item = typename std::decay_t<decltype(storage)>::value_type;
+
+            if constexpr (std::is_same_v<Item, bool>)
+                return storage.capacity() / 8;
+            else
+                return storage.capacity() * sizeof(Item);
+        }, seq.items);
+    }
+
+    /* Heap */
+
+    Heap::Heap(HeapKind kind_arg)
+    : objects {}, gray {}, live_bytes {0}, collection_bytes {min_collection_bytes}, kind {kind_arg} {}
+
+    template <typename ObjectType>
+    ObjectType* Heap::track(ObjectType* object)
+    {
+        object->is_pinned = kind == HeapKind::pinned;
+        live_bytes += byteSizeOf(*object);
+        objects.emplace_back(object);
+
+        return object;
+    }
+
+    StringObject* Heap::makeString(std::string text)
+    {
+        return track(new StringObject {std::move(text)});
+    }
+
+    SeqObject* Heap::makeSeq(std::vector<Value> items)
+    {
+        auto all_are = [&items](ValueTag tag) {
+            return !items.empty() && std::all_of(items.begin(), items.end(), [tag](Value item) { return item.getTag() == tag; });
+        };
+
+        if (all_are(ValueTag::integer))
+            return makeSeq(unboxItems<int64_t>(items, [](Value item) { return item.asInteger(); }));
+
+        if (all_are(ValueTag::ndouble))
+            return makeSeq(unboxItems<double>(items, [](Value item) { return item.asDouble(); }));
+
+        if (all_are(ValueTag::boolean))
+            return makeSeq(unboxItems<bool>(items, [](Value item) { return item.asBool(); }));
+
+        return track(new SeqObject {std::move(items)});
+    }
+
+    SeqObject* Heap::makeSeq(std::vector<int64_t> items)
+    {
+        return track(new SeqObject {std::move(items)});
+    }
+
+    SeqObject* Heap::makeSeq(std::vector<double> items)
+    {
+        return track(new SeqObject {std::move(items)});
+    }
+
+    SeqObject* Heap::makeSeq(std::vector<bool> items)
+    {
+        return track(new SeqObject {std::move(items)});
+    }
+
+    size_t Heap::objectCount() const noexcept
+    {
+        return objects.size();
+    }
+
+    bool Heap::isCollectionDue() const noexcept
+    {
+        return kind == HeapKind::collected && live_bytes >= collection_bytes;
+    }
+
+    void Heap::mark(Value value)
+    {
+        if (!value.isObject())
+            return;
+
+        gray.push_back(value.asObject());
+
+        // Nested Seqs are walked with the gray stack instead of recursion, so their depth is not bounded by the native stack.
+        while (!gray.empty())
+        {
+            Object* object = gray.back();
+
+            gray.pop_back();
+
+            if (object->marked || object->is_pinned)
+                continue;
+
+            object->marked = true;
+
+            if (object->kind != ObjectKind::sequence)
+                continue;
+
+            if (const auto* items = std::get_if<std::vector<Value>>(&static_cast<SeqObject*>(object)->items); items != nullptr)
+            {
+                for (Value item : *items)
+                {
+                    if (item.isObject())
+                        gray.push_back(item.asObject());
+                }
+            }
+        }
+    }
+
+    void Heap::sweep()
+    {
+        live_bytes = 0;
+
+        auto survivors_end = std::remove_if(objects.begin(), objects.end(), [this](const std::unique_ptr<Object>& object) {
+            if (!object->marked)
+                return true;
+
+            object->marked = false;
+            live_bytes += byteSizeOf(*object);
+
+            return false;
+        });
+
+        objects.erase(survivors_end, objects.end());
+        collection_bytes = std::max(min_collection_bytes, 2 * live_bytes);
+    }
+
+    void Heap::adopt(Heap& other)
+    {
+        objects.reserve(objects.size() + other.objects.size());
+
+        for (auto& object : other.objects)
+            objects.push_back(std::move(object));
+
+        live_bytes += other.live_bytes;
+        other.objects.clear();
+        other.live_bytes = 0;
+    }
+
+    /* Value helpers */
+
+    std::string_view valueTagName(ValueTag tag) noexcept
+    {
+        switch (tag)
+        {
+            case ValueTag::boolean:
+                return "Boolean";
+            case ValueTag::integer:
+                return "Integer";
+            case ValueTag::ndouble:
+                return "Double";
+            case ValueTag::string:
+                return "String";
+            case ValueTag::sequence:
+                return "Seq";
+            case ValueTag::function:
+                return "Function";
+            case ValueTag::nil:
+            default:
+                return "Nil";
+        }
+    }
+
+    bool valuesEqual(Value lhs, Value rhs) noexcept
+    {
+        if (lhs.isDouble() || rhs.isDouble())
+            return lhs.isDouble() && rhs.isDouble() && lhs.asDouble() == rhs.asDouble();
+
+        // Nil, Booleans, Integers, functions, and identical objects compare equal exactly when their words do.
+        if (lhs.getBits() == rhs.getBits())
+            return true;
+
+        if (lhs.isString() && rhs.isString())
+            return lhs.asString()->text == rhs.asString()->text;
+
+        if (lhs.isSeq() && rhs.isSeq())
+        {
+            const SeqObject& lhs_seq = *lhs.asSeq();
+            const SeqObject& rhs_seq = *rhs.asSeq();
+
+            if (lhs_seq.size() != rhs_seq.size())
+                return false;
+
+            for (size_t item_pos = 0; item_pos < lhs_seq.size(); item_pos++)
+            {
+                if (!valuesEqual(lhs_seq.at(item_pos), rhs_seq.at(item_pos)))
+                    return false;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void printValue(std::ostream& out, Value value)
+    {
+        switch (value.getTag())
+        {
+            case ValueTag::nil:
+                out << "Nil";
+                return;
+            case ValueTag::boolean:
+                out << (value.asBool() ? "true" : "false");
+                return;
+            case ValueTag::integer:
+                out << value.asInteger();
+                return;
+            case ValueTag::ndouble:
+                out << value.asDouble();
+                return;
+            case ValueTag::string:
+                out << value.asString()->text;
+                return;
+            case ValueTag::function:
+                out << "<defun #" << value.asFunction() << '>';
+                return;
+            default:
+                break;
+        }
+
+        const SeqObject& seq = *value.asSeq();
+
+        out << '[';
+
+        for (size_t item_pos = 0; item_pos < seq.size(); item_pos++)
+        {
+            if (item_pos > 0)
+                out << ", ";
+
+            printValue(out, seq.at(item_pos));
+        }
+
+        out << ']';
+    }
+}
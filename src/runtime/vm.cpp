@@ -0,0 +1,836 @@
+/**
+ * @file vm.cpp
+ * @author DrkWithT
+ * @brief Implements the bytecode interpreter.
+ * @date 2024-05-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "runtime/builtins.hpp"
+#include "runtime/vm.hpp"
+
+namespace tisp::runtime
+{
+    /* Operator helpers */
+
+    // These wrap at 64 bits, and Value::fromInteger then keeps the low 48, which is the same as wrapping at 48 bits.
+
+    [[nodiscard]] static constexpr int64_t wrapAdd(int64_t lhs, int64_t rhs) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(lhs) + static_cast<uint64_t>(rhs));
+    }
+
+    [[nodiscard]] static constexpr int64_t wrapSub(int64_t lhs, int64_t rhs) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(lhs) - static_cast<uint64_t>(rhs));
+    }
+
+    [[nodiscard]] static constexpr int64_t wrapMul(int64_t lhs, int64_t rhs) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(lhs) * static_cast<uint64_t>(rhs));
+    }
+
+    /// @brief Applies a numeric operator to two Integers or two Doubles. Mixed or non-numeric operands fail, since the language has no implicit conversions.
+    template <typename IntOp, typename DblOp>
+    [[nodiscard]] static bool applyArithmetic(Value lhs, Value rhs, Value& dest, IntOp int_op, DblOp dbl_op)
+    {
+        if (lhs.isInteger() && rhs.isInteger())
+            dest = Value::fromInteger(int_op(lhs.asInteger(), rhs.asInteger()));
+        else if (lhs.isDouble() && rhs.isDouble())
+            dest = Value::fromDouble(dbl_op(lhs.asDouble(), rhs.asDouble()));
+        else
+            return false;
+
+        return true;
+    }
+
+    template <typename Compare>
+    [[nodiscard]] static bool applyCompare(Value lhs, Value rhs, Value& dest, Compare compare)
+    {
+        if (lhs.isInteger() && rhs.isInteger())
+            dest = Value::fromBool(compare(lhs.asInteger(), rhs.asInteger()));
+        else if (lhs.isDouble() && rhs.isDouble())
+            dest = Value::fromBool(compare(lhs.asDouble(), rhs.asDouble()));
+        else if (lhs.isString() && rhs.isString())
+            dest = Value::fromBool(compare(lhs.asString()->text, rhs.asString()->text));
+        else
+            return false;
+
+        return true;
+    }
+
+    /* Seq helpers */
+
+    [[nodiscard]] static std::string rangeError(int64_t position, size_t length)
+    {
+        return "position " + std::to_string(position) + " is out of range for a Seq of length " + std::to_string(length);
+    }
+
+    /// @brief Reads an unboxed item for the typed index opcodes. A Seq not stored as Item reads as out of range, and typed code only meets one in the empty default of a global read before its initializer ran.
+    template <typename Item>
+    [[nodiscard]] static bool readUnboxed(const SeqObject& seq, int64_t position, Item& result) noexcept
+    {
+        const auto* items = std::get_if<std::vector<Item>>(&seq.items);
+
+        if (items == nullptr || position < 0 || static_cast<uint64_t>(position) >= items->size())
+            return false;
+
+        result = (*items)[static_cast<size_t>(position)];
+
+        return true;
+    }
+
+    /* Vm private impl. */
+
+    ExecStatus Vm::fail(const FunctionProto& where, std::string message)
+    {
+        error = "in " + where.name + ": " + std::move(message);
+
+        return ExecStatus::runtime_error;
+    }
+
+    void Vm::collectIfDue(const FunctionProto& function, Value* base)
+    {
+        if (!heap.isCollectionDue() || reentry_depth > 0)
+            return;
+
+        // A callee may use fewer registers than its caller has above the call, so every frame's top counts.
+        Value* live_end = base + function.register_count;
+
+        for (const auto& frame : frames)
+            live_end = std::max<Value*>(live_end, frame.base + frame.function->register_count);
+
+        for (const Value* slot = registers.data(); slot < live_end; slot++)
+            heap.mark(*slot);
+
+        // Registers above the live frames may still hold objects this sweep frees, and a later frame there must not mark them.
+        std::fill(live_end, dirty_end, Value {});
+        dirty_end = live_end;
+
+        for (Value global : globals)
+            heap.mark(global);
+
+        heap.mark(result);
+        heap.sweep();
+    }
+
+    /*
+     * Dispatch: every handler ends in VM_NEXT. The threaded loop jumps straight from each handler to the next one through the handler table, so each opcode gets its own indirect branch and its own prediction history. The switch loop funnels every opcode through the single jump at dispatch. Builds with computed goto instantiate both loops so a run can pick either, and other builds only have the switch loop.
+     */
+
+#ifdef TISP_HAS_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+#define VM_NEXT()                                                         \
+    do                                                                    \
+    {                                                                     \
+        code = *ip++;                                                     \
+        if constexpr (Mode == DispatchMode::threaded)                     \
+            goto *handlers[static_cast<uint8_t>(opOf(code))];             \
+        else                                                              \
+            goto dispatch;                                                \
+    } while (false)
+#else
+#define VM_NEXT()                                                         \
+    do                                                                    \
+    {                                                                     \
+        code = *ip++;                                                     \
+        goto dispatch;                                                    \
+    } while (false)
+#endif
+
+#define VM_CASE(op) handle_##op:
+
+    template <DispatchMode Mode>
+    ExecStatus Vm::execute(const Program& program, uint16_t entry, Value* entry_base)
+    {
+        const FunctionProto* function = &program.functions[entry];
+        const Instruction* ip = function->code.data();
+        const Value* constants = function->constants.data();
+        Value* base = entry_base;
+        const Value* stack_end = registers.data() + registers.size();
+        const auto builtins = builtinTable();
+        size_t entry_depth = frames.size();
+        Instruction code;
+
+        if (base + function->register_count > stack_end)
+            return fail(*function, "stack overflow");
+
+        dirty_end = std::max<Value*>(dirty_end, base + function->register_count);
+
+#ifdef TISP_HAS_COMPUTED_GOTO
+        // Indexed by opcode. Bytecode comes from our own compiler, so opcodes are always in range.
+        static const void* const handlers[] {
+            &&handle_move,
+            &&handle_load_const,
+            &&handle_load_int,
+            &&handle_load_nil,
+            &&handle_load_bool,
+            &&handle_get_global,
+            &&handle_set_global,
+            &&handle_add,
+            &&handle_sub,
+            &&handle_mul,
+            &&handle_div,
+            &&handle_neg,
+            &&handle_eq,
+            &&handle_ne,
+            &&handle_lt,
+            &&handle_le,
+            &&handle_gt,
+            &&handle_ge,
+            &&handle_add_i64,
+            &&handle_sub_i64,
+            &&handle_mul_i64,
+            &&handle_div_i64,
+            &&handle_neg_i64,
+            &&handle_add_f64,
+            &&handle_sub_f64,
+            &&handle_mul_f64,
+            &&handle_div_f64,
+            &&handle_neg_f64,
+            &&handle_eq_i64,
+            &&handle_ne_i64,
+            &&handle_lt_i64,
+            &&handle_le_i64,
+            &&handle_eq_f64,
+            &&handle_ne_f64,
+            &&handle_lt_f64,
+            &&handle_le_f64,
+            &&handle_concat_str,
+            &&handle_check_type,
+            &&handle_jump,
+            &&handle_jump_if_false,
+            &&handle_jump_if_true,
+            &&handle_switch_int,
+            &&handle_switch_str,
+            &&handle_call,
+            &&handle_tail_call,
+            &&handle_call_builtin,
+            &&handle_length,
+            &&handle_index,
+            &&handle_index_i64,
+            &&handle_index_f64,
+            &&handle_index_bool,
+            &&handle_ret,
+            &&handle_ret_nil
+        };
+
+        static_assert(std::size(handlers) == static_cast<size_t>(Opcode::last) + 1, "every opcode needs a handler");
+#endif
+
+        code = *ip++;
+        goto dispatch;
+
+    dispatch:
+#ifdef TISP_HAS_COMPUTED_GOTO
+        // The threaded loop enters at its first handler like any other jump between handlers, and never contains the switch.
+        if constexpr (Mode == DispatchMode::threaded)
+            goto *handlers[static_cast<uint8_t>(opOf(code))];
+        else
+#endif
+        switch (opOf(code))
+        {
+            case Opcode::move:
+                goto handle_move;
+            case Opcode::load_const:
+                goto handle_load_const;
+            case Opcode::load_int:
+                goto handle_load_int;
+            case Opcode::load_nil:
+                goto handle_load_nil;
+            case Opcode::load_bool:
+                goto handle_load_bool;
+            case Opcode::get_global:
+                goto handle_get_global;
+            case Opcode::set_global:
+                goto handle_set_global;
+            case Opcode::add:
+                goto handle_add;
+            case Opcode::sub:
+                goto handle_sub;
+            case Opcode::mul:
+                goto handle_mul;
+            case Opcode::div:
+                goto handle_div;
+            case Opcode::neg:
+                goto handle_neg;
+            case Opcode::eq:
+                goto handle_eq;
+            case Opcode::ne:
+                goto handle_ne;
+            case Opcode::lt:
+                goto handle_lt;
+            case Opcode::le:
+                goto handle_le;
+            case Opcode::gt:
+                goto handle_gt;
+            case Opcode::ge:
+                goto handle_ge;
+            case Opcode::add_i64:
+                goto handle_add_i64;
+            case Opcode::sub_i64:
+                goto handle_sub_i64;
+            case Opcode::mul_i64:
+                goto handle_mul_i64;
+            case Opcode::div_i64:
+                goto handle_div_i64;
+            case Opcode::neg_i64:
+                goto handle_neg_i64;
+            case Opcode::add_f64:
+                goto handle_add_f64;
+            case Opcode::sub_f64:
+                goto handle_sub_f64;
+            case Opcode::mul_f64:
+                goto handle_mul_f64;
+            case Opcode::div_f64:
+                goto handle_div_f64;
+            case Opcode::neg_f64:
+                goto handle_neg_f64;
+            case Opcode::eq_i64:
+                goto handle_eq_i64;
+            case Opcode::ne_i64:
+                goto handle_ne_i64;
+            case Opcode::lt_i64:
+                goto handle_lt_i64;
+            case Opcode::le_i64:
+                goto handle_le_i64;
+            case Opcode::eq_f64:
+                goto handle_eq_f64;
+            case Opcode::ne_f64:
+                goto handle_ne_f64;
+            case Opcode::lt_f64:
+                goto handle_lt_f64;
+            case Opcode::le_f64:
+                goto handle_le_f64;
+            case Opcode::concat_str:
+                goto handle_concat_str;
+            case Opcode::check_type:
+                goto handle_check_type;
+            case Opcode::jump:
+                goto handle_jump;
+            case Opcode::jump_if_false:
+                goto handle_jump_if_false;
+            case Opcode::jump_if_true:
+                goto handle_jump_if_true;
+            case Opcode::switch_int:
+                goto handle_switch_int;
+            case Opcode::switch_str:
+                goto handle_switch_str;
+            case Opcode::call:
+                goto handle_call;
+            case Opcode::tail_call:
+                goto handle_tail_call;
+            case Opcode::call_builtin:
+                goto handle_call_builtin;
+            case Opcode::length:
+                goto handle_length;
+            case Opcode::index:
+                goto handle_index;
+            case Opcode::index_i64:
+                goto handle_index_i64;
+            case Opcode::index_f64:
+                goto handle_index_f64;
+            case Opcode::index_bool:
+                goto handle_index_bool;
+            case Opcode::ret:
+                goto handle_ret;
+            case Opcode::ret_nil:
+                goto handle_ret_nil;
+            default:
+                return fail(*function, "bad opcode " + std::to_string(static_cast<int>(opOf(code))));
+        }
+
+        VM_CASE(move)
+            base[argA(code)] = base[argB(code)];
+            VM_NEXT();
+        VM_CASE(load_const)
+            base[argA(code)] = constants[argBx(code)];
+            VM_NEXT();
+        VM_CASE(load_int)
+            base[argA(code)] = Value::fromInteger(argSBx(code));
+            VM_NEXT();
+        VM_CASE(load_nil)
+            base[argA(code)] = Value {};
+            VM_NEXT();
+        VM_CASE(load_bool)
+            base[argA(code)] = Value::fromBool(argB(code) != 0);
+            VM_NEXT();
+        VM_CASE(get_global)
+            base[argA(code)] = globals[argBx(code)];
+            VM_NEXT();
+        VM_CASE(set_global)
+            globals[argBx(code)] = base[argA(code)];
+            VM_NEXT();
+        VM_CASE(add)
+        {
+            Value lhs = base[argB(code)];
+            Value rhs = base[argC(code)];
+
+            if (applyArithmetic(lhs, rhs, base[argA(code)], wrapAdd, [](double a, double b) { return a + b; }))
+                VM_NEXT();
+
+            if (!lhs.isString() || !rhs.isString())
+                return fail(*function, "operands of '+' must both be Integer, Double, or String");
+
+            collectIfDue(*function, base);
+            base[argA(code)] = Value::fromObject(heap.makeString(lhs.asString()->text + rhs.asString()->text));
+            VM_NEXT();
+        }
+        VM_CASE(sub)
+            if (!applyArithmetic(base[argB(code)], base[argC(code)], base[argA(code)], wrapSub, [](double a, double b) { return a - b; }))
+                return fail(*function, "operands of '-' must both be Integer or Double");
+            VM_NEXT();
+        VM_CASE(mul)
+            if (!applyArithmetic(base[argB(code)], base[argC(code)], base[argA(code)], wrapMul, [](double a, double b) { return a * b; }))
+                return fail(*function, "operands of '*' must both be Integer or Double");
+            VM_NEXT();
+        VM_CASE(div)
+        {
+            Value lhs = base[argB(code)];
+            Value rhs = base[argC(code)];
+
+            if (lhs.isInteger() && rhs.isInteger())
+            {
+                if (rhs.asInteger() == 0)
+                    return fail(*function, "division by zero");
+
+                // 48-bit operands cannot overflow a 64-bit quotient, and the one out-of-range result (min_integer / -1) wraps when boxed.
+                base[argA(code)] = Value::fromInteger(lhs.asInteger() / rhs.asInteger());
+            }
+            else if (lhs.isDouble() && rhs.isDouble())
+                base[argA(code)] = Value::fromDouble(lhs.asDouble() / rhs.asDouble());
+            else
+                return fail(*function, "operands of '/' must both be Integer or Double");
+            VM_NEXT();
+        }
+        VM_CASE(neg)
+        {
+            Value inner = base[argB(code)];
+
+            if (inner.isInteger())
+                base[argA(code)] = Value::fromInteger(wrapSub(0, inner.asInteger()));
+            else if (inner.isDouble())
+                base[argA(code)] = Value::fromDouble(-inner.asDouble());
+            else
+                return fail(*function, "operand of unary '-' must be Integer or Double");
+            VM_NEXT();
+        }
+        VM_CASE(eq)
+            base[argA(code)] = Value::fromBool(valuesEqual(base[argB(code)], base[argC(code)]));
+            VM_NEXT();
+        VM_CASE(ne)
+            base[argA(code)] = Value::fromBool(!valuesEqual(base[argB(code)], base[argC(code)]));
+            VM_NEXT();
+        VM_CASE(lt)
+            if (!applyCompare(base[argB(code)], base[argC(code)], base[argA(code)], [](const auto& a, const auto& b) { return a < b; }))
+                return fail(*function, "operands of '<' must both be Integer, Double, or String");
+            VM_NEXT();
+        VM_CASE(le)
+            if (!applyCompare(base[argB(code)], base[argC(code)], base[argA(code)], [](const auto& a, const auto& b) { return a <= b; }))
+                return fail(*function, "operands of '<=' must both be Integer, Double, or String");
+            VM_NEXT();
+        VM_CASE(gt)
+            if (!applyCompare(base[argB(code)], base[argC(code)], base[argA(code)], [](const auto& a, const auto& b) { return a > b; }))
+                return fail(*function, "operands of '>' must both be Integer, Double, or String");
+            VM_NEXT();
+        VM_CASE(ge)
+            if (!applyCompare(base[argB(code)], base[argC(code)], base[argA(code)], [](const auto& a, const auto& b) { return a >= b; }))
+                return fail(*function, "operands of '>=' must both be Integer, Double, or String");
+            VM_NEXT();
+        VM_CASE(add_i64)
+            base[argA(code)] = Value::fromInteger(wrapAdd(base[argB(code)].asInteger(), base[argC(code)].asInteger()));
+            VM_NEXT();
+        VM_CASE(sub_i64)
+            base[argA(code)] = Value::fromInteger(wrapSub(base[argB(code)].asInteger(), base[argC(code)].asInteger()));
+            VM_NEXT();
+        VM_CASE(mul_i64)
+            base[argA(code)] = Value::fromInteger(wrapMul(base[argB(code)].asInteger(), base[argC(code)].asInteger()));
+            VM_NEXT();
+        VM_CASE(div_i64)
+        {
+            int64_t divisor = base[argC(code)].asInteger();
+
+            if (divisor == 0)
+                return fail(*function, "division by zero");
+
+            base[argA(code)] = Value::fromInteger(base[argB(code)].asInteger() / divisor);
+            VM_NEXT();
+        }
+        VM_CASE(neg_i64)
+            base[argA(code)] = Value::fromInteger(wrapSub(0, base[argB(code)].asInteger()));
+            VM_NEXT();
+        VM_CASE(add_f64)
+            base[argA(code)] = Value::fromDouble(base[argB(code)].asDouble() + base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(sub_f64)
+            base[argA(code)] = Value::fromDouble(base[argB(code)].asDouble() - base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(mul_f64)
+            base[argA(code)] = Value::fromDouble(base[argB(code)].asDouble() * base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(div_f64)
+            base[argA(code)] = Value::fromDouble(base[argB(code)].asDouble() / base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(neg_f64)
+            base[argA(code)] = Value::fromDouble(-base[argB(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(eq_i64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asInteger() == base[argC(code)].asInteger());
+            VM_NEXT();
+        VM_CASE(ne_i64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asInteger() != base[argC(code)].asInteger());
+            VM_NEXT();
+        VM_CASE(lt_i64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asInteger() < base[argC(code)].asInteger());
+            VM_NEXT();
+        VM_CASE(le_i64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asInteger() <= base[argC(code)].asInteger());
+            VM_NEXT();
+        VM_CASE(eq_f64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asDouble() == base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(ne_f64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asDouble() != base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(lt_f64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asDouble() < base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(le_f64)
+            base[argA(code)] = Value::fromBool(base[argB(code)].asDouble() <= base[argC(code)].asDouble());
+            VM_NEXT();
+        VM_CASE(concat_str)
+            collectIfDue(*function, base);
+            base[argA(code)] = Value::fromObject(heap.makeString(base[argB(code)].asString()->text + base[argC(code)].asString()->text));
+            VM_NEXT();
+        VM_CASE(check_type)
+        {
+            auto expected = static_cast<ValueTag>(argB(code));
+            ValueTag actual = base[argA(code)].getTag();
+
+            if (actual != expected)
+                return fail(*function, "expected " + std::string {valueTagName(expected)} + " but got " + std::string {valueTagName(actual)});
+            VM_NEXT();
+        }
+        VM_CASE(jump)
+            ip += argSAx(code);
+            VM_NEXT();
+        VM_CASE(jump_if_false)
+        VM_CASE(jump_if_true)
+        {
+            Value condition = base[argA(code)];
+
+            if (!condition.isBool())
+                return fail(*function, "condition is not a Boolean");
+
+            if (condition.asBool() == (opOf(code) == Opcode::jump_if_true))
+                ip += argSBx(code);
+            VM_NEXT();
+        }
+        VM_CASE(switch_int)
+        {
+            const IntSwitch& table = function->int_switches[argBx(code)];
+            int64_t key = base[argA(code)].asInteger();
+
+            if (key < table.low)
+                ip += table.below;
+            else if (static_cast<uint64_t>(key - table.low) >= table.targets.size())
+                ip += table.above;
+            else
+                ip += table.targets[static_cast<size_t>(key - table.low)];
+            VM_NEXT();
+        }
+        VM_CASE(switch_str)
+        {
+            const StringSwitch& table = function->string_switches[argBx(code)];
+            auto found = table.targets.find(base[argA(code)].asString()->text);
+
+            ip += (found != table.targets.end()) ? found->second : table.fallback;
+            VM_NEXT();
+        }
+        VM_CASE(call)
+        {
+            const FunctionProto* callee = &program.functions[argBx(code)];
+            Value* callee_base = base + argA(code);
+
+            if (callee_base + callee->register_count > stack_end || frames.size() >= registers.size())
+                return fail(*callee, "stack overflow");
+
+            dirty_end = std::max<Value*>(dirty_end, callee_base + callee->register_count);
+
+            frames.push_back({.function = function, .return_ip = ip, .base = base});
+
+            function = callee;
+            ip = callee->code.data();
+            constants = callee->constants.data();
+            base = callee_base;
+            VM_NEXT();
+        }
+        VM_CASE(tail_call)
+        {
+            const FunctionProto* callee = &program.functions[argBx(code)];
+
+            if (base + callee->register_count > stack_end)
+                return fail(*callee, "stack overflow");
+
+            dirty_end = std::max<Value*>(dirty_end, base + callee->register_count);
+
+            // The arguments sit above the current frame's locals, so copying them down never overwrites one not yet moved.
+            std::copy_n(base + argA(code), callee->arity, base);
+
+            function = callee;
+            ip = callee->code.data();
+            constants = callee->constants.data();
+            VM_NEXT();
+        }
+        VM_CASE(call_builtin)
+        {
+            const BuiltinEntry& callee = builtins[argB(code)];
+            Value* args = base + argA(code);
+            Value returned {};
+
+            // Registers past the arguments hold no live values, so a call back into Tisp from the builtin starts there.
+            reentry_base = args + argC(code);
+
+            if (!callee.call(*this, args, argC(code), returned))
+                return fail(*function, std::string {callee.name} + ": " + error);
+
+            args[0] = returned;
+
+            // Builtins make their results in the heap, and every value they returned is in a register now.
+            collectIfDue(*function, base);
+            VM_NEXT();
+        }
+        VM_CASE(length)
+        {
+            Value target = base[argB(code)];
+
+            if (target.isSeq())
+                base[argA(code)] = Value::fromInteger(static_cast<int64_t>(target.asSeq()->size()));
+            else if (target.isString())
+                base[argA(code)] = Value::fromInteger(static_cast<int64_t>(target.asString()->text.length()));
+            else
+                return fail(*function, "length needs a Seq or String");
+            VM_NEXT();
+        }
+        VM_CASE(index)
+        {
+            Value target = base[argB(code)];
+            Value position = base[argC(code)];
+
+            if (!target.isSeq() || !position.isInteger())
+                return fail(*function, "'@' needs a Seq and an Integer position");
+
+            const SeqObject& seq = *target.asSeq();
+
+            if (position.asInteger() < 0 || static_cast<uint64_t>(position.asInteger()) >= seq.size())
+                return fail(*function, rangeError(position.asInteger(), seq.size()));
+
+            base[argA(code)] = seq.at(static_cast<size_t>(position.asInteger()));
+            VM_NEXT();
+        }
+        VM_CASE(index_i64)
+        {
+            const SeqObject& seq = *base[argB(code)].asSeq();
+            int64_t position = base[argC(code)].asInteger();
+            int64_t item = 0;
+
+            if (!readUnboxed(seq, position, item))
+                return fail(*function, rangeError(position, seq.size()));
+
+            base[argA(code)] = Value::fromInteger(item);
+            VM_NEXT();
+        }
+        VM_CASE(index_f64)
+        {
+            const SeqObject& seq = *base[argB(code)].asSeq();
+            int64_t position = base[argC(code)].asInteger();
+            double item = 0.0;
+
+            if (!readUnboxed(seq, position, item))
+                return fail(*function, rangeError(position, seq.size()));
+
+            base[argA(code)] = Value::fromDouble(item);
+            VM_NEXT();
+        }
+        VM_CASE(index_bool)
+        {
+            const SeqObject& seq = *base[argB(code)].asSeq();
+            int64_t position = base[argC(code)].asInteger();
+            bool item = false;
+
+            if (!readUnboxed(seq, position, item))
+                return fail(*function, rangeError(position, seq.size()));
+
+            base[argA(code)] = Value::fromBool(item);
+            VM_NEXT();
+        }
+        VM_CASE(ret)
+        VM_CASE(ret_nil)
+        {
+            Value returned = (opOf(code) == Opcode::ret) ? base[argA(code)] : Value {};
+
+            if (frames.size() == entry_depth)
+            {
+                result = returned;
+                return ExecStatus::ok;
+            }
+
+            // The callee's first register is the caller's call register.
+            base[0] = returned;
+
+            const CallFrame& caller = frames.back();
+
+            function = caller.function;
+            ip = caller.return_ip;
+            constants = function->constants.data();
+            base = caller.base;
+            frames.pop_back();
+            VM_NEXT();
+        }
+    }
+
+#undef VM_CASE
+#undef VM_NEXT
+
+#ifdef TISP_HAS_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+    ExecStatus Vm::executeInMode(const Program& program, uint16_t entry, Value* entry_base)
+    {
+#ifdef TISP_HAS_COMPUTED_GOTO
+        if (mode == DispatchMode::threaded)
+            return execute<DispatchMode::threaded>(program, entry, entry_base);
+#endif
+
+        return execute<DispatchMode::switch_loop>(program, entry, entry_base);
+    }
+
+    /* Vm public impl. */
+
+    Vm::Vm(std::ostream& out_arg, size_t register_limit)
+    : heap {}, registers(register_limit), globals {}, frames {}, out {out_arg}, error {}, result {}, program {nullptr}, mode {default_dispatch}, reentry_base {registers.data()}, dirty_end {registers.data()}, reentry_depth {0}, pool {}, workers {}, worker_count {0}, is_worker {false} {}
+
+    ExecStatus Vm::run(const Program& program_arg, DispatchMode mode_arg)
+    {
+        globals = program_arg.global_defaults;
+        frames.clear();
+        error.clear();
+        result = Value {};
+        program = &program_arg;
+        mode = mode_arg;
+        reentry_base = registers.data();
+
+        if (program->init_function != no_function)
+        {
+            if (ExecStatus status = executeInMode(*program, program->init_function, registers.data()); status != ExecStatus::ok)
+                return status;
+        }
+
+        if (program->main_function != no_function)
+            return executeInMode(*program, program->main_function, registers.data());
+
+        return ExecStatus::ok;
+    }
+
+    Value Vm::getResult() const noexcept
+    {
+        return result;
+    }
+
+    const std::string& Vm::getError() const noexcept
+    {
+        return error;
+    }
+
+    Heap& Vm::getHeap() noexcept
+    {
+        return heap;
+    }
+
+    std::ostream& Vm::getOutput() noexcept
+    {
+        return out;
+    }
+
+    void Vm::reportError(std::string message)
+    {
+        error = std::move(message);
+    }
+
+    void Vm::setWorkerCount(size_t count) noexcept
+    {
+        worker_count = count;
+    }
+
+    ExecStatus Vm::call(uint16_t function_id, std::span<const Value> args, Value& returned)
+    {
+        Value* entry_base = reentry_base;
+        size_t entry_depth = frames.size();
+
+        if (entry_base + args.size() > registers.data() + registers.size())
+            return fail(program->functions[function_id], "stack overflow");
+
+        std::copy(args.begin(), args.end(), entry_base);
+
+        reentry_depth++;
+
+        ExecStatus status = executeInMode(*program, function_id, entry_base);
+
+        reentry_depth--;
+
+        // A failed call leaves its frames behind, and a worker VM is reused after reporting the error.
+        frames.resize(entry_depth);
+        reentry_base = entry_base;
+        returned = result;
+
+        return status;
+    }
+
+    const Program& Vm::getProgram() const noexcept
+    {
+        return *program;
+    }
+
+    ThreadPool& Vm::startWorkers()
+    {
+        if (!pool)
+        {
+            pool = std::make_unique<ThreadPool>(worker_count);
+
+            for (size_t worker = 0; worker < pool->workerCount(); worker++)
+            {
+                workers.push_back(std::make_unique<Vm>(out, registers.size()));
+                workers.back()->is_worker = true;
+            }
+        }
+
+        for (auto& worker : workers)
+        {
+            worker->globals = globals;
+            worker->program = program;
+            worker->mode = mode;
+            worker->reentry_base = worker->registers.data();
+            worker->frames.clear();
+        }
+
+        return *pool;
+    }
+
+    Vm& Vm::getWorker(size_t worker) noexcept
+    {
+        return *workers[worker];
+    }
+
+    bool Vm::isWorker() const noexcept
+    {
+        return is_worker;
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * @file lexicon_test.cpp
+ * @author DrkWithT
+ * @brief Checks that the Lexer's perfect hash classifies every word and operator like the old std::set / std::map tables did.
+ * @date 2024-04-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "frontend/lexicon.hpp"
+#include "frontend/lexer.hpp"
+
+namespace tisp::tests
+{
+    using frontend::TokenType;
+
+    /**
+     * @brief The classification the Lexer did before the perfect hash: words through the tnames and kwords sets, operators through the symbols map, all filled from the entries table.
+     */
+    class SetMapClassifier
+    {
+    private:
+        std::map<std::string, TokenType> symbols;
+        std::set<std::string> kwords;
+        std::set<std::string> tnames;
+
+    public:
+        SetMapClassifier()
+        : symbols {}, kwords {}, tnames {}
+        {
+            for (const auto& entry : frontend::lexicalEntries())
+            {
+                auto entry_type = entry.type;
+
+                if (entry_type == TokenType::tname)
+                    tnames.insert(std::string {entry.lexeme});
+                else if (entry_type == TokenType::keyword)
+                    kwords.insert(std::string {entry.lexeme});
+                else if (entry_type >= TokenType::op_invoke && entry_type <= TokenType::arrow)
+                    symbols[std::string {entry.lexeme}] = entry_type;
+            }
+        }
+
+        [[nodiscard]] TokenType classifyWord(const std::string& lexeme) const
+        {
+            if (tnames.find(lexeme) != tnames.end())
+                return TokenType::tname;
+            else if (kwords.find(lexeme) != kwords.end())
+                return TokenType::keyword;
+
+            return TokenType::identifier;
+        }
+
+        [[nodiscard]] TokenType classifyPunctuation(const std::string& lexeme) const
+        {
+            if (symbols.find(lexeme) == symbols.end())
+                return TokenType::unknown;
+
+            return symbols.at(lexeme);
+        }
+    };
+
+    // Near misses of the reserved lexemes: prefixes, suffixes, case changes, and operator runs with no entry.
+    static constexpr std::string_view near_misses =
+        "Boolea Booleans boolean INTEGER Integer_ Doubles Str Seqs Ni Nil_ "
+        "consts va variable defunc matcher cases returning whil generics us used defaults True falsey "
+        "print main x _ _var a1 "
+        "=> =< !! ! & | :: -- --> ->> <<= ==> !== &&& ||| $$ @@ +- */ :- ";
+
+    /// @brief Lexes source and counts the word and operator tokens whose type differs from the old classification.
+    static size_t countMismatches(std::string_view name, std::string_view source, const SetMapClassifier& expected)
+    {
+        frontend::Lexer lexer {};
+        frontend::TokenBuffer tokens = lexer.tokenizeSource(source);
+        size_t mismatches = 0;
+
+        for (const auto token : tokens.view())
+        {
+            std::string_view lexeme = frontend::viewLexeme(token, source);
+            TokenType old_type;
+
+            if (token.type == TokenType::strbody || token.type == TokenType::comment || lexeme.empty())
+                continue;
+            else if (frontend::matchAlphabetic(lexeme[0]))
+                old_type = expected.classifyWord(std::string {lexeme});
+            else if (frontend::matchOpSymbol(lexeme[0]))
+                old_type = expected.classifyPunctuation(std::string {lexeme});
+            else
+                continue;
+
+            if (token.type != old_type)
+            {
+                std::cerr << name << ": '" << lexeme << "' lexed as " << static_cast<int>(token.type) << " but the old tables give " << static_cast<int>(old_type) << '\n';
+                mismatches++;
+            }
+        }
+
+        return mismatches;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace tisp;
+
+    tests::SetMapClassifier expected {};
+    std::string every_entry {};
+
+    for (const auto& entry : frontend::lexicalEntries())
+    {
+        every_entry += entry.lexeme;
+        every_entry += ' ';
+    }
+
+    size_t mismatches = tests::countMismatches("entries", every_entry, expected)
+        + tests::countMismatches("near misses", tests::near_misses, expected);
+    size_t file_count = 0;
+
+    // Every script under the given directories, e.g testprogs, must lex the same too.
+    for (int arg_pos = 1; arg_pos < argc; arg_pos++)
+    {
+        for (const auto& item : std::filesystem::directory_iterator {argv[arg_pos]})
+        {
+            if (item.path().extension() != ".tisp")
+                continue;
+
+            std::ifstream fin {item.path()};
+            std::ostringstream contents {};
+
+            contents << fin.rdbuf();
+            mismatches += tests::countMismatches(item.path().string(), contents.str(), expected);
+            file_count++;
+        }
+    }
+
+    std::cout << "lexicon_test: " << frontend::lexicalEntries().size() << " entries, " << file_count << " files, " << mismatches << " mismatches\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}
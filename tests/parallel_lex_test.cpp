@@ -0,0 +1,62 @@
+/**
+ * @file parallel_lex_test.cpp
+ * @author DrkWithT
+ * @brief Checks that tokenizeSourceParallel gives exactly the serial tokens and trivia for every worker count.
+ * @date 2024-05-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "frontend/chunklexer.hpp"
+#include "frontend/lexer.hpp"
+#include "randomsource.hpp"
+
+int main()
+{
+    using namespace tisp;
+    using frontend::TriviaMode;
+
+    std::mt19937 rng {20240430};
+    std::vector<std::string> sources {};
+
+    for (size_t i = 0; i < 3; i++)
+        sources.push_back(tests::makeRandomSource(rng, frontend::min_parallel_source_length + 4099 + i * 700000));
+
+    // A comment over most of the source leaves no split points inside it, and a source without newlines has none at all.
+    sources.push_back("#" + std::string(frontend::min_parallel_source_length, '\n') + "#" + tests::makeRandomSource(rng, 300000));
+    sources.push_back(std::string(frontend::min_parallel_source_length + 1, 'x'));
+
+    size_t run_count = 0;
+    size_t mismatches = 0;
+
+    for (const auto& source : sources)
+    {
+        for (auto mode : {TriviaMode::keep, TriviaMode::skip})
+        {
+            frontend::Lexer lexer {};
+            frontend::TokenBuffer serial_trivia {};
+            frontend::TokenBuffer serial = lexer.tokenizeSource(source, mode, &serial_trivia);
+
+            for (size_t worker_count : {2, 3, 7})
+            {
+                std::string name = std::to_string(source.length()) + " bytes, " + std::to_string(worker_count) + " workers, mode " + std::to_string(static_cast<int>(mode));
+                frontend::TokenBuffer parallel_trivia {};
+                frontend::TokenBuffer parallel = frontend::tokenizeSourceParallel(source, worker_count, mode, &parallel_trivia);
+
+                if (!tests::sameTokens(name, serial, parallel) || !tests::sameTokens(name + " trivia", serial_trivia, parallel_trivia))
+                    mismatches++;
+
+                run_count++;
+            }
+        }
+    }
+
+    std::cout << "parallel_lex_test: " << sources.size() << " sources, " << run_count << " runs, " << mismatches << " mismatches\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#ifndef RANDOMSOURCE_HPP
+#define RANDOMSOURCE_HPP
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include "frontend/tokenbuffer.hpp"
+
+namespace tisp::tests
+{
+    /// @brief Reserved words and operators, so the generated text hits the keyword and operator paths too.
+    inline constexpr std::array<std::string_view, 28> sample_words {
+        "var", "const", "defun", "match", "case", "return", "while", "generic", "use", "default",
+        "Boolean", "Integer", "Double", "String", "Seq", "Nil", "true", "false",
+        "=>", "->", "==", "!=", "&&", "||", "$", "@", "::", "!!"
+    };
+
+    /// @brief Bytes around the edges of every character class, e.g '@' and '[' next to the letters, and bytes past 0x7f.
+    inline constexpr std::string_view edge_bytes = "@[`{/:_.^~%\x7f\x80\xc1\xdf\xff";
+
+    /// @brief Appends one random lexeme or trivia run. Comment and string bodies can be long enough to cover several vector widths.
+    inline void appendRandomPiece(std::string& text, std::mt19937& rng)
+    {
+        constexpr std::string_view word_chars = "abcxyzABCXYZ_";
+        constexpr std::string_view number_chars = "0123456789.";
+        constexpr std::string_view single_chars = "()[]{},.+-*/<>=!&|$@:";
+        constexpr std::string_view space_chars = " \t\n\r";
+        constexpr std::string_view body_chars = "abc XYZ 019 \n\t.,$#\"\x80";
+
+        auto pick = [&rng](size_t count) {
+            return std::uniform_int_distribution<size_t> {0, count - 1}(rng);
+        };
+
+        switch (pick(10))
+        {
+            case 0:
+            case 1:
+            {
+                size_t length = 1 + pick((pick(8) == 0) ? 80 : 12);
+
+                for (size_t i = 0; i < length; i++)
+                    text += word_chars[pick(word_chars.length())];
+
+                break;
+            }
+            case 2:
+            {
+                size_t length = 1 + pick((pick(8) == 0) ? 60 : 8);
+
+                for (size_t i = 0; i < length; i++)
+                    text += number_chars[pick(number_chars.length())];
+
+                break;
+            }
+            case 3:
+                text += sample_words[pick(sample_words.size())];
+                break;
+            case 4:
+                text += single_chars[pick(single_chars.length())];
+                break;
+            case 5:
+            case 6:
+            {
+                size_t length = 1 + pick((pick(6) == 0) ? 100 : 4);
+
+                for (size_t i = 0; i < length; i++)
+                    text += space_chars[pick(space_chars.length())];
+
+                break;
+            }
+            case 7:
+            case 8:
+            {
+                char delim = (pick(2) == 0) ? '#' : '\"';
+                size_t length = pick((pick(6) == 0) ? 200 : 20);
+
+                text += delim;
+
+                for (size_t i = 0; i < length; i++)
+                {
+                    char c = body_chars[pick(body_chars.length())];
+
+                    text += (c == delim) ? ' ' : c;
+                }
+
+                text += delim;
+                break;
+            }
+            default:
+                text += edge_bytes[pick(edge_bytes.length())];
+                break;
+        }
+    }
+
+    /// @brief Makes at least length bytes of random source, sometimes ending inside an unclosed comment or string.
+    [[nodiscard]] inline std::string makeRandomSource(std::mt19937& rng, size_t length)
+    {
+        std::string text {};
+
+        text.reserve(length + 256);
+
+        while (text.length() < length)
+            appendRandomPiece(text, rng);
+
+        if (std::uniform_int_distribution<int> {0, 3}(rng) == 0)
+            text += "# unclosed";
+
+        return text;
+    }
+
+    /// @brief Compares two token buffers token by token and reports the first difference under name.
+    [[nodiscard]] inline bool sameTokens(std::string_view name, const frontend::TokenBuffer& expected, const frontend::TokenBuffer& actual)
+    {
+        if (expected.size() != actual.size())
+        {
+            std::cerr << name << ": " << actual.size() << " tokens, expected " << expected.size() << '\n';
+            return false;
+        }
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            frontend::Token want = expected.at(i);
+            frontend::Token got = actual.at(i);
+
+            if (want.begin != got.begin || want.length != got.length || want.type != got.type)
+            {
+                std::cerr << name << ": token " << i << " is (" << got.begin << ", " << got.length << ", " << static_cast<int>(got.type) << "), expected (" << want.begin << ", " << want.length << ", " << static_cast<int>(want.type) << ")\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+#endif
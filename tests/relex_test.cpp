@@ -0,0 +1,115 @@
+/**
+ * @file relex_test.cpp
+ * @author DrkWithT
+ * @brief Checks that relexSource keeps tokens equal to a full re-lex over long sequences of random edits.
+ * @date 2024-05-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include "frontend/lexer.hpp"
+#include "frontend/relexer.hpp"
+#include "randomsource.hpp"
+
+namespace tisp::tests
+{
+    /// @brief Text for one edit: nothing, a lone comment or string delimiter that flips everything after it, or a few random pieces.
+    static std::string makeInsertion(std::mt19937& rng)
+    {
+        std::string text {};
+
+        switch (std::uniform_int_distribution<int> {0, 5}(rng))
+        {
+            case 0:
+                break;
+            case 1:
+                text = "#";
+                break;
+            case 2:
+                text = "\"";
+                break;
+            default:
+            {
+                int piece_count = std::uniform_int_distribution<int> {1, 3}(rng);
+
+                for (int piece = 0; piece < piece_count; piece++)
+                    appendRandomPiece(text, rng);
+
+                break;
+            }
+        }
+
+        return text;
+    }
+
+    /**
+     * @brief Applies edit_count random edits to a random source, re-lexing incrementally after each one and comparing with a full re-lex.
+     * @note Half of the edits land near the previous one and the rest anywhere, so the token buffer's gap moves both a little and across the file between compact() calls.
+     */
+    static size_t countMismatches(std::mt19937& rng, frontend::TriviaMode mode, size_t edit_count)
+    {
+        frontend::Lexer lexer {};
+        std::string source = makeRandomSource(rng, 16 * 1024);
+        frontend::TokenBuffer tokens = lexer.tokenizeSource(source, mode);
+        size_t last_offset = 0;
+        size_t mismatches = 0;
+
+        for (size_t edit_pos = 0; edit_pos < edit_count; edit_pos++)
+        {
+            size_t offset;
+
+            if (std::uniform_int_distribution<int> {0, 1}(rng) == 0)
+                offset = std::uniform_int_distribution<size_t> {0, source.length()}(rng);
+            else
+                offset = std::min(source.length(), last_offset + std::uniform_int_distribution<size_t> {0, 64}(rng));
+
+            size_t removed_length = std::min(source.length() - offset, std::uniform_int_distribution<size_t> {0, 24}(rng));
+            std::string inserted = makeInsertion(rng);
+
+            source.replace(offset, removed_length, inserted);
+            frontend::relexSource(tokens, source, {.offset = offset, .removed_length = removed_length, .inserted_text = inserted}, mode);
+            last_offset = offset;
+
+            std::string name = "mode " + std::to_string(static_cast<int>(mode)) + ", edit " + std::to_string(edit_pos);
+
+            if (!sameTokens(name, lexer.tokenizeSource(source, mode), tokens))
+            {
+                mismatches++;
+                tokens = lexer.tokenizeSource(source, mode);
+            }
+
+            if (edit_pos % 23 == 22)
+            {
+                tokens.compact();
+
+                if (!sameTokens(name + " after compact", lexer.tokenizeSource(source, mode), tokens))
+                {
+                    mismatches++;
+                    tokens = lexer.tokenizeSource(source, mode);
+                }
+            }
+        }
+
+        return mismatches;
+    }
+}
+
+int main()
+{
+    using namespace tisp;
+
+    constexpr size_t edit_count = 2000;
+
+    std::mt19937 rng {20240502};
+    size_t mismatches = tests::countMismatches(rng, frontend::TriviaMode::keep, edit_count)
+        + tests::countMismatches(rng, frontend::TriviaMode::skip, edit_count);
+
+    std::cout << "relex_test: " << 2 * edit_count << " edits, " << mismatches << " mismatches\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}
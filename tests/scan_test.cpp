@@ -0,0 +1,134 @@
+/**
+ * @file scan_test.cpp
+ * @author DrkWithT
+ * @brief Checks that the SSE2 and AVX2 scan kernels find the same run ends as the scalar kernel.
+ * @date 2024-05-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <array>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "frontend/lexer.hpp"
+#include "frontend/scanning.hpp"
+#include "randomsource.hpp"
+
+namespace tisp::tests
+{
+    using frontend::ScanKernel;
+
+    /// @brief Makes runs of one character class at a time, long and short, so every scan stops inside, at, and past a vector width.
+    static std::string makeRuns(std::mt19937& rng, size_t run_count)
+    {
+        constexpr std::array<std::string_view, 5> classes {" \t\n\r", "abcXYZ_", "0123456789.", "#\"", edge_bytes};
+        std::string text {};
+
+        for (size_t run = 0; run < run_count; run++)
+        {
+            std::string_view chars = classes[std::uniform_int_distribution<size_t> {0, classes.size() - 1}(rng)];
+            size_t length = std::uniform_int_distribution<size_t> {0, 80}(rng);
+
+            for (size_t i = 0; i < length; i++)
+                text += chars[std::uniform_int_distribution<size_t> {0, chars.length() - 1}(rng)];
+        }
+
+        return text;
+    }
+
+    /// @brief Runs every scan from every position of text, both to its end and to a nearer limit, with the current kernel.
+    static std::vector<size_t> scanAll(std::string_view text)
+    {
+        std::vector<size_t> ends {};
+
+        for (size_t pos = 0; pos <= text.length(); pos++)
+        {
+            for (size_t limit : {text.length(), std::min(text.length(), pos + 37)})
+            {
+                ends.push_back(frontend::scanWhitespace(text.data(), pos, limit));
+                ends.push_back(frontend::scanAlphabetic(text.data(), pos, limit));
+                ends.push_back(frontend::scanNumeric(text.data(), pos, limit));
+                ends.push_back(frontend::scanUntil(text.data(), pos, limit, '#'));
+                ends.push_back(frontend::scanUntil(text.data(), pos, limit, '\x80'));
+                ends.push_back(frontend::scanUntilEither(text.data(), pos, limit, '#', '\"'));
+            }
+        }
+
+        return ends;
+    }
+
+    /// @brief Counts the scans and lexed tokens that differ between kernel and the scalar kernel.
+    static size_t countMismatches(ScanKernel kernel, const std::vector<std::string>& buffers, const std::vector<std::string>& sources)
+    {
+        size_t mismatches = 0;
+
+        for (const auto& text : buffers)
+        {
+            frontend::useScanKernel(ScanKernel::scalar);
+            std::vector<size_t> expected = scanAll(text);
+
+            frontend::useScanKernel(kernel);
+
+            if (scanAll(text) != expected)
+            {
+                std::cerr << "kernel " << static_cast<int>(kernel) << " scans differ on a " << text.length() << " byte buffer\n";
+                mismatches++;
+            }
+        }
+
+        for (const auto& source : sources)
+        {
+            for (auto mode : {frontend::TriviaMode::keep, frontend::TriviaMode::skip})
+            {
+                frontend::Lexer lexer {};
+
+                frontend::useScanKernel(ScanKernel::scalar);
+                frontend::TokenBuffer expected = lexer.tokenizeSource(source, mode);
+
+                frontend::useScanKernel(kernel);
+
+                if (!sameTokens("kernel " + std::to_string(static_cast<int>(kernel)), expected, lexer.tokenizeSource(source, mode)))
+                    mismatches++;
+            }
+        }
+
+        return mismatches;
+    }
+}
+
+int main()
+{
+    using namespace tisp;
+
+    std::mt19937 rng {20240512};
+    std::vector<std::string> buffers {};
+    std::vector<std::string> sources {};
+
+    for (size_t i = 0; i < 300; i++)
+        buffers.push_back(tests::makeRuns(rng, 1 + i % 12));
+
+    for (size_t i = 0; i < 8; i++)
+        sources.push_back(tests::makeRandomSource(rng, 64 * 1024));
+
+    size_t kernel_count = 0;
+    size_t mismatches = 0;
+
+    for (auto kernel : {frontend::ScanKernel::sse2, frontend::ScanKernel::avx2})
+    {
+        if (kernel > frontend::bestScanKernel())
+            continue;
+
+        mismatches += tests::countMismatches(kernel, buffers, sources);
+        kernel_count++;
+    }
+
+    frontend::useScanKernel(frontend::bestScanKernel());
+
+    std::cout << "scan_test: " << kernel_count << " vector kernels, " << buffers.size() << " buffers, " << sources.size() << " sources, " << mismatches << " mismatches\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file seqkernels_test.cpp
+ * @author DrkWithT
+ * @brief Checks that the SSE2 and AVX2 Seq kernels give the scalar kernels' results, and the scalar kernels some known answers.
+ * @date 2024-05-21
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include "runtime/seqkernels.hpp"
+
+namespace tisp::tests
+{
+    using runtime::SeqArith;
+    using runtime::SeqCompare;
+    using runtime::SeqKernel;
+
+    constexpr int64_t max_integer = 0x0000'7fff'ffff'ffff;
+    constexpr int64_t min_integer = -max_integer - 1;
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+    /// @brief Integer and Double items of one length, with keep bytes and a one item operand to broadcast.
+    struct Case
+    {
+        std::vector<int64_t> integers;
+        std::vector<int64_t> other_integers;
+        std::vector<double> doubles;
+        std::vector<double> other_doubles;
+        std::vector<uint8_t> keep;
+    };
+
+    /// @brief Results of every kernel on one case, in a fixed order.
+    struct Results
+    {
+        std::vector<int64_t> integers;
+        std::vector<double> doubles;
+        std::vector<uint8_t> flags;
+    };
+
+    /// @brief Integers near zero, near the 48-bit limits so sums and products wrap, or anywhere in range.
+    static int64_t makeInteger(std::mt19937& rng)
+    {
+        switch (std::uniform_int_distribution<int> {0, 3}(rng))
+        {
+            case 0:
+                return std::uniform_int_distribution<int64_t> {-8, 8}(rng);
+            case 1:
+                return max_integer - std::uniform_int_distribution<int64_t> {0, 3}(rng);
+            case 2:
+                return min_integer + std::uniform_int_distribution<int64_t> {0, 3}(rng);
+            default:
+                return std::uniform_int_distribution<int64_t> {min_integer, max_integer}(rng);
+        }
+    }
+
+    /// @brief Doubles with NaNs and infinities mixed in at the given rate, or only NaNs when nan_rate is 1.
+    static double makeDouble(std::mt19937& rng, double nan_rate)
+    {
+        if (std::uniform_real_distribution<double> {0.0, 1.0}(rng) < nan_rate)
+            return nan;
+
+        switch (std::uniform_int_distribution<int> {0, 7}(rng))
+        {
+            case 0:
+                return std::numeric_limits<double>::infinity();
+            case 1:
+                return -std::numeric_limits<double>::infinity();
+            case 2:
+                return static_cast<double>(std::uniform_int_distribution<int> {-4, 4}(rng));
+            default:
+                return std::uniform_real_distribution<double> {-1e6, 1e6}(rng);
+        }
+    }
+
+    static Case makeCase(std::mt19937& rng, size_t length)
+    {
+        constexpr double nan_rates[] {0.0, 0.1, 0.5, 1.0};
+        double nan_rate = nan_rates[std::uniform_int_distribution<size_t> {0, 3}(rng)];
+        int keep_rate = std::uniform_int_distribution<int> {0, 5}(rng);
+        Case result {};
+
+        for (size_t i = 0; i < length; i++)
+        {
+            result.integers.push_back(makeInteger(rng));
+            result.other_integers.push_back(makeInteger(rng));
+            result.doubles.push_back(makeDouble(rng, nan_rate));
+            result.other_doubles.push_back(makeDouble(rng, nan_rate));
+
+            // The first pattern runs through all 16 masks of 4 keep bytes every 64 items. The others keep none, a quarter, half, three quarters, or all.
+            if (keep_rate == 0)
+                result.keep.push_back(static_cast<uint8_t>(((i / 4) % 16 >> (i % 4)) & 1));
+            else
+                result.keep.push_back(std::uniform_int_distribution<int> {1, 4}(rng) <= keep_rate - 1 ? 1 : 0);
+        }
+
+        return result;
+    }
+
+    /// @brief Runs every kernel on c with the current kernel choice.
+    static Results runAll(const Case& c)
+    {
+        const size_t length = c.integers.size();
+        std::vector<int64_t> integer_out(length);
+        std::vector<double> double_out(length);
+        std::vector<uint8_t> flag_out(length);
+        Results results {};
+
+        results.integers.push_back(runtime::sumIntegers(c.integers));
+        results.integers.push_back(runtime::dotIntegers(c.integers, c.other_integers));
+        results.doubles.push_back(runtime::sumDoubles(c.doubles));
+        results.doubles.push_back(runtime::dotDoubles(c.doubles, c.other_doubles));
+
+        if (length > 0)
+        {
+            results.integers.push_back(runtime::minIntegers(c.integers));
+            results.integers.push_back(runtime::maxIntegers(c.integers));
+            results.doubles.push_back(runtime::minDoubles(c.doubles));
+            results.doubles.push_back(runtime::maxDoubles(c.doubles));
+        }
+
+        for (bool broadcast : {false, true})
+        {
+            if (broadcast && length == 0)
+                continue;
+
+            std::span<const int64_t> integer_rhs = broadcast ? std::span<const int64_t> {c.other_integers}.first(1) : std::span<const int64_t> {c.other_integers};
+            std::span<const double> double_rhs = broadcast ? std::span<const double> {c.other_doubles}.first(1) : std::span<const double> {c.other_doubles};
+
+            for (auto op : {SeqArith::add, SeqArith::sub, SeqArith::mul})
+            {
+                runtime::mapIntegers(op, c.integers, integer_rhs, integer_out);
+                runtime::mapDoubles(op, c.doubles, double_rhs, double_out);
+                results.integers.insert(results.integers.end(), integer_out.begin(), integer_out.end());
+                results.doubles.insert(results.doubles.end(), double_out.begin(), double_out.end());
+            }
+
+            for (auto op : {SeqCompare::less, SeqCompare::greater, SeqCompare::equal})
+            {
+                runtime::compareIntegers(op, c.integers, integer_rhs, flag_out);
+                results.flags.insert(results.flags.end(), flag_out.begin(), flag_out.end());
+                runtime::compareDoubles(op, c.doubles, double_rhs, flag_out);
+                results.flags.insert(results.flags.end(), flag_out.begin(), flag_out.end());
+            }
+        }
+
+        size_t kept = runtime::filterIntegers(c.integers, c.keep, integer_out);
+
+        results.integers.push_back(static_cast<int64_t>(kept));
+        results.integers.insert(results.integers.end(), integer_out.begin(), integer_out.begin() + kept);
+
+        kept = runtime::filterDoubles(c.doubles, c.keep, double_out);
+        results.doubles.push_back(static_cast<double>(kept));
+        results.doubles.insert(results.doubles.end(), double_out.begin(), double_out.begin() + kept);
+
+        return results;
+    }
+
+    /// @brief Doubles match when both are NaN or their bits are equal, so 0.0 and -0.0 differ.
+    static bool sameDoubles(const std::vector<double>& expected, const std::vector<double>& actual)
+    {
+        if (expected.size() != actual.size())
+            return false;
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (std::isnan(expected[i]) != std::isnan(actual[i]))
+                return false;
+
+            if (!std::isnan(expected[i]) && std::bit_cast<uint64_t>(expected[i]) != std::bit_cast<uint64_t>(actual[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Checks a few results worked out by hand, with the current kernel choice.
+    static size_t countWrongAnswers(const std::string& name)
+    {
+        const std::vector<int64_t> limits {max_integer, 1, min_integer, -1, max_integer};
+        const std::vector<int64_t> twos(5, 2);
+        const std::vector<double> all_nan(7, nan);
+        const std::vector<double> some_nan {nan, 3.0, nan, -2.0, nan, 8.0, nan};
+        std::vector<int64_t> integer_out(5);
+        size_t wrong = 0;
+
+        auto check = [&name, &wrong](bool ok, const char* what) {
+            if (!ok)
+            {
+                std::cerr << name << ": " << what << '\n';
+                wrong++;
+            }
+        };
+
+        check(runtime::sumIntegers(limits) == max_integer - 1, "sum of the limits does not wrap at 48 bits");
+        check(runtime::dotIntegers(limits, twos) == -4, "dot product does not wrap at 48 bits");
+        check(runtime::minIntegers(limits) == min_integer && runtime::maxIntegers(limits) == max_integer, "wrong Integer extremes");
+        check(std::isnan(runtime::minDoubles(all_nan)) && std::isnan(runtime::maxDoubles(all_nan)), "extremes of only NaNs are not NaN");
+        check(runtime::minDoubles(some_nan) == -2.0 && runtime::maxDoubles(some_nan) == 8.0, "extremes do not skip NaNs");
+
+        runtime::mapIntegers(SeqArith::mul, limits, std::span<const int64_t> {twos}.first(1), integer_out);
+        check(integer_out == std::vector<int64_t> {-2, 2, 0, -2, -2}, "broadcast multiply does not wrap at 48 bits");
+
+        runtime::mapIntegers(SeqArith::add, limits, twos, integer_out);
+        check(integer_out == std::vector<int64_t> {min_integer + 1, 3, min_integer + 2, 1, min_integer + 1}, "add does not wrap at 48 bits");
+
+        return wrong;
+    }
+}
+
+int main()
+{
+    using namespace tisp;
+    using runtime::SeqKernel;
+
+    std::mt19937 rng {20240521};
+    std::vector<tests::Case> cases {};
+
+    // Lengths around every multiple of 4 up to 67 reach each tail length after full registers, and the longer ones run many blocks.
+    for (size_t length = 0; length < 68; length++)
+    {
+        for (size_t i = 0; i < 6; i++)
+            cases.push_back(tests::makeCase(rng, length));
+    }
+
+    for (size_t i = 0; i < 20; i++)
+        cases.push_back(tests::makeCase(rng, std::uniform_int_distribution<size_t> {1000, 5000}(rng)));
+
+    runtime::useSeqKernel(SeqKernel::scalar);
+
+    std::vector<tests::Results> expected {};
+    size_t mismatches = tests::countWrongAnswers("scalar");
+
+    for (const auto& c : cases)
+        expected.push_back(tests::runAll(c));
+
+    size_t kernel_count = 0;
+
+    for (auto kernel : {SeqKernel::sse2, SeqKernel::avx2})
+    {
+        if (!runtime::useSeqKernel(kernel))
+            continue;
+
+        std::string name = "kernel " + std::to_string(static_cast<int>(kernel));
+
+        mismatches += tests::countWrongAnswers(name);
+
+        for (size_t i = 0; i < cases.size(); i++)
+        {
+            tests::Results actual = tests::runAll(cases[i]);
+
+            if (actual.integers != expected[i].integers || actual.flags != expected[i].flags || !tests::sameDoubles(expected[i].doubles, actual.doubles))
+            {
+                std::cerr << name << " differs from the scalar kernel on " << cases[i].integers.size() << " items\n";
+                mismatches++;
+            }
+        }
+
+        kernel_count++;
+    }
+
+    runtime::useSeqKernel(runtime::bestSeqKernel());
+
+    std::cout << "seqkernels_test: " << kernel_count << " vector kernels, " << cases.size() << " cases, " << mismatches << " mismatches\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}